@@ -0,0 +1,284 @@
+// TMSTC* planner benchmark.
+// Sweeps maps, robot counts and spanning tree shapes and prints one CSV row per run,
+// so planner changes can be compared run against run (e.g. with a spreadsheet or pandas).
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <cstdio>
+#include <sys/resource.h>
+
+#include "TMSTCStar.h"
+
+// Load a map in the "rows cols" + 0/1 lines format used by example_map.txt and downsampled_grid.txt
+static Mat loadMapFromFile(const std::string &filename)
+{
+    std::ifstream infile(filename);
+    if (!infile.is_open())
+        return {};
+
+    int h, w;
+    if (!(infile >> h >> w) || h <= 0 || w <= 0)
+        return {};
+
+    Mat map(h, std::vector<int>(w, 0));
+
+    std::string line;
+    std::getline(infile, line);
+
+    for (int i = 0; i < h && std::getline(infile, line); ++i)
+    {
+        int len = 0;
+        for (size_t j = 0; j < line.length() && len < w; ++j)
+        {
+            if (line[j] == '0' || line[j] == '1')
+                map[i][len++] = line[j] - '0';
+        }
+    }
+
+    return map;
+}
+
+// "random:<rows>x<cols>:<obstacle percent>", obstacles are dropped uniformly
+static Mat randomMap(const std::string &spec, std::mt19937 &rng)
+{
+    int rows = 0, cols = 0;
+    double obstacle_pct = 5.0;
+    if (std::sscanf(spec.c_str(), "random:%dx%d:%lf", &rows, &cols, &obstacle_pct) < 2 || rows <= 0 || cols <= 0)
+        return {};
+
+    Mat map(rows, std::vector<int>(cols, 1));
+    std::bernoulli_distribution obstacle(obstacle_pct / 100.0);
+    for (auto &row : map)
+        for (auto &cell : row)
+            cell = obstacle(rng) ? 0 : 1;
+    return map;
+}
+
+// Free cells of the largest 4-connected free area. Robots are placed there, since
+// eliminateIslands() drops every area the first robot cannot reach.
+static std::vector<std::pair<int, int>> largestFreeArea(const Mat &map)
+{
+    int rows = map.size(), cols = map[0].size();
+    std::vector<int> label(rows * cols, -1);
+    std::vector<std::pair<int, int>> best, area;
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {1, -1, 0, 0};
+
+    for (int start = 0; start < rows * cols; ++start)
+    {
+        if (!map[start / cols][start % cols] || label[start] >= 0)
+            continue;
+
+        area.clear();
+        std::vector<int> stack = {start};
+        label[start] = start;
+        while (!stack.empty())
+        {
+            int cur = stack.back();
+            stack.pop_back();
+            int x = cur % cols, y = cur / cols;
+            area.push_back({x, y});
+            for (int k = 0; k < 4; ++k)
+            {
+                int nx = x + dx[k], ny = y + dy[k];
+                if (nx < 0 || ny < 0 || nx >= cols || ny >= rows || !map[ny][nx] || label[ny * cols + nx] >= 0)
+                    continue;
+                label[ny * cols + nx] = start;
+                stack.push_back(ny * cols + nx);
+            }
+        }
+        if (area.size() > best.size())
+            best.swap(area);
+    }
+
+    std::sort(best.begin(), best.end(), [](const std::pair<int, int> &a, const std::pair<int, int> &b)
+              { return std::make_pair(a.second, a.first) < std::make_pair(b.second, b.first); });
+    return best;
+}
+
+static std::vector<std::string> split(const std::string &s, char sep)
+{
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep))
+        if (!item.empty())
+            out.push_back(item);
+    return out;
+}
+
+// Reset the peak resident set size so each run reports its own peak (Linux only)
+static void resetPeakRSS()
+{
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (clear_refs)
+        clear_refs << "5";
+}
+
+// Peak resident set size in kB since the last reset, falls back to the process lifetime peak
+static long peakRSSkB()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.rfind("VmHWM:", 0) == 0)
+            return std::stol(line.substr(6));
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Discards the library's console output while a run is timed
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+};
+
+int main(int argc, char **argv)
+{
+    std::string maps_arg = "example_map.txt,downsampled_grid.txt,random:40x40:5,random:80x80:5";
+    std::string robots_arg = "1,2,4,8";
+    std::string shapes_arg;
+    int repeat = 1;
+    unsigned int seed = 1;
+    bool return_to_start = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--maps" && i + 1 < argc)
+            maps_arg = argv[++i];
+        else if (arg == "--robots" && i + 1 < argc)
+            robots_arg = argv[++i];
+        else if (arg == "--shapes" && i + 1 < argc)
+            shapes_arg = argv[++i];
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = std::stoul(argv[++i]);
+        else if (arg == "--return")
+            return_to_start = true;
+        else if (arg == "--verbose")
+            verbose = true;
+        else if (arg == "--help")
+        {
+            std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
+            std::cout << "Options:" << std::endl;
+            std::cout << "  --maps LIST      Comma separated map files and/or random:<rows>x<cols>:<obstacle %>" << std::endl;
+            std::cout << "                   (default: example_map.txt,downsampled_grid.txt,random:40x40:5,random:80x80:5)" << std::endl;
+            std::cout << "  --robots LIST    Comma separated robot counts (default: 1,2,4,8)" << std::endl;
+            std::cout << "  --shapes LIST    Comma separated MST shapes (default: every portfolio shape)" << std::endl;
+            std::cout << "  --repeat N       Runs per configuration (default: 1)" << std::endl;
+            std::cout << "  --seed N         Seed for random maps, robot placement and ACO (default: 1)" << std::endl;
+            std::cout << "  --return         Return to start position after coverage" << std::endl;
+            std::cout << "  --verbose        Keep the planner's console output (goes to stderr)" << std::endl;
+            std::cout << "  --help           Display this help message" << std::endl;
+            std::cout << "Prints one CSV row per run on stdout, times in seconds, peak RSS in kB." << std::endl;
+            return 0;
+        }
+    }
+
+    std::vector<std::string> shapes = shapes_arg.empty() ? TMSTCStar::PORTFOLIO_SHAPES : split(shapes_arg, ',');
+    std::vector<int> robot_counts;
+    for (const auto &r : split(robots_arg, ','))
+        robot_counts.push_back(std::stoi(r));
+
+    // CSV goes through a private stream on the real stdout, the planner's own output is dropped
+    std::ostream csv(std::cout.rdbuf());
+    NullBuffer null_buffer;
+    std::streambuf *planner_out = verbose ? std::cerr.rdbuf() : &null_buffer;
+
+    csv << "map,rows,cols,free_cells,robots,shape,run,status,total_s,mst_build_s,mst2path_s,filtering_s,"
+           "depot_fields_s,mstc_star_s,generate_s,nodes_expanded,balancing_iterations,balanced_cut_evaluations,"
+           "peak_rss_kb,length,turns,max_cost,total_cost"
+        << std::endl;
+
+    std::mt19937 rng(seed);
+    for (const auto &map_spec : split(maps_arg, ','))
+    {
+        Mat map = map_spec.rfind("random:", 0) == 0 ? randomMap(map_spec, rng) : loadMapFromFile(map_spec);
+        if (map.empty())
+        {
+            std::cerr << "Skipping map " << map_spec << ": could not be loaded" << std::endl;
+            continue;
+        }
+
+        std::vector<std::pair<int, int>> free_cells = largestFreeArea(map);
+
+        for (int robots : robot_counts)
+        {
+            if (robots <= 0 || robots > (int)free_cells.size())
+                continue;
+
+            // Same robot placement for every shape, so the shapes are compared on equal terms
+            std::vector<std::pair<int, int>> robot_positions;
+            std::sample(free_cells.begin(), free_cells.end(), std::back_inserter(robot_positions), robots, rng);
+
+            for (const auto &shape : shapes)
+            {
+                for (int run = 0; run < repeat; ++run)
+                {
+                    TMSTCStarConfig config;
+                    config.mst_shape = shape;
+                    config.robot_num = robots;
+                    config.cover_and_return = return_to_start;
+                    config.aco_seed = seed;
+                    // Quiet runs skip formatting the planner's trace, not just printing it
+                    config.verbosity = verbose ? Verbosity::SUMMARY : Verbosity::QUIET;
+
+                    std::string status = "ok";
+                    TMSTCStar::PathStats stats;
+                    PlanReport report;
+
+                    resetPeakRSS();
+                    std::streambuf *saved = std::cout.rdbuf(planner_out);
+                    auto start = std::chrono::steady_clock::now();
+                    try
+                    {
+                        TMSTCStar tmstc(map, robot_positions, config);
+                        tmstc.eliminateIslands();
+                        tmstc.calculateRegionIndxPaths();
+                        report = tmstc.getPlanReport();
+                        stats = tmstc.getPathStatistics();
+                    }
+                    catch (const std::exception &e)
+                    {
+                        status = "error";
+                        std::cerr << "Run failed (" << map_spec << ", " << robots << " robots, " << shape << "): " << e.what() << std::endl;
+                    }
+                    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    std::cout.rdbuf(saved);
+                    long rss_kb = peakRSSkB();
+
+                    // Planner total excludes instance setup, fall back to the outer wall time when it was not set
+                    const PlanPhaseTimes &times = report.phases;
+                    double total_s = times.total_s > 0.0 ? times.total_s : wall_s;
+
+                    csv << map_spec << ',' << map.size() << ',' << map[0].size() << ',' << free_cells.size() << ','
+                        << robots << ',' << shape << ',' << run << ',' << status << ','
+                        << total_s << ',' << times.mst_build_s << ',' << times.cut.mst2path_s << ','
+                        << times.cut.filtering_s << ',' << times.cut.depot_fields_s << ','
+                        << times.cut.mstc_star_s << ',' << times.cut.generate_s << ','
+                        << report.counters.nodes_expanded << ',' << report.counters.balancing_iterations << ','
+                        << report.counters.balanced_cut_evaluations << ','
+                        << rss_kb << ',' << stats.total_length << ',' << stats.total_turns << ','
+                        << stats.max_path_length << ',' << stats.total_cost << std::endl;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
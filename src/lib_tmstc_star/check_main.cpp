@@ -0,0 +1,240 @@
+// TMSTC* differential check.
+// Runs the optimized kernels against the straightforward code they replaced on random inputs and
+// exits with 1 on the first difference, so the "identical output" claims of those changes can be rerun:
+//   - Division::maximumSubRectDivision() (incremental rows) against findMaximumSubRect() until the map is empty
+//   - evaluatePathCost() and computePathCost() (tabulated turn angles) against segmentAngle() per turn
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "PathCut.h"
+#include "MaximumSubRectDivision.h"
+#include "GeomUtils.h"
+
+// RECT_DIV decomposition as it was before the incremental engine: rescan the whole map for every rectangle
+static vector<rect> referenceSubRectDivision(Division &division, Mat &map)
+{
+    vector<rect> ret;
+    int numVertex = 0;
+    for (const auto &row : map)
+        for (int cell : row)
+            numVertex += cell ? 1 : 0;
+
+    while (numVertex)
+    {
+        vector<rect> tmp = division.findMaximumSubRect(map);
+        for (auto &r : tmp)
+        {
+            numVertex -= r.height * r.width;
+
+            if (r.height > r.width)
+                r.dir = VERTICAL;
+            else if (r.height < r.width)
+                r.dir = HORIZONTAL;
+            else
+                r.dir = BOTH_ORI;
+
+            for (int row = r.corner.first; row < r.corner.first + r.height; ++row)
+                for (int col = r.corner.second; col < r.corner.second + r.width; ++col)
+                    map[row][col] = 0;
+
+            ret.push_back(r);
+        }
+    }
+    return ret;
+}
+
+// Random free cells with a few rectangular obstacles, like ignored regions on a search grid
+static Mat randomMap(std::mt19937 &rng)
+{
+    std::uniform_int_distribution<int> size(1, 40);
+    int rows = size(rng), cols = size(rng);
+    std::bernoulli_distribution obstacle(std::uniform_real_distribution<double>(0.0, 0.4)(rng));
+
+    Mat map(rows, vector<int>(cols));
+    for (auto &row : map)
+        for (auto &cell : row)
+            cell = obstacle(rng) ? 0 : 1;
+
+    int blocks = std::uniform_int_distribution<int>(0, 4)(rng);
+    for (int b = 0; b < blocks; ++b)
+    {
+        int r0 = rng() % rows, c0 = rng() % cols;
+        int r1 = std::min(rows, r0 + 1 + (int)(rng() % 10)), c1 = std::min(cols, c0 + 1 + (int)(rng() % 10));
+        for (int r = r0; r < r1; ++r)
+            for (int c = c0; c < c1; ++c)
+                map[r][c] = 0;
+    }
+    return map;
+}
+
+static bool sameRect(const rect &a, const rect &b)
+{
+    return a.corner == b.corner && a.height == b.height && a.width == b.width && a.dir == b.dir;
+}
+
+static bool checkSubRectDivision(int maps, std::mt19937 &rng)
+{
+    for (int m = 0; m < maps; ++m)
+    {
+        Mat map = randomMap(rng);
+        Mat refMap = map;
+        BitGrid grid(map), newMap(map);
+        Division division(grid.view());
+
+        vector<rect> expected = referenceSubRectDivision(division, refMap);
+        vector<rect> actual = division.maximumSubRectDivision(newMap);
+
+        bool same = expected.size() == actual.size();
+        for (size_t k = 0; same && k < expected.size(); ++k)
+            same = sameRect(expected[k], actual[k]);
+        if (!same)
+        {
+            std::cerr << "RECT_DIV: map " << m << " (" << map.size() << "x" << map[0].size() << ") gives "
+                      << actual.size() << " rectangles, findMaximumSubRect() " << expected.size() << std::endl;
+            return false;
+        }
+    }
+    std::cout << "RECT_DIV: " << maps << " maps identical" << std::endl;
+    return true;
+}
+
+// Random walk on a mapCols wide grid, mostly unit steps, some of up to three cells to leave the angle table
+static std::vector<int> randomPath(int mapCols, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<int> length(0, 300);
+    std::uniform_int_distribution<int> unitStep(-1, 1), longStep(-3, 3);
+    std::bernoulli_distribution straight(0.6), longJump(0.1);
+
+    int n = length(rng);
+    std::vector<int> path;
+    int x = mapCols / 2, y = mapCols / 2, dx = 1, dy = 0;
+    for (int k = 0; k < n; ++k)
+    {
+        path.push_back(y * mapCols + x);
+        if (!straight(rng))
+        {
+            auto &step = longJump(rng) ? longStep : unitStep;
+            do
+            {
+                dx = step(rng);
+                dy = step(rng);
+            } while (dx == 0 && dy == 0);
+        }
+        // Stay inside the grid so the index arithmetic keeps the columns apart
+        if (x + dx < 0 || x + dx >= mapCols)
+            dx = -dx;
+        if (y + dy < 0)
+            dy = -dy;
+        x += dx;
+        y += dy;
+    }
+    return path;
+}
+
+// computePathCost() as a plain loop: segmentAngle() at every turn, travel and turns summed in path order
+static double referencePathCost(const std::vector<int> &path, const VehicleParameters &vp, int mapCols,
+                                PathCostBreakdown &terms)
+{
+    terms = PathCostBreakdown();
+    if (path.size() < 2)
+        return 0.0;
+
+    terms.turn_flags.assign(path.size(), 0);
+    terms.turn_angles.assign(path.size(), 0.0);
+    return withCostModel(vp, [&](const auto &model)
+                         {
+        for (size_t j = 0; j + 1 < path.size(); ++j)
+        {
+            double dx = (path[j] / mapCols - path[j + 1] / mapCols) * vp.cellSize_m;
+            double dy = (path[j] % mapCols - path[j + 1] % mapCols) * vp.cellSize_m;
+            terms.segment_times.push_back(model.segment(std::sqrt(dx * dx + dy * dy)));
+            terms.travel_time += terms.segment_times.back();
+
+            if (j + 2 < path.size() && !PathCut::isSameLine(path[j], path[j + 1], path[j + 2]))
+            {
+                int p0 = path[j], p1 = path[j + 1], p2 = path[j + 2];
+                double theta = std::abs(segmentAngle(p0 % mapCols, p0 / mapCols, p1 % mapCols, p1 / mapCols,
+                                                     p2 % mapCols, p2 / mapCols));
+                terms.turn_flags[j + 1] = 1;
+                terms.turn_angles[j + 1] = theta;
+                terms.turn_time += model.turn(theta);
+                terms.turns++;
+            }
+        }
+        terms.total = terms.travel_time + terms.turn_time;
+        return terms.total; });
+}
+
+static bool checkPathCost(int paths, std::mt19937 &rng)
+{
+    const CostModelType models[] = {CostModelType::FIXED_WING, CostModelType::MULTIROTOR, CostModelType::TURN_COUNT};
+    const int mapCols = 64;
+
+    for (int p = 0; p < paths; ++p)
+    {
+        std::vector<int> path = randomPath(mapCols, rng);
+        for (CostModelType model : models)
+        {
+            VehicleParameters vp;
+            vp.cost_model = model;
+            vp.cellSize_m = std::uniform_real_distribution<double>(1.0, 50.0)(rng);
+
+            PathCostBreakdown expected, actual;
+            double reference = referencePathCost(path, vp, mapCols, expected);
+            evaluatePathCost(path.data(), path.size(), vp, mapCols, actual);
+            double cost = computePathCost(path, vp, mapCols);
+
+            // Bit-identical, not within a tolerance
+            bool same = cost == reference && actual.total == expected.total && actual.turns == expected.turns &&
+                        actual.travel_time == expected.travel_time && actual.turn_time == expected.turn_time &&
+                        actual.segment_times == expected.segment_times;
+            if (path.size() >= 2)
+                same = same && actual.turn_flags == expected.turn_flags && actual.turn_angles == expected.turn_angles;
+            if (!same)
+            {
+                std::cerr.precision(17);
+                std::cerr << "PathCost: path " << p << " (" << path.size() << " cells, cost model " << (int)model
+                          << ") costs " << cost << ", evaluatePathCost() " << actual.total << ", reference " << reference << std::endl;
+                return false;
+            }
+        }
+    }
+    std::cout << "PathCost: " << paths << " paths identical under every cost model" << std::endl;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int maps = 3000;
+    int paths = 2000;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--maps" && i + 1 < argc)
+            maps = std::stoi(argv[++i]);
+        else if (arg == "--paths" && i + 1 < argc)
+            paths = std::stoi(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = std::stoul(argv[++i]);
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
+            std::cout << "Options:" << std::endl;
+            std::cout << "  --maps N    Random maps for the RECT_DIV decomposition (default: 3000)" << std::endl;
+            std::cout << "  --paths N   Random paths for the path cost kernels (default: 2000)" << std::endl;
+            std::cout << "  --seed N    Seed of the random maps and paths (default: 1)" << std::endl;
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    bool ok = checkSubRectDivision(maps, rng);
+    ok = checkPathCost(paths, rng) && ok;
+    return ok ? 0 : 1;
+}
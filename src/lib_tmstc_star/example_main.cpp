@@ -101,7 +101,7 @@ int main(int argc, char **argv)
             std::cout << "Options:" << std::endl;
             std::cout << "  --map FILE       Map file to load (default: example_map.txt)" << std::endl;
             std::cout << "  --method METHOD  Allocation method: MSTC or MTSP (default: MSTC)" << std::endl;
-            std::cout << "  --shape SHAPE    MST shape: RECT_DIV, DFS_VERTICAL, DFS_HORIZONTAL, KRUSKAL, ACO_OPT, DINIC, HEURISTIC" << std::endl;
+            std::cout << "  --shape SHAPE    MST shape: RECT_DIV, DFS_VERTICAL, DFS_HORIZONTAL, KRUSKAL, ACO_OPT, DINIC, HEURISTIC, PORTFOLIO" << std::endl;
             std::cout << "  --robots N       Number of robots (default: 1)" << std::endl;
             std::cout << "  --return         Return to start position after coverage" << std::endl;
             std::cout << "  --no-color       Disable colored output" << std::endl;
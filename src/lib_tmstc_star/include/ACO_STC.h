@@ -4,6 +4,14 @@
 #include <stack>
 #include <unordered_map>
 #include <random>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "PlanReport.h"
+#include "Grid.h"
 
 using std::cout;
 using std::endl;
@@ -14,6 +22,63 @@ using std::vector;
 #define PHE 100.0
 typedef vector<vector<int>> Mat;
 
+// Counter-based random stream: every draw hashes (seed, iteration, ant, counter), so an ant's
+// choices do not depend on which thread builds it or in which order
+struct AntRng
+{
+	uint64_t key;
+	uint64_t counter = 0;
+
+	AntRng(uint64_t seed, uint64_t iter, uint64_t ant) : key(mix(seed ^ mix((iter << 32) ^ ant))) {}
+
+	static uint64_t mix(uint64_t z)
+	{
+		// splitmix64 finalizer
+		z += 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	// Uniform in [0, 1)
+	double uniform() { return (mix(key + counter++) >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+// Per-thread buffers reused by every ant the thread builds
+struct AntScratch
+{
+	MSTGrid MST;
+	vector<char> vis;
+	vector<int> path; // DFS stack
+	int cur_pos;
+
+	// Best ant built by this thread in the current iteration
+	int best_turns, best_ant;
+	MSTGrid best_MST;
+};
+
+// Threads kept for a whole ACO run. run(job) calls job(t) for t = 0 .. size() - 1, t = 0 on the caller,
+// and returns when every call is done, so the iterations do not pay for creating threads.
+class AntPool
+{
+public:
+	explicit AntPool(int threads);
+	~AntPool();
+	int size() const { return workers.size() + 1; }
+	void run(const std::function<void(int)> &job);
+
+private:
+	void loop(int t);
+
+	vector<std::thread> workers;
+	std::mutex mtx;
+	std::condition_variable start_cv, done_cv;
+	const std::function<void(int)> *job = nullptr;
+	uint64_t generation = 0;
+	int pending = 0;
+	bool quit = false;
+};
+
 class ACO_STC
 {
 	vector<vector<double>> pheromone; // start from 1
@@ -24,24 +89,29 @@ class ACO_STC
 	double pho; // pheromone coefficient
 	int max_iter;
 
-	Mat Map;
-	Mat cur_MST, best_MST, cur_iter_best_MST;
-	vector<bool> vis;
+	BitGridView Map; // Shared with the caller, read only
+	MSTGrid best_MST, cur_iter_best_MST;
 	int min_turn_so_far, min_turn_this_iter;
 	int row, col, cell_num;
 
 	vector<int> dir[4] = {{-1, 0}, {0, 1}, {1, 0}, {0, -1}};
 	vector<int> step;
 	vector<int> ant_init_pos;
-	std::stack<int> path;
-	int cur_pos, cur_turns;
+
+	uint64_t seed = 0;	  // Same seed, map and parameters give the same tree
+	int num_threads = 0;  // <= 0 uses std::thread::hardware_concurrency()
+	int cur_iter = 0;
+	vector<AntScratch> scratch;
+	AntPool *pool = nullptr; // Set for the duration of aco_stc_solver()
+
+	const std::atomic<bool> *stop_flag = nullptr; // Ends the iterations early when set
 
 public:
-	ACO_STC(double _alpha, double _beta, double _pheromone_init, double _pho, int _ant_num, int _max_iter, Mat &_Map, Mat _best_MST) : alpha(_alpha), beta(_beta), pheromone_init(_pheromone_init), pho(_pho), ant_num(_ant_num), max_iter(_max_iter), Map(_Map), best_MST(_best_MST)
+	ACO_STC(double _alpha, double _beta, double _pheromone_init, double _pho, int _ant_num, int _max_iter, BitGridView _Map, MSTGrid _best_MST) : alpha(_alpha), beta(_beta), pheromone_init(_pheromone_init), pho(_pho), ant_num(_ant_num), max_iter(_max_iter), Map(_Map), best_MST(_best_MST)
 	{
-		row = Map.size();
-		col = Map[0].size();
-		cout << "row and col " << row << " " << col << endl;
+		row = Map.rows();
+		col = Map.cols();
+		TMSTC_LOG(DETAIL, "row and col " << row << " " << col << endl);
 		cell_num = row * col;
 
 		pheromone.resize(cell_num, vector<double>(4, 1)); // non best MST edge, start with 0.1
@@ -51,38 +121,22 @@ public:
 
 		step = {-col, 1, col, -1};
 
-		// generate ants' initial position randomly
-		std::unordered_map<int, bool> used;
-		ant_init_pos.resize(ant_num);
-		std::random_device rd;	// non-deterministic generator
-		std::mt19937 gen(rd()); // to seed mersenne twister.
-		for (int i = 0; i < ant_num; ++i)
-		{
-			while (true)
-			{
-				int rnd = gen() % cell_num;
-				if (!used.count(rnd) && Map[rnd / col][rnd % col])
-				{
-					used[rnd] = true;
-					ant_init_pos[i] = rnd;
-					break;
-				}
-			}
-			// cout << ant_init_pos[i] << " ";
-		}
-		// cout << "\n";
-
 		min_turn_so_far = 1234567890;
 		min_turn_this_iter = 1234567890;
 	}
 
-	void reset();			   // update info for upcoming iteration
-	bool select_next();		   // expand a new node and return its index, return true when finish constructing
-	void construct_solution(); // find the best MST in this iteration among all these ants
-	void update_pheromone();   // use the number of best MST's turn to update
-	Mat aco_stc_solver();	   // wrapper
-	vector<int> is_valid(int dx, int dy);
-	int get_turns(Mat &MST);
+	void init_ant_pos();		// place ants on distinct free cells, derived from the seed
+	void reset();				// update info for upcoming iteration
+	bool select_next(AntScratch &s, AntRng &rng); // expand a new node, return true when finish constructing
+	void construct_ant(AntScratch &s, int ant);	  // build one ant's tree into s.MST
+	void construct_solution();	// find the best MST in this iteration among all these ants
+	void update_pheromone();	// use the number of best MST's turn to update
+	MSTGrid aco_stc_solver();	// wrapper
+	int is_valid(const AntScratch &s, int dx, int dy, int neighbor[4]);
+	int get_turns(const MSTGrid &MST);
 	void get_result_info();
 	void use_best_MST_phe();
+	void setStopFlag(const std::atomic<bool> *flag) { stop_flag = flag; }
+	void setSeed(uint64_t _seed) { seed = _seed; }
+	void setThreads(int threads) { num_threads = threads; }
 };
@@ -0,0 +1,17 @@
+#ifndef _ASSIGNMENT_H
+#define _ASSIGNMENT_H
+
+#include <vector>
+
+// Assignment of n rows (vehicles) to distinct columns (paths) of an n x m cost matrix, n <= m.
+// Both return the column of each row, or an empty vector when the matrix is empty or has more rows than columns.
+
+// Hungarian algorithm (shortest augmenting paths with potentials), O(n^2 m): minimum total cost
+std::vector<int> minCostAssignment(const std::vector<std::vector<double>> &cost);
+
+// Bottleneck assignment: the smallest achievable largest cost is found by binary search over the
+// distinct costs with a bipartite matching check, ties between matchings with that largest cost are
+// broken by minimum total cost. With cost = transit + path time, this minimizes the mission makespan.
+std::vector<int> minMakespanAssignment(const std::vector<std::vector<double>> &cost);
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef _COST_MODEL_H
+#define _COST_MODEL_H
+
+#include <cmath>
+
+const double gravity = 9.81; // m/s^2 (gravitational acceleration)
+
+// Vehicle dynamics used to turn a grid path into a cost (seconds, or cells for TURN_COUNT)
+enum class CostModelType : int
+{
+	FIXED_WING, // Constant speed, turns flown as banked arcs of radius vmax^2 / (g tan(phi_max))
+	MULTIROTOR, // Accelerates from and stops at every cell, every turn is a 90-degree turn at omega
+	TURN_COUNT	// One per cell plus turn_cells per turn, no vehicle dynamics
+};
+
+struct VehicleParameters
+{
+	double omega_rad = 1;					  // rad/s (angular velocity)
+	double acc = 1.5;						  // m/s^2 (acceleration)
+	double vmax = 15;						  // m/s (max velocity)
+	double phi_max_rad = 45 * (M_PI / 180.0); // rad (maximum banking angle)
+	double cellSize_m = 30;					  // meters (grid cell size)
+	CostModelType cost_model = CostModelType::FIXED_WING;
+	double turn_cells = 2.0; // TURN_COUNT: a turn costs as much as this many cells
+
+	bool operator==(const VehicleParameters &o) const
+	{
+		return omega_rad == o.omega_rad && acc == o.acc && vmax == o.vmax && phi_max_rad == o.phi_max_rad &&
+			   cellSize_m == o.cellSize_m && cost_model == o.cost_model && turn_cells == o.turn_cells;
+	}
+	bool operator!=(const VehicleParameters &o) const { return !(*this == o); }
+};
+
+// Cost model policies. The path cost loops (MST2Path, the depot distance fields, A_star, computePathCost)
+// are templates over one of these, so the per-segment and per-turn terms inline into the loop; the model
+// itself is picked at run time from VehicleParameters::cost_model by withCostModel().
+//
+// Each policy provides:
+//   segment(d)         time to travel d meters between two cells
+//   turn(angle_deg)    time of a turn by |angle_deg| degrees at a cell (angles in the units of turnAngle())
+//   lowerBound(d)      admissible A* heuristic for d meters of straight line
+//   USES_TURN_ANGLE    false when turn() ignores the angle, so callers skip computing it
+
+// Turn between two perpendicular grid steps, for loops that do not look at the actual angle
+constexpr double GRID_TURN_DEG = 90.0;
+
+struct FixedWingCost
+{
+	static constexpr bool USES_TURN_ANGLE = true;
+
+	explicit FixedWingCost(const VehicleParameters &vp)
+		: vmax(vp.vmax), turn_radius((vp.vmax * vp.vmax) / (gravity * std::tan(vp.phi_max_rad))) {}
+
+	double segment(double distance) const { return distance / vmax; }
+	// Arc of turn_radius through the turn, flown at vmax
+	double turn(double angle_deg) const { return (turn_radius * angle_deg * (M_PI / 180.0)) / vmax; }
+	double lowerBound(double distance) const { return distance / vmax; }
+
+	double vmax;
+	double turn_radius;
+};
+
+struct MultirotorCost
+{
+	static constexpr bool USES_TURN_ANGLE = false;
+
+	explicit MultirotorCost(const VehicleParameters &vp)
+		: vmax(vp.vmax), a(vp.acc), turn_time(M_PI / (2 * vp.omega_rad)) {}
+
+	// sqrt(4d/a) if vmax is never reached (d < vmax^2/a), else d/vmax + vmax/a
+	double segment(double distance) const
+	{
+		return (distance < (vmax * vmax) / a) ? std::sqrt(4 * distance / a) : (distance / vmax + vmax / a);
+	}
+	double turn(double) const { return turn_time; }
+	double lowerBound(double distance) const { return distance / vmax; }
+
+	double vmax;
+	double a;
+	double turn_time;
+};
+
+struct TurnCountCost
+{
+	static constexpr bool USES_TURN_ANGLE = false;
+
+	explicit TurnCountCost(const VehicleParameters &vp) : cell_size(vp.cellSize_m), turn_cells(vp.turn_cells) {}
+
+	double segment(double distance) const { return distance / cell_size; }
+	double turn(double) const { return turn_cells; }
+	double lowerBound(double distance) const { return distance / cell_size; }
+
+	double cell_size;
+	double turn_cells;
+};
+
+// Calls f with the policy selected by vp.cost_model, f is typically a generic lambda
+template <typename F>
+auto withCostModel(const VehicleParameters &vp, F &&f) -> decltype(f(FixedWingCost(vp)))
+{
+	switch (vp.cost_model)
+	{
+	case CostModelType::MULTIROTOR:
+		return f(MultirotorCost(vp));
+	case CostModelType::TURN_COUNT:
+		return f(TurnCountCost(vp));
+	case CostModelType::FIXED_WING:
+	default:
+		return f(FixedWingCost(vp));
+	}
+}
+
+#endif
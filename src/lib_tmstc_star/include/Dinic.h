@@ -8,6 +8,8 @@
 #include <unordered_set>
 #include <cstring>
 #include <map>
+#include "PlanReport.h"
+#include "Grid.h"
 
 using std::cout;
 using std::endl;
@@ -20,25 +22,27 @@ using std::vector;
 #define HORZ(i, j) (m * (i) + (j) + 1)
 #define VERT(i, j) ((n - 1) * m + n * (j) + (i) + 1)
 #define SINK ((n - 1) * m + n * (m - 1) + 1)
-#define RESHAPE(i, j) (int)((i) * Map[0].size() + (j))
+#define RESHAPE(i, j) (int)((i) * Map.cols() + (j))
 
 typedef vector<vector<int>> Mat;
 typedef pair<int, int> P;
-const int nmax = 1000000 + 10;
 const int INF = 0x3f3f3f3f;
 
+// Storage is sized to the map on every solve and kept afterwards, so an instance can be reused
+// across replans without reallocating. Separate instances can solve concurrently.
 class Dinic
 {
-    int head[nmax], cur[nmax], d[nmax];
-    bool vis[nmax], iscut[nmax];
+    vector<int> head, cur, d;
+    vector<char> vis, iscut;
     int tot, n, m, s, t;
-    bool pts[nmax];
+    vector<char> pts;
     vector<int> fa;
 
     struct edge
     {
         int nxt, to, w, cap, flow;
-    } e[nmax << 1];
+    };
+    vector<edge> e;
 
     struct Brick
     {
@@ -64,25 +68,27 @@ public:
     {
         this->n = n;
         this->tot = 0;
-        memset(head, -1, sizeof head);
-        memset(iscut, 0, sizeof iscut);
-        memset(pts, false, sizeof pts);
+        head.assign(n + 1, -1);
+        cur.assign(n + 1, -1);
+        d.assign(n + 1, 0);
+        vis.assign(n + 1, 0);
+        iscut.assign(n + 1, 0);
+        pts.assign(n + 1, 0);
+        e.clear();
     }
 
     void add_edge(int u, int v, int c)
     {
-        e[tot].to = v, e[tot].cap = c, e[tot].flow = 0;
-        e[tot].nxt = head[u];
+        e.push_back({head[u], v, 0, c, 0});
         head[u] = tot++;
 
-        e[tot].to = u, e[tot].cap = c, e[tot].flow = c;
-        e[tot].nxt = head[v];
+        e.push_back({head[v], u, 0, c, c});
         head[v] = tot++;
     }
 
     bool BFS()
     {
-        memset(vis, 0, sizeof(vis));
+        std::fill(vis.begin(), vis.end(), 0);
         queue<int> Q;
         vis[s] = 1;
         d[s] = 0;
@@ -152,25 +158,25 @@ public:
         return;
     }
 
-    P getEdgeCoor(int index, Mat &Map)
+    P getEdgeCoor(int index, BitGridView Map)
     {
-        int n = Map.size(), m = Map[0].size();
+        int n = Map.rows(), m = Map.cols();
         if (index <= (n - 1) * m)
             return {(index - 1) / m, (index - 1) % m};
         else
             return {(index - 1 - (n - 1) * m) % n, (index - 1 - (n - 1) * m) / n};
     }
 
-    Mat dinic_solver(Mat &Map, bool merge);
+    MSTGrid dinic_solver(BitGridView Map, bool merge);
 
-    void formBricksForMTSP(Mat &Map)
+    void formBricksForMTSP(BitGridView Map)
     {
         bricks.clear();
         int cnt = 0;
         std::map<int, int> label;
-        for (int i = 0; i < Map.size() * Map[0].size(); ++i)
+        for (int i = 0; i < Map.size(); ++i)
         {
-            if (!Map[i / Map[0].size()][i % Map[0].size()])
+            if (!Map.test(i))
                 continue;
 
             int parent = find(i);
@@ -187,14 +193,14 @@ public:
             }
         }
 
-        cout << "The number of bricks: " << bricks.size() << "\n";
+        TMSTC_LOG(DETAIL, "The number of bricks: " << bricks.size() << "\n");
         for (int i = 0; i < bricks.size(); ++i)
         {
             if (bricks[i].pts.size() == 1)
             {
                 // single cell
-                int x = bricks[i].pts[0] / Map[0].size();
-                int y = bricks[i].pts[0] % Map[0].size();
+                int x = bricks[i].pts[0] / Map.cols();
+                int y = bricks[i].pts[0] % Map.cols();
                 bricks[i].corner[0] = {2 * x, 2 * y};
                 bricks[i].corner[1] = {2 * x, 2 * y + 1};
                 bricks[i].corner[2] = {2 * x + 1, 2 * y};
@@ -204,10 +210,10 @@ public:
             {
                 sort(bricks[i].pts.begin(), bricks[i].pts.end());
                 // vertical or horizontal ?
-                int x1 = bricks[i].pts[0] / Map[0].size();
-                int x2 = bricks[i].pts.back() / Map[0].size();
-                int y1 = bricks[i].pts[0] % Map[0].size();
-                int y2 = bricks[i].pts.back() % Map[0].size();
+                int x1 = bricks[i].pts[0] / Map.cols();
+                int x2 = bricks[i].pts.back() / Map.cols();
+                int y1 = bricks[i].pts[0] % Map.cols();
+                int y2 = bricks[i].pts.back() % Map.cols();
                 if (x1 == x2)
                 {
                     // horizontal
@@ -234,40 +240,35 @@ public:
         }
     }
 
-    bool checkMST(Mat &graph, Mat &Map)
+    bool checkMST(const MSTGrid &graph, BitGridView Map)
     {
         int vertexNum = 0;
-        for (int i = 0; i < Map.size(); ++i)
-            for (int j = 0; j < Map[0].size(); ++j)
-                if (Map[i][j])
-                    vertexNum++;
+        for (int w = 0; w < Map.wordCount(); ++w)
+            vertexNum += __builtin_popcountll(Map.word(w));
 
-        int edgeNum = 0;
-        for (int i = 0; i < graph.size(); ++i)
-            edgeNum += graph[i].size();
-        edgeNum /= 2;
+        int edgeNum = graph.edgeCount();
 
-        cout << "The number of edges: " << edgeNum << endl;
-        cout << "The number of vertexes: " << vertexNum << endl;
+        TMSTC_LOG(DETAIL, "The number of edges: " << edgeNum << endl);
+        TMSTC_LOG(DETAIL, "The number of vertexes: " << vertexNum << endl);
         if (edgeNum != vertexNum - 1)
             return false;
         return true;
     }
 
-    void mergeMST(Mat &graph, Mat &Map)
+    void mergeMST(MSTGrid &graph, BitGridView Map)
     {
         vector<tree_edge> edges; // ˫���
         priority_queue<tree_edge> que;
-        for (int i = 0; i < Map.size(); ++i)
+        for (int i = 0; i < Map.rows(); ++i)
         {
-            for (int j = 0; j < Map[0].size(); ++j)
+            for (int j = 0; j < Map.cols(); ++j)
             {
-                if (j < Map[0].size() - 1)
-                    if (!same(RESHAPE(i, j), RESHAPE(i, j + 1)) && Map[i][j] && Map[i][j + 1])
+                if (j < Map.cols() - 1)
+                    if (!same(RESHAPE(i, j), RESHAPE(i, j + 1)) && Map.test(i, j) && Map.test(i, j + 1))
                         edges.push_back({RESHAPE(i, j), RESHAPE(i, j + 1), 0});
 
-                if (i < Map.size() - 1)
-                    if (!same(RESHAPE(i, j), RESHAPE(i + 1, j)) && Map[i][j] && Map[i + 1][j])
+                if (i < Map.rows() - 1)
+                    if (!same(RESHAPE(i, j), RESHAPE(i + 1, j)) && Map.test(i, j) && Map.test(i + 1, j))
                         edges.push_back({RESHAPE(i, j), RESHAPE(i + 1, j), 0});
             }
         }
@@ -302,8 +303,7 @@ public:
                 continue;
             }
 
-            graph[v1].push_back(v2);
-            graph[v2].push_back(v1);
+            graph.addEdge(v1, v2);
             unite(v1, v2);
         }
     }
@@ -333,35 +333,37 @@ public:
         return a + c == 2 * b;
     }
 
-    int getEdgeVal(Mat &graph, int v1, int v2)
+    int getEdgeVal(const MSTGrid &graph, int v1, int v2)
     {
+        int n1[4], n2[4];
+        int d1 = graph.neighbours(v1, n1), d2 = graph.neighbours(v2, n2);
         int cost = 0;
-        if (graph[v1].size() == 1)
+        if (d1 == 1)
         {
-            if (isSameLine(graph[v1][0], v1, v2))
+            if (isSameLine(n1[0], v1, v2))
                 cost -= 2;
         }
-        else if (graph[v1].size() == 2)
+        else if (d1 == 2)
         {
-            if (isSameLine(graph[v1][0], v1, graph[v1][1]))
+            if (isSameLine(n1[0], v1, n1[1]))
                 cost += 2;
         }
-        else if (graph[v1].size() == 3)
+        else if (d1 == 3)
         {
             cost += 2;
         }
 
-        if (graph[v2].size() == 1)
+        if (d2 == 1)
         {
-            if (isSameLine(v1, v2, graph[v2][0]))
+            if (isSameLine(v1, v2, n2[0]))
                 cost -= 2;
         }
-        else if (graph[v2].size() == 2)
+        else if (d2 == 2)
         {
-            if (isSameLine(graph[v2][0], v2, graph[v2][1]))
+            if (isSameLine(n2[0], v2, n2[1]))
                 cost += 2;
         }
-        else if (graph[v1].size() == 3)
+        else if (d1 == 3)
         {
             cost += 2;
         }
@@ -369,17 +371,19 @@ public:
         return cost;
     }
 
-    int getVertexVal(Mat &graph, int v)
+    int getVertexVal(const MSTGrid &graph, int v)
     {
-        if (graph[v].size() == 0)
+        int nb[4];
+        int degree = graph.neighbours(v, nb);
+        if (degree == 0)
             return 0;
-        else if (graph[v].size() == 1)
+        else if (degree == 1)
             return 2;
-        else if (graph[v].size() == 2)
+        else if (degree == 2)
         {
-            return isSameLine(graph[v][0], v, graph[v][1]) ? 0 : 2;
+            return isSameLine(nb[0], v, nb[1]) ? 0 : 2;
         }
-        else if (graph[v].size() == 3)
+        else if (degree == 3)
             return 2;
         else
             return 4;
@@ -387,6 +391,4 @@ public:
 
 };
 
-extern Dinic dinic;
-
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef _DUBINS_SMOOTHING_H
+#define _DUBINS_SMOOTHING_H
+
+#include <vector>
+#include <utility>
+
+#include "CostModel.h"
+
+// Post-processing of a grid coverage path into a track a fixed-wing vehicle can fly.
+// The grid path turns 90 degrees in place; a vehicle with minimum turn radius
+// R = vmax^2 / (g tan(phi_max_rad)) overshoots those corners and re-covers ground. Each corner is flown as:
+//   - a fillet: an arc of radius R inside the corner, when both legs are long enough and the corner
+//     cell stays within the sensor radius of the arc,
+//   - a turnaround: two corners between adjacent lanes (closer than 2R, or one cell apart) merged into
+//     one shortest Dubins path from the end of one lane to the start of the next,
+//   - a loop: otherwise, a shortest Dubins path from the corner back to the corner on the new heading.
+// The track passes through every lane end, and the coverage of the grid cells is checked afterwards.
+
+struct SmoothedPath
+{
+	std::vector<std::pair<double, double>> waypoints; // Region grid coordinates (col, row), fractional along arcs
+	double length_m = 0.0;
+	double flight_time_s = 0.0; // length_m flown at vmax
+
+	int fillets = 0;
+	int turnarounds = 0;
+	int loops = 0;
+
+	int cells = 0;		   // Distinct cells of the grid path
+	int covered_cells = 0; // Cells whose center the track passes within the sensor radius
+};
+
+// path: region grid indices (index = row * cols + col), as in TMSTCStar::getPaths().
+// sensor_radius_m <= 0 uses half a cell. Arcs are written as waypoints every arc_step_rad.
+SmoothedPath smoothPathDubins(const std::vector<int> &path, int cols, const VehicleParameters &vp,
+							  double sensor_radius_m = 0.0, double arc_step_rad = M_PI / 12);
+
+// Length of the shortest Dubins path between two poses (heading in rad from the +col axis towards +row)
+double dubinsDistance(double x0, double y0, double heading0, double x1, double y1, double heading1, double turn_radius);
+
+#endif
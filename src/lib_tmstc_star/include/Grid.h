@@ -0,0 +1,250 @@
+#ifndef _GRID_H
+#define _GRID_H
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+// Flat row-major grid containers shared by the solvers.
+// Occupancy is a packed bitset (1 = free), spanning trees are 4-neighbour bitmasks per cell.
+// The *View types are non-owning and cheap to copy, so several solvers (or threads) can
+// read the same grid without deep copies.
+
+class BitGridView
+{
+public:
+	BitGridView() = default;
+	BitGridView(const uint64_t *words, int rows, int cols) : words_(words), rows_(rows), cols_(cols) {}
+
+	int rows() const { return rows_; }
+	int cols() const { return cols_; }
+	int size() const { return rows_ * cols_; }
+
+	bool test(int idx) const { return (words_[idx >> 6] >> (idx & 63)) & 1ULL; }
+	bool test(int r, int c) const { return test(r * cols_ + c); }
+
+	// Bounds-checked lookup, out-of-grid cells count as blocked
+	bool free(int r, int c) const { return r >= 0 && r < rows_ && c >= 0 && c < cols_ && test(r, c); }
+
+	int wordCount() const { return (size() + 63) / 64; }
+	uint64_t word(int w) const { return words_[w]; }
+
+	// True if any cell is set in both grids (same dimensions expected)
+	bool intersects(const BitGridView &other) const
+	{
+		for (int w = 0; w < wordCount() && w < other.wordCount(); ++w)
+			if (word(w) & other.word(w))
+				return true;
+		return false;
+	}
+
+private:
+	const uint64_t *words_ = nullptr;
+	int rows_ = 0, cols_ = 0;
+};
+
+class BitGrid
+{
+public:
+	BitGrid() = default;
+	BitGrid(int rows, int cols) : rows_(rows), cols_(cols), words_((rows * cols + 63) / 64, 0) {}
+
+	// Own a copy of a view, e.g. as scratch a solver may clear cells of
+	explicit BitGrid(const BitGridView &view)
+		: rows_(view.rows()), cols_(view.cols()), words_(view.wordCount())
+	{
+		for (int w = 0; w < view.wordCount(); ++w)
+			words_[w] = view.word(w);
+	}
+
+	// Pack a 0/1 matrix
+	explicit BitGrid(const std::vector<std::vector<int>> &mat)
+		: BitGrid(mat.size(), mat.empty() ? 0 : mat[0].size())
+	{
+		for (int r = 0; r < rows_; ++r)
+			for (int c = 0; c < cols_; ++c)
+				if (mat[r][c])
+					set(r * cols_ + c);
+	}
+
+	int rows() const { return rows_; }
+	int cols() const { return cols_; }
+	int size() const { return rows_ * cols_; }
+
+	bool test(int idx) const { return (words_[idx >> 6] >> (idx & 63)) & 1ULL; }
+	bool test(int r, int c) const { return test(r * cols_ + c); }
+	void set(int idx) { words_[idx >> 6] |= 1ULL << (idx & 63); }
+	void reset(int idx) { words_[idx >> 6] &= ~(1ULL << (idx & 63)); }
+	void reset(int r, int c) { reset(r * cols_ + c); }
+
+	// Number of set cells
+	int count() const
+	{
+		int n = 0;
+		for (uint64_t w : words_)
+			n += __builtin_popcountll(w);
+		return n;
+	}
+
+	const std::vector<uint64_t> &words() const { return words_; }
+	BitGridView view() const { return BitGridView(words_.data(), rows_, cols_); }
+
+	std::vector<std::vector<int>> toMat() const
+	{
+		std::vector<std::vector<int>> mat(rows_, std::vector<int>(cols_, 0));
+		for (int r = 0; r < rows_; ++r)
+			for (int c = 0; c < cols_; ++c)
+				mat[r][c] = test(r, c);
+		return mat;
+	}
+
+private:
+	int rows_ = 0, cols_ = 0;
+	std::vector<uint64_t> words_;
+};
+
+// Edge bits of a spanning-tree cell
+enum MSTEdge : uint8_t
+{
+	MST_RIGHT = 1,
+	MST_LEFT = 2,
+	MST_DOWN = 4,
+	MST_UP = 8
+};
+
+class MSTGridView
+{
+public:
+	MSTGridView() = default;
+	MSTGridView(const uint8_t *mask, int rows, int cols) : mask_(mask), rows_(rows), cols_(cols) {}
+
+	int rows() const { return rows_; }
+	int cols() const { return cols_; }
+	int size() const { return rows_ * cols_; }
+
+	uint8_t edges(int idx) const { return mask_[idx]; }
+	bool hasEdge(int idx, MSTEdge e) const { return mask_[idx] & e; }
+
+private:
+	const uint8_t *mask_ = nullptr;
+	int rows_ = 0, cols_ = 0;
+};
+
+class MSTGrid
+{
+public:
+	MSTGrid() = default;
+	MSTGrid(int rows, int cols) : rows_(rows), cols_(cols), mask_(rows * cols, 0) {}
+
+	// Convert an adjacency list indexed by cell (as returned by the tree solvers).
+	// Edges are stored on both ends, so one-sided lists come out symmetric.
+	MSTGrid(const std::vector<std::vector<int>> &adjacency, int rows, int cols) : MSTGrid(rows, cols)
+	{
+		for (int from = 0; from < (int)adjacency.size() && from < size(); ++from)
+			for (int to : adjacency[from])
+				addEdge(from, to);
+	}
+
+	int rows() const { return rows_; }
+	int cols() const { return cols_; }
+	int size() const { return rows_ * cols_; }
+
+	bool empty() const { return mask_.empty(); }
+
+	uint8_t edges(int idx) const { return mask_[idx]; }
+	bool hasEdge(int idx, MSTEdge e) const { return mask_[idx] & e; }
+
+	// Number of tree edges at a cell
+	int degree(int idx) const { return __builtin_popcount(mask_[idx]); }
+
+	// Tree neighbours of a cell in the order of toAdjacency(), returns their number
+	int neighbours(int idx, int out[4]) const
+	{
+		int n = 0;
+		if (mask_[idx] & MST_RIGHT)
+			out[n++] = idx + 1;
+		if (mask_[idx] & MST_LEFT)
+			out[n++] = idx - 1;
+		if (mask_[idx] & MST_DOWN)
+			out[n++] = idx + cols_;
+		if (mask_[idx] & MST_UP)
+			out[n++] = idx - cols_;
+		return n;
+	}
+
+	// Edges in total, each counted once
+	int edgeCount() const
+	{
+		int n = 0;
+		for (uint8_t m : mask_)
+			n += __builtin_popcount(m);
+		return n / 2;
+	}
+
+	// Only 4-neighbour edges can be represented, anything else is ignored
+	void addEdge(int a, int b)
+	{
+		if (a > b)
+			std::swap(a, b);
+		if (b >= size())
+			return;
+
+		if (b == a + 1 && b % cols_ != 0)
+		{
+			mask_[a] |= MST_RIGHT;
+			mask_[b] |= MST_LEFT;
+		}
+		else if (b == a + cols_)
+		{
+			mask_[a] |= MST_DOWN;
+			mask_[b] |= MST_UP;
+		}
+	}
+
+	// Remove every edge of a cell, on both ends
+	void removeCell(int idx)
+	{
+		if (mask_[idx] & MST_RIGHT)
+			mask_[idx + 1] &= ~MST_LEFT;
+		if (mask_[idx] & MST_LEFT)
+			mask_[idx - 1] &= ~MST_RIGHT;
+		if (mask_[idx] & MST_DOWN)
+			mask_[idx + cols_] &= ~MST_UP;
+		if (mask_[idx] & MST_UP)
+			mask_[idx - cols_] &= ~MST_DOWN;
+		mask_[idx] = 0;
+	}
+
+	// Drop every edge, keeping the storage
+	void clear() { std::fill(mask_.begin(), mask_.end(), 0); }
+
+	// Raw edge masks, one byte per cell (e.g. for PlanCache)
+	uint8_t *data() { return mask_.data(); }
+	const uint8_t *data() const { return mask_.data(); }
+
+	MSTGridView view() const { return MSTGridView(mask_.data(), rows_, cols_); }
+
+	std::vector<std::vector<int>> toAdjacency() const
+	{
+		std::vector<std::vector<int>> adjacency(size());
+		for (int idx = 0; idx < size(); ++idx)
+		{
+			if (mask_[idx] & MST_RIGHT)
+				adjacency[idx].push_back(idx + 1);
+			if (mask_[idx] & MST_LEFT)
+				adjacency[idx].push_back(idx - 1);
+			if (mask_[idx] & MST_DOWN)
+				adjacency[idx].push_back(idx + cols_);
+			if (mask_[idx] & MST_UP)
+				adjacency[idx].push_back(idx - cols_);
+		}
+		return adjacency;
+	}
+
+private:
+	int rows_ = 0, cols_ = 0;
+	std::vector<uint8_t> mask_;
+};
+
+#endif
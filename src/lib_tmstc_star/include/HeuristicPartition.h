@@ -11,6 +11,9 @@
 #include <set>
 #include <UnionFind.h>
 #include <random>
+#include <atomic>
+#include "PlanReport.h"
+#include "Grid.h"
 
 using std::cout;
 using std::endl;
@@ -25,7 +28,7 @@ namespace HeuristicSolver
 
 #define HORIZONTAL 0
 #define VERTICAL 1
-#define RESHAPE(i, j) (int)((i) * Map[0].size() + (j))
+#define RESHAPE(i, j) (int)((i) * Map.cols() + (j))
 
 	typedef vector<vector<int>> Mat;
 	typedef pair<int, int> P;
@@ -49,60 +52,64 @@ namespace HeuristicSolver
 
 	class HeuristicPartition
 	{
-		Mat Map, ranks; // what about MSTC with heuristic partition ?
+		BitGridView Map; // Shared with the caller, read only
+		MSTGrid ranks;	 // what about MSTC with heuristic partition ?
 		vector<int> X, Y, transX, transY;
 		vector<int> height, width;
 		int dir[4][2] = {0, 1, -1, 0, 0, -1, 1, 0};
 		int max_iter;
 		vector<vector<rect>> minRanksRec;
 		UnionFind uf;
+		const std::atomic<bool> *stop_flag = nullptr; // Ends the orientation iterations early when set
 
 	public:
-		HeuristicPartition(Mat &_map, int _max_iter) : Map(_map), max_iter(_max_iter)
+		HeuristicPartition(BitGridView _map, int _max_iter) : Map(_map), ranks(_map.rows(), _map.cols()), max_iter(_max_iter)
 		{
-			uf.init(Map.size() * Map[0].size() + 5);
-			ranks.resize(Map.size() * Map[0].size() + 5, vector<int>{});
+			uf.init(Map.size() + 5);
 		}
 		vector<vector<rect>> chessboardPartition();
 		vector<vector<rect>> orientRectangle(vector<vector<rect>> &rec);
 		void minrects2ranks();
-		void mergeRanks(Mat &graph);
-		Mat hpSolver(bool merge);
+		void mergeRanks(MSTGrid &graph);
+		MSTGrid hpSolver(bool merge);
+		void setStopFlag(const std::atomic<bool> *flag) { stop_flag = flag; }
 
 		bool isSameLine(int a, int b, int c)
 		{
 			return a + c == 2 * b;
 		}
 
-		int getEdgeVal(Mat &graph, int v1, int v2)
+		int getEdgeVal(const MSTGrid &graph, int v1, int v2)
 		{
+			int n1[4], n2[4];
+			int d1 = graph.neighbours(v1, n1), d2 = graph.neighbours(v2, n2);
 			int cost = 0;
-			if (graph[v1].size() == 1)
+			if (d1 == 1)
 			{
-				if (isSameLine(graph[v1][0], v1, v2))
+				if (isSameLine(n1[0], v1, v2))
 					cost -= 2;
 			}
-			else if (graph[v1].size() == 2)
+			else if (d1 == 2)
 			{
-				if (isSameLine(graph[v1][0], v1, graph[v1][1]))
+				if (isSameLine(n1[0], v1, n1[1]))
 					cost += 2;
 			}
-			else if (graph[v1].size() == 3)
+			else if (d1 == 3)
 			{
 				cost += 2;
 			}
 
-			if (graph[v2].size() == 1)
+			if (d2 == 1)
 			{
-				if (isSameLine(v1, v2, graph[v2][0]))
+				if (isSameLine(v1, v2, n2[0]))
 					cost -= 2;
 			}
-			else if (graph[v2].size() == 2)
+			else if (d2 == 2)
 			{
-				if (isSameLine(graph[v2][0], v2, graph[v2][1]))
+				if (isSameLine(n2[0], v2, n2[1]))
 					cost += 2;
 			}
-			else if (graph[v1].size() == 3)
+			else if (d1 == 3)
 			{
 				cost += 2;
 			}
@@ -110,17 +117,19 @@ namespace HeuristicSolver
 			return cost;
 		}
 
-		int getVertexVal(Mat &graph, int v)
+		int getVertexVal(const MSTGrid &graph, int v)
 		{
-			if (graph[v].size() == 0)
+			int nb[4];
+			int degree = graph.neighbours(v, nb);
+			if (degree == 0)
 				return 0;
-			else if (graph[v].size() == 1)
+			else if (degree == 1)
 				return 2;
-			else if (graph[v].size() == 2)
+			else if (degree == 2)
 			{
-				return isSameLine(graph[v][0], v, graph[v][1]) ? 0 : 2;
+				return isSameLine(nb[0], v, nb[1]) ? 0 : 2;
 			}
-			else if (graph[v].size() == 3)
+			else if (degree == 3)
 				return 2;
 			else
 				return 4;
@@ -128,26 +137,28 @@ namespace HeuristicSolver
 
 		void showRanks()
 		{
+			int nb[4];
 			for (int i = 0; i < ranks.size(); ++i)
 			{
-				if (ranks[i].size() == 0)
+				int degree = ranks.neighbours(i, nb);
+				if (degree == 0)
 					continue;
-				for (int j = 0; j < ranks[i].size(); ++j)
-					cout << "(" << i << ", " << ranks[i][j] << ") ";
+				for (int j = 0; j < degree; ++j)
+					cout << "(" << i << ", " << nb[j] << ") ";
 				cout << "\n";
 			}
 		}
 
 		void checkConnectivity()
 		{
-			vector<vector<bool>> vis(Map.size(), vector<bool>(Map[0].size(), false));
+			vector<vector<bool>> vis(Map.rows(), vector<bool>(Map.cols(), false));
 			int freecells = 0;
 			P start{-1, -1};
-			for (int i = 0; i < Map.size(); ++i)
+			for (int i = 0; i < Map.rows(); ++i)
 			{
-				for (int j = 0; j < Map[0].size(); ++j)
+				for (int j = 0; j < Map.cols(); ++j)
 				{
-					if (Map[i][j])
+					if (Map.test(i, j))
 					{
 						freecells++;
 						if (start.first == -1)
@@ -169,7 +180,7 @@ namespace HeuristicSolver
 				{
 					int dx = p.first + dir[i][0];
 					int dy = p.second + dir[i][1];
-					if (dx >= 0 && dy >= 0 && dx < Map.size() && dy < Map[0].size() && Map[dx][dy] && !vis[dx][dy])
+					if (Map.free(dx, dy) && !vis[dx][dy])
 					{
 						que.push({dx, dy});
 						vis[dx][dy] = true;
@@ -177,24 +188,19 @@ namespace HeuristicSolver
 				}
 			}
 
-			cout << "freecells and connect-cells: " << freecells << " " << connectcell << "\n";
+			TMSTC_LOG(DETAIL, "freecells and connect-cells: " << freecells << " " << connectcell << "\n");
 		}
 
-		bool checkMST(Mat &graph, Mat &Map)
+		bool checkMST(const MSTGrid &graph)
 		{
 			int vertexNum = 0;
-			for (int i = 0; i < Map.size(); ++i)
-				for (int j = 0; j < Map[0].size(); ++j)
-					if (Map[i][j])
-						vertexNum++;
-
-			int edgeNum = 0;
-			for (int i = 0; i < graph.size(); ++i)
-				edgeNum += graph[i].size();
-			edgeNum /= 2;
-
-			cout << "The number of edges: " << edgeNum << endl;
-			cout << "The number of vertexes: " << vertexNum << endl;
+			for (int w = 0; w < Map.wordCount(); ++w)
+				vertexNum += __builtin_popcountll(Map.word(w));
+
+			int edgeNum = graph.edgeCount();
+
+			TMSTC_LOG(DETAIL, "The number of edges: " << edgeNum << endl);
+			TMSTC_LOG(DETAIL, "The number of vertexes: " << vertexNum << endl);
 			if (edgeNum != vertexNum - 1)
 				return false;
 			return true;
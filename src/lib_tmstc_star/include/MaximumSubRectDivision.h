@@ -11,6 +11,8 @@
 #include <queue>
 #include <time.h>
 #include <unordered_set>
+#include "PlanReport.h"
+#include "Grid.h"
 
 using std::cout;
 using std::endl;
@@ -59,46 +61,48 @@ typedef struct Edge
 #define RECT_SIZE(i) (rectVec[i].height * rectVec[i].width)
 
 #ifndef reshape
-	#define reshape(i, j) (int)((i) * Map[0].size() + (j))
+	#define reshape(i, j) (int)((i) * Map.cols() + (j))
 #endif
 
 class Division
 {
 	// int bigrows, bigcols;
 	// int smallrows, smallcols;
-	Mat MST, Map;
+	MSTGrid MST;
+	BitGridView Map; // Shared with the caller, read only
 	vector<int> fa;
 	// Mat pathEdge;
 public:
 	int dir[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
 	int dir2[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
 
-	Division(Mat &map) : Map(map)
+	Division(BitGridView map) : Map(map)
 	{
 		// smallrows = Map.size();  smallcols = Map[0].size();
 	}
 
 	vector<rect> findMaximumSubRect(Mat &Map);
 
-	vector<rect> maximumSubRectDivision(Mat &Map);
+	// Consumes Map, a scratch copy of the map
+	vector<rect> maximumSubRectDivision(BitGrid &Map);
 
 	void orientRect(vector<rect> &rectVec);
 
 	void constructMST(vector<rect> &rectVec);
 
-	void mergeMST(Mat &graph);
+	void mergeMST(MSTGrid &graph);
 
 	// void MST2Path();
 
-	Mat rectDivisionSolver();
+	MSTGrid rectDivisionSolver();
 
-	Mat bfsSolver(unsigned char bfsDir);
+	MSTGrid bfsSolver(unsigned char bfsDir);
 
-	Mat dfsWithStackSolver(unsigned char dfsDir);
+	MSTGrid dfsWithStackSolver(unsigned char dfsDir);
 
-	Mat kruskalSolver();
+	MSTGrid kruskalSolver();
 
-	bool checkMST(Mat &graph, Mat &Map);
+	bool checkMST(const MSTGrid &graph);
 
 	// void get2DCoordinate(int index, int& x, int& y);
 
@@ -127,35 +131,37 @@ public:
 		return a + c == 2 * b;
 	}
 
-	int getEdgeVal(Mat &graph, int v1, int v2)
+	int getEdgeVal(const MSTGrid &graph, int v1, int v2)
 	{
+		int n1[4], n2[4];
+		int d1 = graph.neighbours(v1, n1), d2 = graph.neighbours(v2, n2);
 		int cost = 0;
-		if (graph[v1].size() == 1)
+		if (d1 == 1)
 		{
-			if (isSameLine(graph[v1][0], v1, v2))
+			if (isSameLine(n1[0], v1, v2))
 				cost -= 2;
 		}
-		else if (graph[v1].size() == 2)
+		else if (d1 == 2)
 		{
-			if (isSameLine(graph[v1][0], v1, graph[v1][1]))
+			if (isSameLine(n1[0], v1, n1[1]))
 				cost += 2;
 		}
-		else if (graph[v1].size() == 3)
+		else if (d1 == 3)
 		{
 			cost += 2;
 		}
 
-		if (graph[v2].size() == 1)
+		if (d2 == 1)
 		{
-			if (isSameLine(v1, v2, graph[v2][0]))
+			if (isSameLine(v1, v2, n2[0]))
 				cost -= 2;
 		}
-		else if (graph[v2].size() == 2)
+		else if (d2 == 2)
 		{
-			if (isSameLine(graph[v2][0], v2, graph[v2][1]))
+			if (isSameLine(n2[0], v2, n2[1]))
 				cost += 2;
 		}
-		else if (graph[v1].size() == 3)
+		else if (d1 == 3)
 		{
 			cost += 2;
 		}
@@ -163,17 +169,19 @@ public:
 		return cost;
 	}
 
-	int getVertexVal(Mat &graph, int v)
+	int getVertexVal(const MSTGrid &graph, int v)
 	{
-		if (graph[v].size() == 0)
+		int nb[4];
+		int degree = graph.neighbours(v, nb);
+		if (degree == 0)
 			return 0;
-		else if (graph[v].size() == 1)
+		else if (degree == 1)
 			return 2;
-		else if (graph[v].size() == 2)
+		else if (degree == 2)
 		{
-			return isSameLine(graph[v][0], v, graph[v][1]) ? 0 : 2;
+			return isSameLine(nb[0], v, nb[1]) ? 0 : 2;
 		}
-		else if (graph[v].size() == 3)
+		else if (degree == 3)
 			return 2;
 		else
 			return 4;
@@ -8,6 +8,11 @@
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <atomic>
+
+#include "Grid.h"
+#include "PlanReport.h"
+#include "CostModel.h"
 
 using std::cout;
 using std::endl;
@@ -17,11 +22,6 @@ using std::unordered_set;
 using std::vector;
 
 const double eps = 1e-7;
-const double gravity = 9.81; // m/s^2 (gravitational acceleration)
-
-#define USE_UAV_COST
-// #define OLD_COST
-
 typedef vector<vector<int>> Mat;
 typedef pair<int, int> P;
 typedef struct Cut
@@ -47,27 +47,24 @@ typedef struct Node
 
 static double ONE_TURN_VAL = 2.0;
 
-struct VehicleParameters
-{
-	double omega_rad = 1;					  // rad/s (angular velocity)
-	double acc = 1.5;						  // m/s^2 (acceleration)
-	double vmax = 15;						  // m/s (max velocity)
-	double phi_max_rad = 45 * (M_PI / 180.0); // rad (maximum banking angle)
-	double cellSize_m = 30;					  // meters (grid cell size)
-};
-
 class PathCut
 {
 private:
 	int bigrows, bigcols;
 	int smallrows, smallcols;
 	int circleLen;
-	Mat MST, Map, Region;
+
+	// Storage used when the caller passes nested matrices, the solver itself only reads the views
+	BitGrid ownedMap, ownedRegion;
+	MSTGrid ownedMST;
+	BitGridView Map, Region;
+	MSTGridView MST;
 	Mat pathEdge;
 	vector<int> depot;
 	vector<int> pathSequence, invSequence;
 	vector<cut> cuts;
-	vector<double> pathValue;
+	vector<vector<double>> pathValues; // Prefix costs around the circle, one per distinct vehicle ([0] is vehicleParams')
+	vector<int> depotPathValue;		   // Per depot, its index into pathValues
 	int dir[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
 
 	vector<int> depot_cut; // from depot to cuts
@@ -75,20 +72,74 @@ private:
 
 	bool coverAndReturn;
 
+	// Turn-aware travel cost from each depot to every region cell, rebuilt once per cutSolver()
+	vector<vector<double>> depotDistField;
+
 	VehicleParameters vehicleParams;
 	int maxIterations = 150;
 
+	// Heterogeneous fleet, per depot: vehicle parameters and remaining endurance in cost units (<= 0 unlimited)
+	vector<VehicleParameters> robotParams;
+	vector<double> robotEndurance;
+	double enduranceStep = 0.0; // Endurance penalty floor, above any unpenalized cut value (updateEnduranceStep())
+	const VehicleParameters &depotParams(int depotIdx) const { return robotParams.empty() ? vehicleParams : robotParams[depotIdx]; }
+	const vector<double> &cutPathValue(int i) const { return pathValues[depotPathValue[cut_depot[i]]]; }
+	double cutFlightCost(int i) const;
+	double enduranceOverrun(int i) const;
+	void updateEnduranceStep();
+
 	// Point filtering and TSP optimization
 	std::function<bool(int)> is_point_filtered_func = nullptr; // Function to determine if a point should be ignored
+	BitGridView pointFilterMask;								// Region-grid bitmap of ignored points, preferred over the function
+	bool hasPointFilter() const { return pointFilterMask.size() == Region.size() || is_point_filtered_func; }
 	std::vector<int> filterValidPoints(const std::vector<int> &path);
 
+	// Direct-mapped cache of 3-cell segment costs for outlier optimization.
+	// Keys pack the three cell indices into 21 bits each; a colliding entry is simply overwritten.
+	static constexpr int SEGMENT_CACHE_BITS = 12;
+	static constexpr uint64_t SEGMENT_CACHE_EMPTY = ~0ULL;
+	vector<uint64_t> segmentCacheKeys;
+	vector<double> segmentCacheVals;
+	double segmentCost(int prev, int curr, int next);
+
+	const std::atomic<bool> *stop_flag = nullptr; // Ends MSTC_Star balancing early when set
+
+	CutPhaseTimes phaseTimes;
+	PlanCounters counters;
+
+	vector<int> warmStartCells; // Per depot, the region cell its cut started at in a previous plan
+	bool initCutsFromStarts(const vector<int> &startPos, double &opt, double &wst, bool checkOrder = true);
+
+	// Cost loops, instantiated per cost model policy (CostModel.h)
+	void buildPathValues();
+	template <typename Model>
+	void buildPathValue(const Model &model, vector<double> &value);
+	template <typename Model>
+	void buildDepotDistanceField(int depotIdx, const Model &model);
+	template <typename Model>
+	double A_star(int u, int v, const Model &model);
+
 public:
-	PathCut(Mat &map, Mat &region, Mat &tree, vector<int> &robotInitPos, VehicleParameters vp, int maxIter, bool _coverAndReturn = false) : Map(map), Region(region), MST(tree), depot(robotInitPos), vehicleParams(vp), maxIterations(maxIter), coverAndReturn(_coverAndReturn)
+	// Non-owning: map, region and tree must outlive the PathCut
+	PathCut(BitGridView map, BitGridView region, MSTGridView tree, const vector<int> &robotInitPos, VehicleParameters vp, int maxIter, bool _coverAndReturn = false) : Map(map), Region(region), MST(tree), depot(robotInitPos), vehicleParams(vp), maxIterations(maxIter), coverAndReturn(_coverAndReturn)
+	{
+		init();
+	}
+
+	PathCut(Mat &map, Mat &region, Mat &tree, vector<int> &robotInitPos, VehicleParameters vp, int maxIter, bool _coverAndReturn = false) : ownedMap(map), ownedRegion(region), ownedMST(tree, map.size(), map[0].size()), depot(robotInitPos), vehicleParams(vp), maxIterations(maxIter), coverAndReturn(_coverAndReturn)
 	{
-		bigrows = Region.size();
-		bigcols = Region[0].size();
-		smallrows = Map.size();
-		smallcols = Map[0].size();
+		Map = ownedMap.view();
+		Region = ownedRegion.view();
+		MST = ownedMST.view();
+		init();
+	}
+
+	void init()
+	{
+		bigrows = Region.rows();
+		bigcols = Region.cols();
+		smallrows = Map.rows();
+		smallcols = Map.cols();
 		circleLen = 0;
 		cuts.resize(depot.size(), {});
 		depot_cut.resize(depot.size(), 0); // The index of the i-th robot on the circle
@@ -102,6 +153,8 @@ public:
 	void Balanced_Cut(vector<int> &adjustCuts);
 	double updateCutVal(int i);
 	double A_star(int u, int v);
+	void buildDepotDistanceFields();
+	double depotDistance(int depotIdx, int v) const { return depotDistField[depotIdx][v]; }
 	vector<int> A_star_path(int u, int v);
 	vector<int> getHalfCuts(int cut_min, int cut_max, int dir);
 	Mat generatePath();
@@ -111,7 +164,9 @@ public:
 
 	Mat cutSolver();
 	int getTurnsNum();
-	double getTurnAndLength(int i);
+	double getTurnAndLength(int i) const;
+	double arcCost(int start, int len, const vector<double> &value) const; // O(1) cost of len cells from circle position start
+	pair<double, double> cutsScore() const;
 
 	friend double computePathCost(std::vector<int> &path);
 
@@ -131,9 +186,71 @@ public:
 		is_point_filtered_func = filter_func;
 	}
 
+	// Set a region-sized bitmap (1 = ignore the point) computed once per solve.
+	// Non-owning, the mask must outlive the PathCut. Takes precedence over the filtering function.
+	void setPointFilterMask(BitGridView mask)
+	{
+		pointFilterMask = mask;
+	}
+
+	// Set a flag that, when raised, stops cut balancing with the best cuts found so far
+	void setStopFlag(const std::atomic<bool> *flag)
+	{
+		stop_flag = flag;
+	}
+
+	// Heterogeneous fleet: one VehicleParameters per depot (the grid's cellSize_m is kept), so every cut is
+	// valued in its own robot's time and balancing minimizes the makespan. Empty uses the shared parameters.
+	void setRobotParameters(const vector<VehicleParameters> &params);
+
+	// Remaining endurance per depot in the same units as the cut values (seconds for the vehicle models),
+	// <= 0 or a missing entry is unlimited. Cuts past a robot's endurance are penalized so balancing moves
+	// work to robots with endurance left.
+	void setEnduranceLimits(const vector<double> &endurance)
+	{
+		robotEndurance = endurance;
+	}
+
+	// Whether every cut of the last solve fits its robot's endurance
+	bool withinEndurance() const;
+
+	// Seed MSTC_Star with the cut starts of a previous plan (one region cell per depot).
+	// Used when they keep the depots' circle order and start out better balanced than the depots themselves.
+	void setWarmStart(const vector<int> &startCells)
+	{
+		warmStartCells = startCells;
+	}
+
 	void optimizePathWithOutliersAndUpdateSequence(const std::vector<int> &valid_points);
+
+	// Timings of the last cutSolver() call
+	const CutPhaseTimes &getPhaseTimes() const { return phaseTimes; }
+	const PlanCounters &getCounters() const { return counters; }
+};
+
+// Batch cost kernels over a contiguous index path (src/PathCost.cpp).
+// Paths are grid indices on a grid with mapCols columns, like the cut solver's pathSequence.
+
+// Per segment and per vertex terms of a path's cost, filled in one call by evaluatePathCost()
+struct PathCostBreakdown
+{
+	vector<double> segment_times;	  // Travel time from path[j] to path[j + 1]
+	vector<unsigned char> turn_flags; // 1 where the path turns at path[j]
+	vector<double> turn_angles;		  // |segmentAngle| at path[j], 0 where it does not turn
+	int turns = 0;
+	double travel_time = 0.0;
+	double turn_time = 0.0;
+	double total = 0.0; // travel_time + turn_time, equal to computePathCost()
 };
 
+void evaluatePathCost(const int *path, size_t n, const VehicleParameters &vehicleParams, int mapCols, PathCostBreakdown &out);
 double computePathCost(const std::vector<int> &path, const VehicleParameters &vehicleParams, int mapCols);
 
+// Turn flags (first and last are 0) and turn count, from the index arithmetic alone
+void markTurns(const int *path, size_t n, unsigned char *turn_flags);
+int countTurns(const int *path, size_t n);
+
+// |segmentAngle| of the turn p0 -> p1 -> p2, looked up per step direction pair
+double turnAngle(int p0, int p1, int p2, int mapCols);
+
 #endif
\ No newline at end of file
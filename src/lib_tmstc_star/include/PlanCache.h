@@ -0,0 +1,128 @@
+#ifndef _PLAN_CACHE_H
+#define _PLAN_CACHE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "Grid.h"
+
+// Content-addressed store of finished plans, persisted in one memory-mapped file.
+// Plans are keyed by a 128-bit hash of everything that determines them (map, depots, config),
+// so a repeated mission is answered from disk instead of being solved again, also after a restart.
+// The file is append-only and shared safely between processes (writers take an flock).
+
+// 128-bit hash built incrementally from the plan inputs
+class PlanKey
+{
+public:
+	PlanKey &add(uint64_t v)
+	{
+		// FNV-1a over the bytes and a multiply-xorshift mix, two independent 64-bit lanes
+		for (int i = 0; i < 8; ++i)
+		{
+			lo_ ^= (v >> (8 * i)) & 0xffULL;
+			lo_ *= 0x100000001b3ULL;
+		}
+		hi_ = mix(hi_ ^ (v + 0x9e3779b97f4a7c15ULL));
+		return *this;
+	}
+	PlanKey &add(int v) { return add(static_cast<uint64_t>(static_cast<uint32_t>(v))); }
+	PlanKey &add(bool v) { return add(static_cast<uint64_t>(v)); }
+	PlanKey &add(double v)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &v, sizeof(bits));
+		return add(bits);
+	}
+	PlanKey &add(const std::string &s)
+	{
+		add(static_cast<uint64_t>(s.size()));
+		for (unsigned char c : s)
+			add(static_cast<uint64_t>(c));
+		return *this;
+	}
+
+	static PlanKey fromParts(uint64_t lo, uint64_t hi)
+	{
+		PlanKey k;
+		k.lo_ = lo;
+		k.hi_ = hi;
+		return k;
+	}
+
+	uint64_t lo() const { return lo_; }
+	uint64_t hi() const { return hi_; }
+	bool operator==(const PlanKey &o) const { return lo_ == o.lo_ && hi_ == o.hi_; }
+
+private:
+	static uint64_t mix(uint64_t x)
+	{
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
+	}
+
+	uint64_t lo_ = 0xcbf29ce484222325ULL;
+	uint64_t hi_ = 0x6a09e667f3bcc909ULL;
+};
+
+// What is kept per plan: the spanning tree (so incremental replans can start from a cache hit) and the paths
+struct CachedPlan
+{
+	std::string shape;
+	MSTGrid mst;
+	std::vector<std::vector<int>> paths;
+};
+
+class PlanCache
+{
+public:
+	// Bump when a planner change makes earlier plans for the same inputs stale
+	static constexpr uint32_t FORMAT_VERSION = 4;
+
+	// Opens (or creates) the cache file. A file that grows past max_bytes is started over.
+	// Throws std::runtime_error when the file cannot be opened or is not a plan cache.
+	explicit PlanCache(const std::string &path, size_t max_bytes = 64u << 20);
+	~PlanCache();
+
+	PlanCache(const PlanCache &) = delete;
+	PlanCache &operator=(const PlanCache &) = delete;
+
+	const std::string &path() const { return path_; }
+
+	bool lookup(const PlanKey &key, CachedPlan &plan);
+	void store(const PlanKey &key, const CachedPlan &plan);
+
+private:
+	struct KeyHash
+	{
+		size_t operator()(const PlanKey &k) const { return static_cast<size_t>(k.lo() ^ (k.hi() * 31)); }
+	};
+	struct Location
+	{
+		size_t offset; // Of the payload
+		uint32_t bytes;
+	};
+
+	void remap();		// Maps the whole file and indexes entries past indexed_end_, caller holds the file lock
+	void resetLocked(); // Truncates to the header, caller holds the exclusive file lock
+
+	std::string path_;
+	size_t max_bytes_;
+	int fd_ = -1;
+	const unsigned char *data_ = nullptr;
+	size_t mapped_ = 0;
+	size_t indexed_end_ = 0;
+	uint32_t generation_ = 0;
+	std::unordered_map<PlanKey, Location, KeyHash> index_;
+	std::mutex mtx_;
+};
+
+#endif
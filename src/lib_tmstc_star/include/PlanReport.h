@@ -0,0 +1,108 @@
+#ifndef _PLAN_REPORT_H
+#define _PLAN_REPORT_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// Console and log file verbosity of the TMSTC* library. Like Logger it is process wide,
+// so every solver (and every portfolio or tile worker) follows the same level.
+enum class Verbosity : int
+{
+	QUIET = 0,	 // Nothing but errors and warnings
+	SUMMARY = 1, // One line per solver stage (default)
+	DETAIL = 2	 // Per iteration and per point traces (not DEBUG, which the tree uses as a preprocessor switch)
+};
+
+namespace tmstc
+{
+inline std::atomic<int> verbosity_level{static_cast<int>(Verbosity::SUMMARY)};
+
+inline void setVerbosity(Verbosity level) { verbosity_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+inline bool logEnabled(Verbosity level) { return verbosity_level.load(std::memory_order_relaxed) >= static_cast<int>(level); }
+}
+
+// The message is only formatted when the level is enabled, e.g.
+//   TMSTC_LOG(DETAIL, "Iteration " << i << "\n");
+//   TMSTC_LOG_INFO(DETAIL, "TMSTC - Iteration " + std::to_string(i));
+#define TMSTC_LOG(level, ...)                        \
+	do                                               \
+	{                                                \
+		if (tmstc::logEnabled(Verbosity::level))     \
+			std::cout << __VA_ARGS__;                \
+	} while (0)
+
+#define TMSTC_LOG_INFO(level, ...)                   \
+	do                                               \
+	{                                                \
+		if (tmstc::logEnabled(Verbosity::level))     \
+			Logger::info(__VA_ARGS__);               \
+	} while (0)
+
+// Adds its lifetime to a seconds counter
+class ScopedTimer
+{
+public:
+	explicit ScopedTimer(double &seconds) : seconds_(seconds), start_(std::chrono::steady_clock::now()) {}
+	~ScopedTimer() { seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count(); }
+
+	ScopedTimer(const ScopedTimer &) = delete;
+	ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+	double &seconds_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+// Wall time spent in each stage of PathCut::cutSolver(), in seconds
+struct CutPhaseTimes
+{
+	double mst2path_s = 0.0;	 // Tree to coverage circle, excluding filtering
+	double filtering_s = 0.0;	 // Point filtering and outlier optimization
+	double depot_fields_s = 0.0; // Per-depot distance fields
+	double mstc_star_s = 0.0;	 // Cut balancing
+	double generate_s = 0.0;	 // Cut to robot path conversion
+};
+
+// Wall time per planning phase, in seconds.
+// A PORTFOLIO run only reports the total, its shapes are timed concurrently.
+struct PlanPhaseTimes
+{
+	double mst_build_s = 0.0; // Spanning tree construction (or repair)
+	CutPhaseTimes cut;		  // Stages of the cut solver
+	double total_s = 0.0;	  // Whole planning call
+};
+
+// Work done by the cut solver
+struct PlanCounters
+{
+	long astar_calls = 0;			   // A_star() and A_star_path() searches
+	long nodes_expanded = 0;		   // States popped by A* and the depot distance fields
+	long balancing_iterations = 0;	   // MSTC_Star iterations
+	long balanced_cut_evaluations = 0; // Cut splits tried by Balanced_Cut()
+};
+
+// How evenly the last plan splits the work, from the robots' path costs
+struct PlanBalance
+{
+	double max_cost = 0.0;
+	double min_cost = 0.0;
+	double mean_cost = 0.0;
+	double imbalance = 0.0;		   // max_cost / mean_cost - 1, 0 for a perfectly balanced plan
+	bool deadline_expired = false; // The plan is the best found before the deadline, not a converged one
+};
+
+// Everything known about how a plan was made, kept next to the paths it describes
+struct PlanReport
+{
+	std::string shape;		  // Spanning tree shape used (the winner for PORTFOLIO)
+	bool incremental = false; // Repaired from the previous plan instead of solved from scratch
+	bool cache_hit = false;	  // Loaded from the plan cache instead of solved
+	bool within_endurance = true; // Every robot's flight fits TMSTCStarConfig::robot_endurance_s
+	PlanPhaseTimes phases;
+	PlanCounters counters;
+	PlanBalance balance;
+};
+
+#endif
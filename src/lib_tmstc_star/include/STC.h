@@ -2,7 +2,7 @@
 #include <iostream>
 #include <algorithm>
 #include <cmath>
-#include <unordered_set>
+#include "Grid.h"
 
 typedef std::vector<std::vector<int>> intMatrix;
 typedef std::vector<std::vector<double>> doubleMatrix;
@@ -13,19 +13,19 @@ class STC
 {
 public:
 	int MAX_NODES;
-	intMatrix robotRegion;
+	BitGridView robotRegion; // Shared with the caller, read only
 	std::vector<int> parent;
 	std::vector<std::pair<int, int>> edgeSetSTC;
 	std::pair<int, int> robotInitPos;
 	int bigrows, bigcols;
 	int smallrows, smallcols;
 	int dir[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-	STC(int r, int c, intMatrix &region, std::pair<int, int> initPos) : bigrows(r), bigcols(c),
+	STC(int r, int c, BitGridView region, std::pair<int, int> initPos) : bigrows(r), bigcols(c),
 																		robotRegion(region), robotInitPos(initPos)
 	{
 		MAX_NODES = bigrows * bigcols + 1;
-		smallrows = robotRegion.size();
-		smallcols = robotRegion[0].size();
+		smallrows = robotRegion.rows();
+		smallcols = robotRegion.cols();
 
 		for (int i = 0; i < MAX_NODES; ++i)
 			parent.push_back(i);
@@ -39,7 +39,7 @@ public:
 		{
 			int dx = x + dir[i][0];
 			int dy = y + dir[i][1];
-			if (dx >= 0 && dy >= 0 && dx < smallcols && dy < smallrows && robotRegion[dy][dx])
+			if (dx >= 0 && dy >= 0 && dx < smallcols && dy < smallrows && robotRegion.test(dy, dx))
 			{
 				int from = y * smallcols + x, to = dy * smallcols + dx;
 				if (!same(from, to))
@@ -88,12 +88,9 @@ public:
 		// recap
 		dfs(robotInitPos.first / 2, robotInitPos.second / 2);
 
-		std::vector<std::unordered_set<int>> tree(smallcols * smallrows, std::unordered_set<int>{});
+		MSTGrid tree(smallrows, smallcols);
 		for (auto &&p : edgeSetSTC)
-		{
-			tree[p.first].insert(p.second);
-			tree[p.second].insert(p.first);
-		}
+			tree.addEdge(p.first, p.second);
 
 		// construct path graph(bidirectional)
 		intMatrix pathEdge(MAX_NODES);
@@ -140,7 +137,7 @@ public:
 		{
 			for (int j = 0; j < smallcols; ++j)
 			{
-				if (!robotRegion[i][j])
+				if (!robotRegion.test(i, j))
 					continue;
 				int x = 2 * j, y = 2 * i;
 				int cur = i * smallcols + j;
@@ -149,22 +146,22 @@ public:
 				int p3 = (y + 1) * bigcols + x;
 				int p4 = (y + 1) * bigcols + x + 1;
 
-				if (j == 0 || tree[cur].find(cur - 1) == tree[cur].end())
+				if (j == 0 || !tree.hasEdge(cur, MST_LEFT))
 				{
 					pathEdge[p1].push_back(p3);
 					pathEdge[p3].push_back(p1);
 				}
-				if (j == smallcols - 1 || tree[cur].find(cur + 1) == tree[cur].end())
+				if (j == smallcols - 1 || !tree.hasEdge(cur, MST_RIGHT))
 				{
 					pathEdge[p2].push_back(p4);
 					pathEdge[p4].push_back(p2);
 				}
-				if (i == 0 || tree[cur].find(cur - smallcols) == tree[cur].end())
+				if (i == 0 || !tree.hasEdge(cur, MST_UP))
 				{
 					pathEdge[p1].push_back(p2);
 					pathEdge[p2].push_back(p1);
 				}
-				if (i == smallrows - 1 || tree[cur].find(cur + smallcols) == tree[cur].end())
+				if (i == smallrows - 1 || !tree.hasEdge(cur, MST_DOWN))
 				{
 					pathEdge[p3].push_back(p4);
 					pathEdge[p4].push_back(p3);
@@ -0,0 +1,41 @@
+#ifndef _SORTIE_PLANNER_H
+#define _SORTIE_PLANNER_H
+
+#include <vector>
+
+#include "CostModel.h"
+
+// Splits one robot's coverage path into sorties that each start and end at its refuel point and fit the
+// vehicle's range. Split points are chosen by dynamic programming over the path to minimize the mission
+// time: coverage, the transit legs to and from the refuel point of every sortie, and the ground time of
+// each refuel. Times come from the vehicle's cost model (CostModel.h), coverage with its turns like
+// computePathCost(). Transits are flown straight (distances are Euclidean between cell centers).
+
+struct Sortie
+{
+	int begin = 0; // First path index covered
+	int end = 0;   // One past the last path index covered
+	double transit_out_m = 0.0;
+	double coverage_m = 0.0;
+	double transit_back_m = 0.0;
+	double cost = 0.0; // Transits and coverage in the cost model's units (seconds, cells for TURN_COUNT)
+
+	double length_m() const { return transit_out_m + coverage_m + transit_back_m; }
+};
+
+struct SortiePlan
+{
+	std::vector<Sortie> sorties;
+	int refuel_idx = -1;		 // Region index every sortie starts from and returns to
+	double length_m = 0.0;		 // All sorties, transits included
+	double mission_time_s = 0.0; // Sortie costs plus the refuels between sorties, in the cost model's units
+	bool feasible = true;		 // False when some cell cannot be reached and returned from within range
+};
+
+// path: region grid indices (index = row * cols + col), refuel_idx: region index of the refuel point.
+// range_m <= 0 returns the whole path as one sortie. first_range_m is the range left for the first sortie
+// (<= 0 or above range_m starts on full fuel). A range is spent as its straight flight time at vmax.
+SortiePlan planSorties(const std::vector<int> &path, int cols, int refuel_idx, const VehicleParameters &vp,
+					   double range_m, double first_range_m = 0.0, double refuel_time_s = 0.0);
+
+#endif
@@ -7,23 +7,70 @@
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include "PathCut.h"
 #include "MaximumSubRectDivision.h"
 #include "HeuristicPartition.h"
 #include "ACO_STC.h"
 #include "Dinic.h"
+#include "PlanCache.h"
+#include "DubinsSmoothing.h"
+#include "SortiePlanner.h"
 
 typedef vector<vector<int>> Mat;
 
 struct TMSTCStarConfig
 {
     std::string allocate_method = "MSTC"; // "MSTC", "MTSP"
-    std::string mst_shape = "RECT_DIV";   // "RECT_DIV", "DFS_VERTICAL", "DFS_HORIZONTAL", "KRUSKAL", "ACO_OPT", "DINIC", "HEURISTIC"
+    std::string mst_shape = "RECT_DIV";   // "RECT_DIV", "DFS_VERTICAL", "DFS_HORIZONTAL", "KRUSKAL", "ACO_OPT", "DINIC", "HEURISTIC", "PORTFOLIO"
     int robot_num = 1;
     bool cover_and_return = false;
     int max_iterations = 1000; // For iterative algorithms
     VehicleParameters vehicle_params = {0.8, 0.6, 0.5, 0.5}; // rad/s, m/s^2, m/s, meters
+
+    // Mixed fleets: one entry per robot (same order as the start positions), empty uses vehicle_params for
+    // all. Cuts are balanced on each robot's own flight time, so the slowest robot gets the smallest share.
+    std::vector<VehicleParameters> robot_vehicle_params;
+    // Remaining endurance per robot in seconds (cost units for TURN_COUNT), <= 0 or missing is unlimited
+    std::vector<double> robot_endurance_s;
+    // Multi-sortie plans (planSorties()): range of a full tank in meters, per robot or sortie_range_m for
+    // all (<= 0 is unlimited), the range left at the start, and the ground time of a refuel at the depot
+    double sortie_range_m = 0.0;
+    std::vector<double> robot_range_m;
+    std::vector<double> robot_range_left_m;
+    double refuel_time_s = 0.0;
     std::function<bool(int)> is_point_filtered_func = nullptr; // Function to determine if a point should be ignored
+    BitGrid point_filter_mask; // Region-grid bitmap of ignored points (1 = ignore), used instead of the function when sized to the region
+    Verbosity verbosity = Verbosity::SUMMARY; // Console and log output, applied process wide by each planning call
+
+    // Set from another thread to stop a running solve early: it returns its best plan so far, reported as
+    // cut short by a deadline. Owned by the caller, and cleared by it before the next solve.
+    const std::atomic<bool> *cancel_flag = nullptr;
+
+    // Incremental replanning: above this share of changed map cells, replanIncremental() solves from scratch
+    double incremental_max_change_ratio = 0.25;
+
+    // ACO_OPT: ants are built in parallel, results only depend on the seed
+    unsigned int aco_seed = 0;
+    int aco_threads = 0;                  // <= 0 uses std::thread::hardware_concurrency(), shared out under PORTFOLIO and tiling
+
+    // Tiled planning for large maps: > 0 builds the spanning tree in tile_size x tile_size blocks of
+    // spanning cells in parallel and stitches them into one tree, before the usual cut balancing
+    int tile_size = 0;
+    int tile_threads = 0;                 // <= 0 uses std::thread::hardware_concurrency()
+
+    // PORTFOLIO: run every shape concurrently and keep the plan with the lowest max-robot cost
+    // Wall-clock budget, <= 0 stops once RECT_DIV (the default shape) has finished. Shapes still running
+    // then are stopped without being waited for, and the plan is reported as cut short by a deadline.
+    double portfolio_time_budget_s = 0.0;
+    int portfolio_threads = 0;            // Worker threads, <= 0 uses std::thread::hardware_concurrency()
+
+    // Persistent plan cache: a file path enables it. Full solves with the same map, depots and config
+    // are answered from the file, also across restarts. Not used with is_point_filtered_func (use the mask).
+    std::string plan_cache_path;
+    size_t plan_cache_max_bytes = 64u << 20; // The file is started over when it would grow past this
 };
 
 class TMSTCStar
@@ -37,15 +84,74 @@ private:
     // Core algorithm components
     int smallrows_, smallcols_; // Map dimensions
     int bigrows_, bigcols_;     // Region dimensions
-    Mat mst_;
+    MSTGrid mst_;
     Mat paths_; // Final paths
 
+    // Packed copies of map_ and region_ shared (read-only) by the cut solvers, rebuilt per planning call
+    BitGrid map_grid_, region_grid_;
+
     // Helper methods
     void preprocessMap();
     void showMapInfo();
     bool isSameLine(int a, int b, int c) { return a + c == 2 * b; }
     void getPathInfo();
 
+    // Build the spanning tree of one shape and cut it into robot paths
+    MSTGrid buildMST(const std::string &shape, const std::atomic<bool> *stop_flag = nullptr) const;
+    // map is only read, the tree solvers share it instead of copying it
+    MSTGrid buildTree(BitGridView map, const std::string &shape, const std::atomic<bool> *stop_flag, Dinic &dinic,
+                      int aco_threads) const;
+    MSTGrid buildTiledMST(const std::string &shape, const std::atomic<bool> *stop_flag) const;
+    Mat cutMST(const MSTGrid &mst, const std::atomic<bool> *stop_flag = nullptr, PlanReport *report = nullptr) const;
+    Mat solvePortfolio(std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+    Mat solvePlan(const std::atomic<bool> *tree_stop_flag, const std::atomic<bool> *stop_flag,
+                  std::chrono::steady_clock::time_point deadline);
+    static constexpr double DEADLINE_TREE_SHARE = 0.7; // Share of a deadline's budget iterative tree shapes may use
+    void updatePlanBalance(bool deadline_expired);
+
+    std::string portfolio_winner_; // Shape selected by the last PORTFOLIO run
+    bool portfolio_cut_short_ = false; // The last PORTFOLIO run returned before every shape finished
+
+    // Workers of the last PORTFOLIO run that were still in a stage which does not poll the stop flag.
+    // Joined before the next run and on destruction; a copy of the planner starts without any.
+    struct WorkerThreads
+    {
+        std::vector<std::thread> threads;
+
+        WorkerThreads() = default;
+        WorkerThreads(const WorkerThreads &) {}
+        WorkerThreads &operator=(const WorkerThreads &) { return *this; }
+        ~WorkerThreads() { join(); }
+
+        void join()
+        {
+            for (auto &t : threads)
+                t.join();
+            threads.clear();
+        }
+    };
+    WorkerThreads portfolio_workers_;
+    PlanReport report_; // Describes paths_
+
+    // Reused by every DINIC solve of this planner so replans keep the flow graph buffers.
+    // A portfolio runs each shape once, so there is never more than one DINIC solve in flight.
+    mutable Dinic dinic_;
+
+    // Set by replanIncremental() so the next cut reuses the previous plan's cut starts
+    std::vector<int> warm_start_cells_;
+
+    // Patch mst_ (built for the previous map) so it spans map_, touching only edges near the changed cells
+    bool repairMST(const std::vector<int> &changed_cells);
+
+    // Plan cache, opened on first use of config_.plan_cache_path
+    std::shared_ptr<PlanCache> plan_cache_;
+    PlanCache *planCache();
+    bool planCacheKey(PlanKey &key) const; // False when the plan inputs cannot be hashed
+
+    // Add the map edges that join separate tree components with the fewest extra turns, within rows r0..r1, cols c0..c1
+    void connectComponents(MSTGrid &tree, UnionFind &uf, int r0, int r1, int c0, int c1) const;
+    bool spansMap(UnionFind &uf) const;
+
 public:
 
     TMSTCStar(const TMSTCStarConfig &config = TMSTCStarConfig()): config_(config) {};
@@ -66,6 +172,25 @@ public:
     // Calculate paths using the specified method
     Mat calculateRegionIndxPaths();
 
+    // Anytime variant: iterative stages (ACO_OPT, HEURISTIC, cut balancing, PORTFOLIO) stop at the deadline
+    // and the best plan found so far is returned. Single-pass tree shapes always run to completion.
+    // getPlanReport().balance tells whether the deadline was hit and how balanced the result is.
+    Mat calculateRegionIndxPaths(std::chrono::steady_clock::time_point deadline);
+
+    // Replan after part of the map changed (e.g. an ignored region was added or removed).
+    // Repairs the previous spanning tree around the changed cells and warm-starts the cut balancing
+    // from the previous plan. Falls back to a full solve when there is no usable previous plan.
+    // Skips the tree build, but the map diff, the component check and the cut remain O(map).
+    Mat replanIncremental(const Mat &map, const std::vector<int> &robot_positions,
+                          std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+    bool hasPlan() const { return !mst_.empty() && !paths_.empty(); }
+    bool wasLastReplanIncremental() const { return report_.incremental; }
+
+    // Shapes raced by the PORTFOLIO mode
+    static const std::vector<std::string> PORTFOLIO_SHAPES;
+    static constexpr size_t PORTFOLIO_REFERENCE = 0; // RECT_DIV, whose run time bounds a portfolio without budget
+    std::string getPortfolioWinner() const { return portfolio_winner_; }
+
     // Get path statistics
     struct PathStats
     {
@@ -77,8 +202,61 @@ public:
     };
     PathStats getPathStatistics();
 
+    // Phase timings, solver counters and balance of the current paths
+    const PlanReport &getPlanReport() const { return report_; }
+    const PlanPhaseTimes &getPhaseTimes() const { return report_.phases; }
+
+    // Balance of the last plan, and whether it was cut short by a deadline
+    const PlanBalance &getPlanBalance() const { return report_.balance; }
+
     std::vector<std::vector<std::pair<int, int>>> pathsIndxToRegionCoords(Mat paths_indx) const;
 
+    // Vehicle parameters of robot i (index into the start positions and paths), with the grid's cell size
+    VehicleParameters robotVehicleParams(size_t i) const
+    {
+        if (config_.robot_vehicle_params.size() != robot_init_pos_.size() || i >= robot_init_pos_.size())
+            return config_.vehicle_params;
+        VehicleParameters vp = config_.robot_vehicle_params[i];
+        vp.cellSize_m = config_.vehicle_params.cellSize_m;
+        return vp;
+    }
+
+    // Turn-radius-aware track for one region index path flown by robot i, see DubinsSmoothing.h
+    SmoothedPath smoothPath(const std::vector<int> &path, double sensor_radius_m = 0.0, size_t robot = 0) const
+    {
+        return smoothPathDubins(path, bigcols_, robotVehicleParams(robot), sensor_radius_m);
+    }
+
+    // Split path i into sorties flown by robot r, from and back to r's start position within r's range,
+    // see SortiePlanner.h. A robot flies its own path by default.
+    SortiePlan planSorties(size_t path, size_t robot) const
+    {
+        if (path >= paths_.size() || robot >= robot_init_pos_.size())
+            return SortiePlan();
+        double range = robot < config_.robot_range_m.size() ? config_.robot_range_m[robot] : config_.sortie_range_m;
+        double range_left = robot < config_.robot_range_left_m.size() ? config_.robot_range_left_m[robot] : 0.0;
+        return ::planSorties(paths_[path], bigcols_, robot_init_pos_[robot], robotVehicleParams(robot), range,
+                             range_left, config_.refuel_time_s);
+    }
+    SortiePlan planSorties(size_t robot) const { return planSorties(robot, robot); }
+
+    // Cost of path i flown by robot r under r's cost model, measured on the region grid like transitCost() and
+    // planSorties()
+    double getPathCost(size_t path, size_t robot) const
+    {
+        if (path >= paths_.size())
+            return 0.0;
+        return computePathCost(paths_[path], robotVehicleParams(robot), bigcols_);
+    }
+    double getPathCost(size_t robot) const { return getPathCost(robot, robot); }
+
+    // Cost of a straight transit of distance_m meters for robot i, in the same units as getPathCost()
+    double transitCost(double distance_m, size_t robot = 0) const
+    {
+        return withCostModel(robotVehicleParams(robot), [&](const auto &model)
+                             { return model.segment(distance_m); });
+    }
+
     std::pair<int, int> indexToRegionCoord(int index) const
     {
         return indexToCoord(index, bigcols_);
@@ -99,8 +99,9 @@ int main()
 	}
 
 	cout << "begin hp...\n";
-	HeuristicSolver::HeuristicPartition hp(Map, 1000);
-	Mat MST = hp.hpSolver(true);
+	BitGrid map_grid(Map);
+	HeuristicSolver::HeuristicPartition hp(map_grid.view(), 1000);
+	MSTGrid MST = hp.hpSolver(true);
 	// hp.showRanks();
 	hp.checkConnectivity();
 	// 2021.11.27 If Map is too small, need to reconstruct the original region
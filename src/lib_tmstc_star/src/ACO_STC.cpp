@@ -1,8 +1,57 @@
 #include "ACO_STC.h"
+#include <thread>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
+AntPool::AntPool(int threads) {
+	for (int t = 1; t < threads; ++t)	workers.emplace_back(&AntPool::loop, this, t);
+}
+
+AntPool::~AntPool() {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		quit = true;
+	}
+	start_cv.notify_all();
+	for (auto &th : workers)	th.join();
+}
+
+void AntPool::run(const std::function<void(int)> &_job) {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		job = &_job;
+		pending = workers.size();
+		generation++;
+	}
+	start_cv.notify_all();
+	_job(0);
+
+	std::unique_lock<std::mutex> lock(mtx);
+	done_cv.wait(lock, [this]() { return pending == 0; });
+	job = nullptr;
+}
+
+void AntPool::loop(int t) {
+	uint64_t seen = 0;
+	while (true) {
+		const std::function<void(int)> *cur;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			start_cv.wait(lock, [&]() { return quit || generation != seen; });
+			if (quit)	return;
+			seen = generation;
+			cur = job;
+		}
+		(*cur)(t);
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			pending--;
+		}
+		done_cv.notify_one();
+	}
+}
+
 void ACO_STC::reset() {
 	for (int i = 0; i < info.size(); ++i) {
 		for (int j = 0; j < 4; ++j) {
@@ -11,58 +60,78 @@ void ACO_STC::reset() {
 	}
 }
 
-vector<int> ACO_STC::is_valid(int dx, int dy) {
-	vector<int> neighbor;
+void ACO_STC::init_ant_pos() {
+	// generate ants' initial position randomly (but reproducibly) on distinct free cells
+	int free_cells = 0;
+	for (int i = 0; i < cell_num; ++i)
+		if (Map.test(i))	free_cells++;
+	ant_num = std::min(ant_num, free_cells);
+
+	std::unordered_map<int, bool> used;
+	ant_init_pos.resize(ant_num);
+	std::mt19937_64 gen(seed);
+	for (int i = 0; i < ant_num; ++i) {
+		while (true) {
+			int rnd = gen() % cell_num;
+			if (!used.count(rnd) && Map.test(rnd)) {
+				used[rnd] = true;
+				ant_init_pos[i] = rnd;
+				break;
+			}
+		}
+	}
+}
+
+int ACO_STC::is_valid(const AntScratch &s, int dx, int dy, int neighbor[4]) {
+	int cnt = 0;
 	for (int i = 0; i < 4; ++i) {
 		int sx = dx + dir[i][0], sy = dy + dir[i][1];
-		if (sx < 0 || sx >= row || sy < 0 || sy >= col || vis[sx * col + sy] || !Map[sx][sy])	continue;
+		if (sx < 0 || sx >= row || sy < 0 || sy >= col || s.vis[sx * col + sy] || !Map.test(sx, sy))	continue;
 
-		neighbor.push_back(sx * col + sy);
+		neighbor[cnt++] = sx * col + sy;
 	}
 
-	return neighbor;
+	return cnt;
 }
 
-bool ACO_STC::select_next() {
+bool ACO_STC::select_next(AntScratch &s, AntRng &rng) {
 	// can't expand here, then backtrack
-	//cout << cur_pos << endl;
-	vis[cur_pos] = true;
+	int &cur_pos = s.cur_pos;
+	s.vis[cur_pos] = true;
 	int dx = cur_pos / col, dy = cur_pos % col;
-	vector<int> neighbor = is_valid(dx, dy);
-	while (!neighbor.size()) {
-		path.pop();
-		if (path.empty())	return true;
-
-		cur_pos = path.top();
-		dx = path.top() / col, dy = path.top() % col;
-		neighbor = is_valid(dx, dy);
+	int neighbor[4];
+	int neighbor_num = is_valid(s, dx, dy, neighbor);
+	while (!neighbor_num) {
+		s.path.pop_back();
+		if (s.path.empty())	return true;
+
+		cur_pos = s.path.back();
+		dx = cur_pos / col, dy = cur_pos % col;
+		neighbor_num = is_valid(s, dx, dy, neighbor);
 	}
 
 	// elite rule ? q0. Implement this later
-	/*double q0 = 0.2;
-	double q = 1.0 * rand() / RAND_MAX;*/
 
 	double prob_sum = 0, prob_pre = 0;
-	for (int i = 0; i < neighbor.size(); ++i) {
+	for (int i = 0; i < neighbor_num; ++i) {
 		if (neighbor[i] - cur_pos == -col)	    prob_sum += info[cur_pos][0];
 		else if (neighbor[i] - cur_pos == col)	prob_sum += info[cur_pos][2];
 		else if (neighbor[i] - cur_pos == 1)	prob_sum += info[cur_pos][1];
 		else									prob_sum += info[cur_pos][3];
 	}
 
-	double rnd = 1.0 * rand() / RAND_MAX;
+	double rnd = rng.uniform();
 	rnd *= prob_sum;
-	for (int i = 0; i < neighbor.size(); ++i) {
+	for (int i = 0; i < neighbor_num; ++i) {
 		if (neighbor[i] - cur_pos == -col)	    prob_pre += info[cur_pos][0];
 		else if (neighbor[i] - cur_pos == col)	prob_pre += info[cur_pos][2];
 		else if (neighbor[i] - cur_pos == 1)	prob_pre += info[cur_pos][1];
 		else									prob_pre += info[cur_pos][3];
 
-		if (prob_pre >= rnd) {
-			cur_MST[cur_pos].push_back(neighbor[i]);
-			cur_MST[neighbor[i]].push_back(cur_pos);
+		if (prob_pre >= rnd || i == neighbor_num - 1) {
+			s.MST.addEdge(cur_pos, neighbor[i]);
 			cur_pos = neighbor[i];
-			path.push(neighbor[i]);
+			s.path.push_back(neighbor[i]);
 			return false;
 		}
 	}
@@ -70,15 +139,17 @@ bool ACO_STC::select_next() {
 	return false;
 }
 
-int ACO_STC::get_turns(Mat& MST) {
+int ACO_STC::get_turns(const MSTGrid& MST) {
 	int turns = 0, nodes = 0;
+	int nb[4];
 	for (int i = 0; i < MST.size(); ++i) {
-		if (MST[i].size()) nodes++;
+		int degree = MST.neighbours(i, nb);
+		if (degree) nodes++;
 
-		if (MST[i].size() == 3 || MST[i].size() == 1)		 turns += 2;
-		else if (MST[i].size() == 4)						 turns += 4;
+		if (degree == 3 || degree == 1)		 turns += 2;
+		else if (degree == 4)				 turns += 4;
 		else {
-			if (MST[i].size() == 2 && MST[i][0] + MST[i][1] != 2 * i)	turns += 2;
+			if (degree == 2 && nb[0] + nb[1] != 2 * i)	turns += 2;
 		}
 	}
 	//cout << "There are " << nodes << " node on the tree.\n";
@@ -86,90 +157,144 @@ int ACO_STC::get_turns(Mat& MST) {
 	return turns;
 }
 
+void ACO_STC::construct_ant(AntScratch &s, int ant) {
+	// clear the scratch tree in place so its buffers are reused
+	s.MST.clear();
+	std::fill(s.vis.begin(), s.vis.end(), 0);
+	s.path.clear();
+
+	AntRng rng(seed, cur_iter, ant);
+	s.cur_pos = ant_init_pos[ant];
+	s.path.push_back(s.cur_pos);
+	while (!select_next(s, rng));
+}
+
 void ACO_STC::construct_solution() {
-	for (int ant = 0; ant < ant_num; ++ant) {
-		// clear vis and cur_MST
-		//cout << "-------------------------------------\n";
-		//cout << "No." << ant << "'s ant\n";
-		cur_pos = ant_init_pos[ant];
-		cur_MST = Mat(cell_num, vector<int>{});
-		vis = vector<bool>(cell_num, false);
-		while (!path.empty())	path.pop();
-
-		path.push(cur_pos);
-		while (!select_next());
-
-		int cur_turn = get_turns(cur_MST);
-		// cout << "cur_MST turn: " << get_turns(cur_MST) << "\n";
-		if (min_turn_this_iter > cur_turn) {
-			min_turn_this_iter = cur_turn;
-			cur_iter_best_MST = cur_MST;
-			cout << "cur_MST turn: " << cur_turn << "\n";
+	int threads = pool ? pool->size() : 1;
+	if (scratch.size() != threads) {
+		scratch.assign(threads, AntScratch());
+		for (auto &s : scratch) {
+			s.MST = MSTGrid(row, col);
+			s.vis.assign(cell_num, 0);
+			s.path.reserve(cell_num);
 		}
-		if (min_turn_so_far > min_turn_this_iter) {
-			min_turn_so_far = min_turn_this_iter;
-			best_MST = cur_MST;
+	}
+
+	// thread t builds ants t, t + threads, ... and keeps its first best one
+	std::function<void(int)> worker = [&](int t) {
+		AntScratch &s = scratch[t];
+		s.best_turns = 1234567890;
+		s.best_ant = -1;
+		for (int ant = t; ant < ant_num; ant += threads) {
+			construct_ant(s, ant);
+			int cur_turn = get_turns(s.MST);
+			if (cur_turn < s.best_turns) {
+				s.best_turns = cur_turn;
+				s.best_ant = ant;
+				s.best_MST = s.MST;
+			}
 		}
+	};
+
+	if (threads == 1)
+		worker(0);
+	else
+		pool->run(worker);
+
+	// lowest turns wins, ties go to the lowest ant index, as if the ants were built in order
+	AntScratch *best = nullptr;
+	for (auto &s : scratch) {
+		if (s.best_ant == -1)	continue;
+		if (!best || s.best_turns < best->best_turns || (s.best_turns == best->best_turns && s.best_ant < best->best_ant))
+			best = &s;
+	}
+	if (!best)	return;
 
-		//cout << "---------------------------------------\n";
+	if (min_turn_this_iter > best->best_turns) {
+		min_turn_this_iter = best->best_turns;
+		cur_iter_best_MST = best->best_MST;
+		TMSTC_LOG(DETAIL, "cur_MST turn: " << best->best_turns << "\n");
+	}
+	if (min_turn_so_far > min_turn_this_iter) {
+		min_turn_so_far = min_turn_this_iter;
+		best_MST = cur_iter_best_MST;
 	}
 }
 
 void ACO_STC::update_pheromone() {
+	int nb[4];
 	for (int i = 0; i < cur_iter_best_MST.size(); ++i) {
 		for (int j = 0; j < 4; ++j)	pheromone[i][j] *= (1 - pho);
-		for (int j = 0; j < cur_iter_best_MST[i].size(); ++j) {
-			if (cur_iter_best_MST[i][j] - i == -col)	 pheromone[i][0] += PHE / min_turn_this_iter;
-			else if (cur_iter_best_MST[i][j] - i == 1)	 pheromone[i][1] += PHE / min_turn_this_iter;
-			else if (cur_iter_best_MST[i][j] - i == col) pheromone[i][2] += PHE / min_turn_this_iter;
-			else									     pheromone[i][3] += PHE / min_turn_this_iter;
+		int degree = cur_iter_best_MST.neighbours(i, nb);
+		for (int j = 0; j < degree; ++j) {
+			if (nb[j] - i == -col)		 pheromone[i][0] += PHE / min_turn_this_iter;
+			else if (nb[j] - i == 1)	 pheromone[i][1] += PHE / min_turn_this_iter;
+			else if (nb[j] - i == col)	 pheromone[i][2] += PHE / min_turn_this_iter;
+			else						 pheromone[i][3] += PHE / min_turn_this_iter;
 		}
 	}
 }
 
 void ACO_STC::use_best_MST_phe() {
+	int nb[4], nb_to[4];
 	for (int i = 0; i < best_MST.size(); ++i) {
 		int turn_1 = 0, turn_2 = 0;
-		if (best_MST[i].size() == 3 || best_MST[i].size() == 1)		 turn_1 += 2;
-		else if (best_MST[i].size() == 4)							 turn_1 += 4;
+		int degree = best_MST.neighbours(i, nb);
+		if (degree == 3 || degree == 1)		 turn_1 += 2;
+		else if (degree == 4)				 turn_1 += 4;
 		else {
-			if (best_MST[i].size() == 2 && best_MST[i][0] + best_MST[i][1] != 2 * i)	turn_1 += 2;
+			if (degree == 2 && nb[0] + nb[1] != 2 * i)	turn_1 += 2;
 		}
 
-		for (int j = 0; j < best_MST[i].size(); ++j) {
-			int to = best_MST[i][j];
-			if (best_MST[to].size() == 3 || best_MST[to].size() == 1)		 turn_2 += 2;
-			else if (best_MST[to].size() == 4)								 turn_2 += 4;
+		for (int j = 0; j < degree; ++j) {
+			int to = nb[j];
+			int degree_to = best_MST.neighbours(to, nb_to);
+			if (degree_to == 3 || degree_to == 1)	 turn_2 += 2;
+			else if (degree_to == 4)				 turn_2 += 4;
 			else {
-				if (best_MST[to].size() == 2 && best_MST[to][0] + best_MST[to][1] != 2 * i)	turn_2 += 2;
+				if (degree_to == 2 && nb_to[0] + nb_to[1] != 2 * i)	turn_2 += 2;
 			}
 
-			if (best_MST[i][j] - i == -col)		 pheromone[i][0] += pheromone_init * 10 / (turn_1 + turn_2);
-			else if (best_MST[i][j] - i == 1)	 pheromone[i][1] += pheromone_init * 10 / (turn_1 + turn_2);
-			else if (best_MST[i][j] - i == col)  pheromone[i][2] += pheromone_init * 10 / (turn_1 + turn_2);
-			else								 pheromone[i][3] += pheromone_init * 10 / (turn_1 + turn_2);
+			if (to - i == -col)		 pheromone[i][0] += pheromone_init * 10 / (turn_1 + turn_2);
+			else if (to - i == 1)	 pheromone[i][1] += pheromone_init * 10 / (turn_1 + turn_2);
+			else if (to - i == col)  pheromone[i][2] += pheromone_init * 10 / (turn_1 + turn_2);
+			else					 pheromone[i][3] += pheromone_init * 10 / (turn_1 + turn_2);
 		}
 	}
 }
 
-Mat ACO_STC::aco_stc_solver() {
+MSTGrid ACO_STC::aco_stc_solver() {
 	clock_t start, finish;
 	start = clock();
 
+	init_ant_pos();
+	if (ant_num == 0)	return best_MST.empty() ? MSTGrid(row, col) : best_MST;
+
 	// use best construct tree as start
-	if(best_MST.size()){
+	if(!best_MST.empty()){
 		use_best_MST_phe();
 		min_turn_so_far = get_turns(best_MST);
 	}
 
+	// one pool for the whole run, the threads wait between iterations
+	int threads = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+	AntPool ant_pool(std::max(1, std::min(threads, ant_num)));
+	pool = &ant_pool;
+
 	int bad_times = 0;
 	int last_turns = 1234567890;
 	for (int it = 0; it < max_iter; ++it) {
 		if (bad_times > 20) {
-			cout << "bad luck. break...\n";
+			TMSTC_LOG(SUMMARY, "bad luck. break...\n");
+			break;
+		}
+		// only honour a stop request once best_MST holds a tree
+		if (it > 0 && stop_flag && stop_flag->load()) {
+			TMSTC_LOG(SUMMARY, "stop requested. break...\n");
 			break;
 		}
 
+		cur_iter = it;
 		reset();
 		construct_solution();
 		update_pheromone();
@@ -181,24 +306,25 @@ Mat ACO_STC::aco_stc_solver() {
 		else  bad_times++;
 	}
 
+	pool = nullptr;
+
 	finish = clock();
-	cout << "ACO_ST solver used time: " << finish - start << endl;
+	TMSTC_LOG(SUMMARY, "ACO_ST solver used time: " << finish - start << endl);
 	get_result_info();
-	cout << "-------------------ACO_STC Solver End-------------------\n\n";
+	TMSTC_LOG(SUMMARY, "-------------------ACO_STC Solver End-------------------\n\n");
 
-	return best_MST;
+	return best_MST.empty() ? MSTGrid(row, col) : best_MST;
 }
 
 void ACO_STC::get_result_info() {
-	std::cout << "The number of optimized MST's turn is: " << min_turn_so_far << std::endl;
+	TMSTC_LOG(SUMMARY, "The number of optimized MST's turn is: " << min_turn_so_far << std::endl);
 	int freecell = 0, edges = 0;
 	for (int i = 0; i < Map.size(); ++i)
-		for (int j = 0; j < Map[0].size(); ++j)
-			if (Map[i][j])	freecell++;
+		if (Map.test(i))	freecell++;
 
-	for (int i = 0; i < best_MST.size(); ++i)	edges += best_MST[i].size();
+	edges = best_MST.edgeCount();
 
-	std::cout << "free cells and edges: " << freecell << " " << edges / 2 << std::endl;
+	TMSTC_LOG(SUMMARY, "free cells and edges: " << freecell << " " << edges << std::endl);
 }
 
 //int main() {
@@ -0,0 +1,153 @@
+#include "Assignment.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+	bool validMatrix(const std::vector<std::vector<double>> &cost)
+	{
+		if (cost.empty() || cost[0].size() < cost.size())
+			return false;
+		for (const auto &row : cost)
+			if (row.size() != cost[0].size())
+				return false;
+		return true;
+	}
+
+	// Kuhn's augmenting path step over the edges with cost <= limit
+	bool augment(int r, double limit, const std::vector<std::vector<double>> &cost,
+				 std::vector<int> &col_owner, std::vector<char> &visited)
+	{
+		for (size_t c = 0; c < cost[r].size(); ++c)
+		{
+			if (cost[r][c] > limit || visited[c])
+				continue;
+			visited[c] = 1;
+			if (col_owner[c] < 0 || augment(col_owner[c], limit, cost, col_owner, visited))
+			{
+				col_owner[c] = r;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool perfectMatchingWithin(double limit, const std::vector<std::vector<double>> &cost)
+	{
+		std::vector<int> col_owner(cost[0].size(), -1);
+		std::vector<char> visited;
+		for (size_t r = 0; r < cost.size(); ++r)
+		{
+			visited.assign(cost[0].size(), 0);
+			if (!augment(r, limit, cost, col_owner, visited))
+				return false;
+		}
+		return true;
+	}
+}
+
+std::vector<int> minCostAssignment(const std::vector<std::vector<double>> &cost)
+{
+	if (!validMatrix(cost))
+		return {};
+
+	const int n = cost.size(), m = cost[0].size();
+	const double inf = std::numeric_limits<double>::infinity();
+
+	// 1-based: u, v are the row and column potentials, p[c] the row matched to column c, 0 for none
+	std::vector<double> u(n + 1, 0.0), v(m + 1, 0.0);
+	std::vector<int> p(m + 1, 0), way(m + 1, 0);
+	for (int i = 1; i <= n; ++i)
+	{
+		p[0] = i;
+		int c0 = 0;
+		std::vector<double> minv(m + 1, inf);
+		std::vector<char> used(m + 1, 0);
+		do
+		{
+			used[c0] = 1;
+			int r0 = p[c0], c1 = 0;
+			double delta = inf;
+			for (int c = 1; c <= m; ++c)
+			{
+				if (used[c])
+					continue;
+				double reduced = cost[r0 - 1][c - 1] - u[r0] - v[c];
+				if (reduced < minv[c])
+				{
+					minv[c] = reduced;
+					way[c] = c0;
+				}
+				if (minv[c] < delta)
+				{
+					delta = minv[c];
+					c1 = c;
+				}
+			}
+			for (int c = 0; c <= m; ++c)
+			{
+				if (used[c])
+				{
+					u[p[c]] += delta;
+					v[c] -= delta;
+				}
+				else
+					minv[c] -= delta;
+			}
+			c0 = c1;
+		} while (p[c0] != 0);
+
+		do
+		{
+			int c1 = way[c0];
+			p[c0] = p[c1];
+			c0 = c1;
+		} while (c0 != 0);
+	}
+
+	std::vector<int> assignment(n, -1);
+	for (int c = 1; c <= m; ++c)
+		if (p[c] != 0)
+			assignment[p[c] - 1] = c - 1;
+	return assignment;
+}
+
+std::vector<int> minMakespanAssignment(const std::vector<std::vector<double>> &cost)
+{
+	if (!validMatrix(cost))
+		return {};
+
+	std::vector<double> levels;
+	double total = 0.0;
+	for (const auto &row : cost)
+	{
+		levels.insert(levels.end(), row.begin(), row.end());
+		for (double c : row)
+			total += std::abs(c);
+	}
+	std::sort(levels.begin(), levels.end());
+	levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+
+	// The largest cost always admits a matching, so lo ends on the smallest one that does
+	size_t lo = 0, hi = levels.size() - 1;
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (perfectMatchingWithin(levels[mid], cost))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	const double makespan = levels[lo];
+
+	// Edges above the makespan cost more than any whole assignment within it, so the minimum total avoids them
+	const double excluded = 2.0 * total + 1.0;
+	std::vector<std::vector<double>> bounded = cost;
+	for (auto &row : bounded)
+		for (double &c : row)
+			if (c > makespan)
+				c = excluded;
+	return minCostAssignment(bounded);
+}
@@ -1,66 +1,63 @@
 #include <Dinic.h>
 
-
-Dinic dinic;
-
-Mat Dinic::dinic_solver(Mat& Map, bool merge) {
+MSTGrid Dinic::dinic_solver(BitGridView Map, bool merge) {
     clock_t start, finish;
     start = clock();
-    int n = Map.size(), m = Map[0].size();
+    int n = Map.rows(), m = Map.cols();
 
-    dinic.init(SINK + 5);
+    init(SINK + 5);
     int res = 0;
     for (int i = 0; i < n; ++i) {
         for (int j = 0; j < m; ++j) {
-            if (Map[i][j]) {
+            if (Map.test(i, j)) {
                 res++;
                 // connect source and sink
-                if (i > 0 && Map[i - 1][j]) {
+                if (i > 0 && Map.test(i - 1, j)) {
                     res--;
                     pts[HORZ(i - 1, j)] = true;
-                    dinic.add_edge(SOURCE, HORZ(i - 1, j), 1);
+                    add_edge(SOURCE, HORZ(i - 1, j), 1);
                 }
-                if (j > 0 && Map[i][j - 1]) {
+                if (j > 0 && Map.test(i, j - 1)) {
                     res--;
                     pts[VERT(i, j - 1)] = true;
-                    dinic.add_edge(VERT(i, j - 1), SINK, 1);
+                    add_edge(VERT(i, j - 1), SINK, 1);
                 }
 
                 // middle
-                if (i < n - 1 && j < m - 1 && Map[i + 1][j] && Map[i][j + 1]) {
-                    dinic.add_edge(HORZ(i, j), VERT(i, j), 1);
+                if (i < n - 1 && j < m - 1 && Map.test(i + 1, j) && Map.test(i, j + 1)) {
+                    add_edge(HORZ(i, j), VERT(i, j), 1);
                     pts[HORZ(i, j)] = pts[VERT(i, j)] = true;
                 }
-                if (i > 0 && j < m - 1 && Map[i - 1][j] && Map[i][j + 1]) {
-                    dinic.add_edge(HORZ(i - 1, j), VERT(i, j), 1);
+                if (i > 0 && j < m - 1 && Map.test(i - 1, j) && Map.test(i, j + 1)) {
+                    add_edge(HORZ(i - 1, j), VERT(i, j), 1);
                     pts[HORZ(i - 1, j)] = pts[VERT(i, j)] = true;
                 }
-                if (i < n - 1 && j > 0 && Map[i + 1][j] && Map[i][j - 1]) {
-                    dinic.add_edge(HORZ(i, j), VERT(i, j - 1), 1);
+                if (i < n - 1 && j > 0 && Map.test(i + 1, j) && Map.test(i, j - 1)) {
+                    add_edge(HORZ(i, j), VERT(i, j - 1), 1);
                     pts[HORZ(i, j)] = pts[VERT(i, j - 1)] = true;
                 }
-                if (i > 0 && j > 0 && Map[i - 1][j] && Map[i][j - 1]) {
-                    dinic.add_edge(HORZ(i - 1, j), VERT(i, j - 1), 1);
+                if (i > 0 && j > 0 && Map.test(i - 1, j) && Map.test(i, j - 1)) {
+                    add_edge(HORZ(i - 1, j), VERT(i, j - 1), 1);
                     pts[HORZ(i - 1, j)] = pts[VERT(i, j - 1)] = true;
                 }
             }
         }
     }
-    cout << res + dinic.Maxflow(SOURCE, SINK) << "\n";
-    dinic.get_cut(SOURCE);
+    int flow = res + Maxflow(SOURCE, SINK);
+    TMSTC_LOG(DETAIL, flow << "\n");
+    get_cut(SOURCE);
 
-    int tot = Map.size() * Map[0].size();
+    int tot = Map.size();
     fa.resize(tot + 5);
     for (int i = 0; i < tot; ++i)	fa[i] = i;
-    Mat MST(tot, vector<int>{});
+    MSTGrid MST(n, m);
 
     // horizontal node, make vertical edges
     for (int i = 1; i <= (n - 1) * m; ++i) {
         P p = getEdgeCoor(i, Map);
-        if (dinic.iscut[i] && pts[i]) {
+        if (iscut[i] && pts[i]) {
             // cout << i << " H: " << p.first << ", " << p.second << "\n";
-            MST[RESHAPE(p.first, p.second)].push_back(RESHAPE(p.first + 1, p.second));
-            MST[RESHAPE(p.first + 1, p.second)].push_back(RESHAPE(p.first, p.second));
+            MST.addEdge(RESHAPE(p.first, p.second), RESHAPE(p.first + 1, p.second));
             unite(RESHAPE(p.first, p.second), RESHAPE(p.first + 1, p.second));
         }
     }
@@ -68,10 +65,9 @@ Mat Dinic::dinic_solver(Mat& Map, bool merge) {
     // vertical node, make horizontal edges
     for (int i = 1; i <= n * (m - 1); ++i) {
         P p = getEdgeCoor(i + (n - 1) * m, Map);
-        if (!dinic.iscut[i + (n - 1) * m] && pts[i + (n - 1) * m]) {
+        if (!iscut[i + (n - 1) * m] && pts[i + (n - 1) * m]) {
             // cout << i + (n - 1) * m << " V: " << p.first << ", " << p.second << "\n";
-            MST[RESHAPE(p.first, p.second)].push_back(RESHAPE(p.first, p.second + 1));
-            MST[RESHAPE(p.first, p.second + 1)].push_back(RESHAPE(p.first, p.second));
+            MST.addEdge(RESHAPE(p.first, p.second), RESHAPE(p.first, p.second + 1));
             unite(RESHAPE(p.first, p.second), RESHAPE(p.first, p.second + 1));
         }
     }
@@ -80,9 +76,9 @@ Mat Dinic::dinic_solver(Mat& Map, bool merge) {
     if(!merge){
         finish = clock();
         auto duration = (finish - start) / CLOCKS_PER_SEC; 
-        cout << "dinic partition total used time: " << finish - start << " cycles (" << duration << "s) \n";
-        cout << "cycles per second: " << CLOCKS_PER_SEC << endl;
-        cout << "-------------------Dinic Solver End-------------------\n\n";
+        TMSTC_LOG(SUMMARY, "dinic partition total used time: " << finish - start << " cycles (" << duration << "s) \n");
+        TMSTC_LOG(SUMMARY, "cycles per second: " << CLOCKS_PER_SEC << endl);
+        TMSTC_LOG(SUMMARY, "-------------------Dinic Solver End-------------------\n\n");
 
         return MST; 
     }
@@ -96,13 +92,13 @@ Mat Dinic::dinic_solver(Mat& Map, bool merge) {
     for (int i = 0; i < MST.size(); ++i) {
         totalTurns += getVertexVal(MST, i);
     }
-    cout << "rect dinic MST number of turns: " << totalTurns << endl;
+    TMSTC_LOG(SUMMARY, "rect dinic MST number of turns: " << totalTurns << endl);
 
     checkMST(MST, Map);
 
-    cout << "dinic total used time: " << finish - start << " cycles (" << duration << "s) \n";
-    cout << "cycles per second: " << CLOCKS_PER_SEC << endl;
-    cout << "-------------------Dinic Solver End-------------------\n\n";
+    TMSTC_LOG(SUMMARY, "dinic total used time: " << finish - start << " cycles (" << duration << "s) \n");
+    TMSTC_LOG(SUMMARY, "cycles per second: " << CLOCKS_PER_SEC << endl);
+    TMSTC_LOG(SUMMARY, "-------------------Dinic Solver End-------------------\n\n");
 
     return MST;
 }
\ No newline at end of file
@@ -0,0 +1,373 @@
+#include "DubinsSmoothing.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// Dubins paths follow the normalized forms of Shkel and Lumelsky (2001): with the goal rotated onto the
+// +x axis and distances divided by the turn radius, every word LSL, RSR, LSR, RSL, RLR, LRL has closed form
+// segment lengths t, p, q.
+
+namespace
+{
+constexpr double EPS = 1e-9;
+
+double mod2pi(double a)
+{
+	a = std::fmod(a, 2 * M_PI);
+	return a < 0 ? a + 2 * M_PI : a;
+}
+
+// Signed heading change in (-pi, pi]
+double wrapAngle(double a)
+{
+	a = mod2pi(a);
+	return a > M_PI ? a - 2 * M_PI : a;
+}
+
+enum Word
+{
+	LSL,
+	RSR,
+	LSR,
+	RSL,
+	RLR,
+	LRL,
+	WORD_COUNT
+};
+
+// Per word, the turn direction of each segment: +1 left, -1 right, 0 straight
+const int WORD_SEGMENTS[WORD_COUNT][3] = {{1, 0, 1}, {-1, 0, -1}, {1, 0, -1}, {-1, 0, 1}, {-1, 1, -1}, {1, -1, 1}};
+
+// Normalized segment lengths of one word, false when the word cannot connect the poses
+bool wordSegments(Word word, double a, double b, double d, double seg[3])
+{
+	const double sa = std::sin(a), sb = std::sin(b), ca = std::cos(a), cb = std::cos(b);
+	const double cab = std::cos(a - b);
+
+	switch (word)
+	{
+	case LSL:
+	{
+		double p2 = 2 + d * d - 2 * cab + 2 * d * (sa - sb);
+		if (p2 < 0)
+			return false;
+		double tmp = std::atan2(cb - ca, d + sa - sb);
+		seg[0] = mod2pi(tmp - a);
+		seg[1] = std::sqrt(p2);
+		seg[2] = mod2pi(b - tmp);
+		return true;
+	}
+	case RSR:
+	{
+		double p2 = 2 + d * d - 2 * cab + 2 * d * (sb - sa);
+		if (p2 < 0)
+			return false;
+		double tmp = std::atan2(ca - cb, d - sa + sb);
+		seg[0] = mod2pi(a - tmp);
+		seg[1] = std::sqrt(p2);
+		seg[2] = mod2pi(tmp - b);
+		return true;
+	}
+	case LSR:
+	{
+		double p2 = -2 + d * d + 2 * cab + 2 * d * (sa + sb);
+		if (p2 < 0)
+			return false;
+		double p = std::sqrt(p2);
+		double tmp = std::atan2(-ca - cb, d + sa + sb) - std::atan2(-2.0, p);
+		seg[0] = mod2pi(tmp - a);
+		seg[1] = p;
+		seg[2] = mod2pi(tmp - b);
+		return true;
+	}
+	case RSL:
+	{
+		double p2 = -2 + d * d + 2 * cab - 2 * d * (sa + sb);
+		if (p2 < 0)
+			return false;
+		double p = std::sqrt(p2);
+		double tmp = std::atan2(ca + cb, d - sa - sb) - std::atan2(2.0, p);
+		seg[0] = mod2pi(a - tmp);
+		seg[1] = p;
+		seg[2] = mod2pi(b - tmp);
+		return true;
+	}
+	case RLR:
+	{
+		double tmp = (6 - d * d + 2 * cab + 2 * d * (sa - sb)) / 8;
+		if (std::abs(tmp) > 1)
+			return false;
+		double p = mod2pi(2 * M_PI - std::acos(tmp));
+		seg[0] = mod2pi(a - std::atan2(ca - cb, d - sa + sb) + p / 2);
+		seg[1] = p;
+		seg[2] = mod2pi(a - b - seg[0] + p);
+		return true;
+	}
+	case LRL:
+	{
+		double tmp = (6 - d * d + 2 * cab + 2 * d * (sb - sa)) / 8;
+		if (std::abs(tmp) > 1)
+			return false;
+		double p = mod2pi(2 * M_PI - std::acos(tmp));
+		seg[0] = mod2pi(-a - std::atan2(ca - cb, d + sa - sb) + p / 2);
+		seg[1] = p;
+		seg[2] = mod2pi(b - a - seg[0] + p);
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+// Shortest word between two poses, segment lengths normalized by R
+bool shortestWord(double x0, double y0, double h0, double x1, double y1, double h1, double R, Word &best, double seg[3])
+{
+	double dx = x1 - x0, dy = y1 - y0;
+	double d = std::hypot(dx, dy) / R;
+	double theta = d > EPS ? mod2pi(std::atan2(dy, dx)) : 0.0;
+	double a = mod2pi(h0 - theta), b = mod2pi(h1 - theta);
+
+	double best_len = std::numeric_limits<double>::infinity();
+	for (int w = 0; w < WORD_COUNT; ++w)
+	{
+		double s[3];
+		if (!wordSegments(static_cast<Word>(w), a, b, d, s))
+			continue;
+
+		double len = s[0] + s[1] + s[2];
+		if (len < best_len)
+		{
+			best_len = len;
+			best = static_cast<Word>(w);
+			std::copy(s, s + 3, seg);
+		}
+	}
+	return best_len < std::numeric_limits<double>::infinity();
+}
+
+// Polyline of the flown track in meters, with its analytic length
+class Track
+{
+public:
+	Track(double turn_radius, double arc_step) : R(turn_radius), arc_step(arc_step) {}
+
+	void start(double px, double py, double heading)
+	{
+		x = px;
+		y = py;
+		h = heading;
+		points.push_back({x, y});
+	}
+
+	void straight(double dist)
+	{
+		if (dist <= EPS)
+			return;
+		x += dist * std::cos(h);
+		y += dist * std::sin(h);
+		length += dist;
+		points.push_back({x, y});
+	}
+
+	// Arc of radius R, turning left for angle > 0
+	void turn(double angle)
+	{
+		if (std::abs(angle) <= EPS)
+			return;
+
+		double dir = angle > 0 ? 1.0 : -1.0;
+		double cx = x - dir * R * std::sin(h), cy = y + dir * R * std::cos(h);
+		int steps = std::max(1, static_cast<int>(std::ceil(std::abs(angle) / arc_step)));
+		double h0 = h;
+		for (int k = 1; k <= steps; ++k)
+		{
+			h = h0 + angle * k / steps;
+			x = cx + dir * R * std::sin(h);
+			y = cy - dir * R * std::cos(h);
+			points.push_back({x, y});
+		}
+		length += R * std::abs(angle);
+	}
+
+	// Shortest Dubins path from the current pose to (px, py, heading)
+	void dubinsTo(double px, double py, double heading)
+	{
+		Word word;
+		double seg[3];
+		if (!shortestWord(x, y, h, px, py, heading, R, word, seg))
+			return;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			int dir = WORD_SEGMENTS[word][k];
+			if (dir == 0)
+				straight(seg[k] * R);
+			else
+				turn(dir * seg[k]);
+		}
+		// Absorb rounding so the next leg starts exactly on the grid path
+		x = px;
+		y = py;
+		h = heading;
+		points.back() = {x, y};
+	}
+
+	double R, arc_step;
+	double x = 0, y = 0, h = 0;
+	double length = 0;
+	std::vector<std::pair<double, double>> points;
+};
+
+// Marks grid cells whose center lies within radius of the polyline
+void markCovered(const std::vector<std::pair<double, double>> &pts, double cellSize, double radius, int cols, int rows, std::vector<char> &covered)
+{
+	const double step = std::max(std::min(radius, cellSize) / 2, 1e-6);
+	const int reach = static_cast<int>(std::ceil(radius / cellSize));
+	auto markAround = [&](double px, double py)
+	{
+		int c0 = static_cast<int>(std::lround(px / cellSize)), r0 = static_cast<int>(std::lround(py / cellSize));
+		for (int r = std::max(0, r0 - reach); r <= std::min(rows - 1, r0 + reach); ++r)
+			for (int c = std::max(0, c0 - reach); c <= std::min(cols - 1, c0 + reach); ++c)
+			{
+				if (std::hypot(c * cellSize - px, r * cellSize - py) <= radius + EPS)
+					covered[r * cols + c] = 1;
+			}
+	};
+
+	// Sampled every half radius (or half cell), so a cell is only counted when a sample reaches it
+	for (size_t k = 0; k + 1 < pts.size(); ++k)
+	{
+		double dx = pts[k + 1].first - pts[k].first, dy = pts[k + 1].second - pts[k].second;
+		int n = std::max(1, static_cast<int>(std::ceil(std::hypot(dx, dy) / step)));
+		for (int i = 0; i < n; ++i)
+			markAround(pts[k].first + dx * i / n, pts[k].second + dy * i / n);
+	}
+	if (!pts.empty())
+		markAround(pts.back().first, pts.back().second);
+}
+}
+
+double dubinsDistance(double x0, double y0, double heading0, double x1, double y1, double heading1, double turn_radius)
+{
+	Word word;
+	double seg[3];
+	if (!shortestWord(x0, y0, heading0, x1, y1, heading1, turn_radius, word, seg))
+		return std::numeric_limits<double>::infinity();
+
+	// Straight segments are normalized by R as well
+	return (seg[0] + seg[1] + seg[2]) * turn_radius;
+}
+
+SmoothedPath smoothPathDubins(const std::vector<int> &path, int cols, const VehicleParameters &vp, double sensor_radius_m, double arc_step_rad)
+{
+	SmoothedPath out;
+	if (path.empty() || cols <= 0)
+		return out;
+
+	const double cs = vp.cellSize_m;
+	const double R = FixedWingCost(vp).turn_radius;
+	const double sensor = sensor_radius_m > 0 ? sensor_radius_m : cs / 2;
+
+	// Corner vertices: first cell, every cell where the step changes, last cell
+	std::vector<std::pair<double, double>> V;
+	auto cellPoint = [&](int idx)
+	{ return std::make_pair((idx % cols) * cs, (idx / cols) * cs); };
+	V.push_back(cellPoint(path[0]));
+	for (size_t k = 1; k + 1 < path.size(); ++k)
+	{
+		if (path[k] - path[k - 1] != path[k + 1] - path[k])
+			V.push_back(cellPoint(path[k]));
+	}
+	if (path.size() > 1)
+		V.push_back(cellPoint(path.back()));
+
+	// Legs between consecutive vertices
+	const int m = static_cast<int>(V.size()) - 1;
+	std::vector<double> L(std::max(m, 0)), H(std::max(m, 0));
+	for (int j = 0; j < m; ++j)
+	{
+		double dx = V[j + 1].first - V[j].first, dy = V[j + 1].second - V[j].second;
+		L[j] = std::hypot(dx, dy);
+		H[j] = L[j] > EPS ? std::atan2(dy, dx) : (j > 0 ? H[j - 1] : 0.0);
+	}
+
+	Track track(R, arc_step_rad);
+	track.start(V[0].first, V[0].second, m > 0 ? H[0] : 0.0);
+
+	auto distTo = [&](const std::pair<double, double> &p)
+	{ return std::hypot(p.first - track.x, p.second - track.y); };
+
+	// Fillet of the corner at V[j] is possible when both legs have room for the tangent points and the
+	// corner cell stays within the sensor radius of the arc
+	double start_trim = 0.0; // Part of the current leg already flown inside the previous fillet
+	auto filletFits = [&](int j, double theta)
+	{
+		if (std::abs(theta) >= M_PI - 1e-6)
+			return false;
+		double t = R * std::tan(std::abs(theta) / 2);
+		double next_room = (j == m - 1) ? L[j] : L[j] / 2;
+		double corner_miss = R * (1 / std::cos(std::abs(theta) / 2) - 1);
+		return t <= L[j - 1] - start_trim + EPS && t <= next_room + EPS && corner_miss <= sensor + EPS;
+	};
+
+	for (int j = 1; j < m;)
+	{
+		double theta = wrapAngle(H[j] - H[j - 1]);
+
+		if (filletFits(j, theta))
+		{
+			double t = R * std::tan(std::abs(theta) / 2);
+			track.straight(distTo(V[j]) - t);
+			track.turn(theta);
+			start_trim = t;
+			out.fillets++;
+			++j;
+			continue;
+		}
+
+		// Two quarter turns the same way with a short leg between them: adjacent boustrophedon lanes
+		if (j + 1 < m)
+		{
+			double next_theta = wrapAngle(H[j + 1] - H[j]);
+			bool quarter = std::abs(std::abs(theta) - M_PI / 2) < 1e-6 && std::abs(next_theta - theta) < 1e-6;
+			if (quarter && (L[j] < 2 * R - EPS || L[j] <= cs + EPS))
+			{
+				track.straight(distTo(V[j]));
+				track.dubinsTo(V[j + 1].first, V[j + 1].second, H[j + 1]);
+				start_trim = 0.0;
+				out.turnarounds++;
+				j += 2;
+				continue;
+			}
+		}
+
+		track.straight(distTo(V[j]));
+		track.dubinsTo(V[j].first, V[j].second, H[j]);
+		start_trim = 0.0;
+		out.loops++;
+		++j;
+	}
+	if (m > 0)
+		track.straight(distTo(V[m]));
+
+	out.length_m = track.length;
+	out.flight_time_s = track.length / vp.vmax;
+	out.waypoints.reserve(track.points.size());
+	for (const auto &p : track.points)
+		out.waypoints.push_back({p.first / cs, p.second / cs});
+
+	// Coverage of the grid cells by the waypoint polyline, which is what the vehicle is asked to follow
+	int max_idx = *std::max_element(path.begin(), path.end());
+	int rows = max_idx / cols + 1;
+	std::vector<char> on_path(rows * cols, 0), covered(rows * cols, 0);
+	for (int idx : path)
+		on_path[idx] = 1;
+	markCovered(track.points, cs, sensor, cols, rows, covered);
+	for (int i = 0; i < rows * cols; ++i)
+	{
+		out.cells += on_path[i];
+		out.covered_cells += on_path[i] && covered[i];
+	}
+	return out;
+}
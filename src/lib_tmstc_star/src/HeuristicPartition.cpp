@@ -1,14 +1,14 @@
 #include <HeuristicPartition.h>
 // #define DEBUG
 vector<vector<HeuristicSolver::rect>> HeuristicSolver::HeuristicPartition::chessboardPartition() {
-	set<int> lineX{ 0, (int)Map.size() }, lineY{ 0, (int)Map[0].size() };
-	for (int i = 0; i < Map.size(); ++i) {
-		for (int j = 0; j < Map[0].size(); ++j) {
+	set<int> lineX{ 0, Map.rows() }, lineY{ 0, Map.cols() };
+	for (int i = 0; i < Map.rows(); ++i) {
+		for (int j = 0; j < Map.cols(); ++j) {
 			// Make Flag
 			int flag = 0;
 			for (int k = 0; k < 4; ++k) {
 				int di = i + dir[k][0], dj = j + dir[k][1];
-				if (di < 0 || dj < 0 || di >= Map.size() || dj >= Map[0].size() || Map[di][dj] != Map[i][j])	continue;
+				if (di < 0 || dj < 0 || di >= Map.rows() || dj >= Map.cols() || Map.test(di, dj) != Map.test(i, j))	continue;
  
 				flag |= (1 << k);
 			}
@@ -44,7 +44,7 @@ vector<vector<HeuristicSolver::rect>> HeuristicSolver::HeuristicPartition::chess
 	for (int i = 0; i < X.size() - 1; ++i) {
 		y = 0;
 		for (int j = 0; j < Y.size() - 1; ++j) {
-			rec[i][j].empty = Map[x][y] == 0 ? true : false;
+			rec[i][j].empty = !Map.test(x, y);
 			rec[i][j].coordinate.first = x;
 			rec[i][j].coordinate.second = y;
 			y += width[j];
@@ -72,7 +72,7 @@ vector<vector<HeuristicSolver::rect>> HeuristicSolver::HeuristicPartition::chess
 	// }
 #endif
 
-	cout << "\nchessboard partition successfully.\n";
+	TMSTC_LOG(SUMMARY, "\nchessboard partition successfully.\n");
 
 	return rec;
 }
@@ -86,6 +86,12 @@ vector<vector<HeuristicSolver::rect>> HeuristicSolver::HeuristicPartition::orien
     std::mt19937 generator(rd());
 
 	for (int iter = 0; iter < max_iter; ++iter) {
+		// only honour a stop request once minRanksRec holds an orientation
+		if (iter > 0 && stop_flag && stop_flag->load()) {
+			TMSTC_LOG(SUMMARY, "stop requested at iteration " << iter << "\n");
+			break;
+		}
+
 		// randomize rec's orientation
 		unvisRec = {};
 		std::random_device rd;
@@ -111,7 +117,7 @@ vector<vector<HeuristicSolver::rect>> HeuristicSolver::HeuristicPartition::orien
 
 				// find best orientation for current rectangle, need to check both two directions
 				// hRank : 假设当前矩阵方向是水平的，计算本身及四领域的rank和，vRank与之相反
-				int hRank = height[y], vRank = width[x];
+				int hRank = height[x], vRank = width[y];
 				if (x > 0) {
 					hRank += rec[x - 1][y].dir == HORIZONTAL ? height[x - 1] : width[y];
 					vRank += rec[x - 1][y].dir == VERTICAL ? 0 : height[x - 1];
@@ -191,7 +197,7 @@ vector<vector<HeuristicSolver::rect>> HeuristicSolver::HeuristicPartition::orien
 				}
 				else {
 					curRanks += width[j];
-					for (int k = i; k < rec.size() && rec[k][j].dir == VERTICAL && !rec[i][k].empty; ++k)	vis[k][j] = true;
+					for (int k = i; k < rec.size() && rec[k][j].dir == VERTICAL && !rec[k][j].empty; ++k)	vis[k][j] = true;
 				}
 			}
 		}
@@ -201,19 +207,19 @@ vector<vector<HeuristicSolver::rect>> HeuristicSolver::HeuristicPartition::orien
 		}
 
 // #ifdef DEBUG
-		if(iter % 1000 == 0)	cout << "No. " << iter << "iter's totalranks: " << totalRanks << "\n";
+		if(iter % 1000 == 0)	TMSTC_LOG(DETAIL, "No. " << iter << "iter's totalranks: " << totalRanks << "\n");
 // #endif
 
 	} // end for iter
 
-	cout << "iteration: " << max_iter << endl;
-	cout << "minimum ranks: " << totalRanks << endl;
+	TMSTC_LOG(SUMMARY, "iteration: " << max_iter << endl);
+	TMSTC_LOG(SUMMARY, "minimum ranks: " << totalRanks << endl);
 
 	return minRanksRec;
 }
 
 void HeuristicSolver::HeuristicPartition::minrects2ranks(){
-    vector<vector<char>> directionMap(Map.size(), vector<char>(Map[0].size(), 'N'));
+    vector<vector<char>> directionMap(Map.rows(), vector<char>(Map.cols(), 'N'));
 	
     for(int i = 0; i < minRanksRec.size(); ++i){
         for(int j = 0; j < minRanksRec[0].size(); ++j){
@@ -232,8 +238,8 @@ void HeuristicSolver::HeuristicPartition::minrects2ranks(){
 
 	// check direction of each cell
 #ifdef DEBUG
-	for(int i = 0; i < Map.size(); ++i){
-		for(int j = 0; j < Map[0].size(); ++j){
+	for(int i = 0; i < Map.rows(); ++i){
+		for(int j = 0; j < Map.cols(); ++j){
 			char c = directionMap[i][j] == 'V' ? '|' : '-';
 			if(directionMap[i][j] == 'N')	c = 'N';
 			cout << c << " ";
@@ -242,24 +248,24 @@ void HeuristicSolver::HeuristicPartition::minrects2ranks(){
 	}
 #endif
 
-    for(int i = 0; i < Map.size(); ++i){
-        for(int j = 0; j < Map[0].size(); ++j){
+    for(int i = 0; i < Map.rows(); ++i){
+        for(int j = 0; j < Map.cols(); ++j){
             if(directionMap[i][j] == 'H'){
                 if(j > 0 && directionMap[i][j - 1] == 'H'){
-                    ranks[RESHAPE(i, j)].push_back(RESHAPE(i, j - 1));
+                    ranks.addEdge(RESHAPE(i, j), RESHAPE(i, j - 1));
                     uf.unite(RESHAPE(i, j), RESHAPE(i, j - 1));
                 }
-                if(j < Map[0].size() - 1 && directionMap[i][j + 1] == 'H'){
-                    ranks[RESHAPE(i, j)].push_back(RESHAPE(i, j + 1));
+                if(j < Map.cols() - 1 && directionMap[i][j + 1] == 'H'){
+                    ranks.addEdge(RESHAPE(i, j), RESHAPE(i, j + 1));
                     uf.unite(RESHAPE(i, j), RESHAPE(i, j + 1));
                 }
             } else if(directionMap[i][j] == 'V'){
                 if(i > 0 && directionMap[i - 1][j] == 'V'){
-                    ranks[RESHAPE(i, j)].push_back(RESHAPE(i - 1, j));
+                    ranks.addEdge(RESHAPE(i, j), RESHAPE(i - 1, j));
                     uf.unite(RESHAPE(i, j), RESHAPE(i - 1, j));
                 }
-                if(i < Map.size() - 1 && directionMap[i + 1][j] == 'V'){
-                    ranks[RESHAPE(i, j)].push_back(RESHAPE(i + 1, j));
+                if(i < Map.rows() - 1 && directionMap[i + 1][j] == 'V'){
+                    ranks.addEdge(RESHAPE(i, j), RESHAPE(i + 1, j));
                     uf.unite(RESHAPE(i, j), RESHAPE(i + 1, j));
                 }
             }
@@ -267,17 +273,17 @@ void HeuristicSolver::HeuristicPartition::minrects2ranks(){
     }
 }
 
-void HeuristicSolver::HeuristicPartition::mergeRanks(Mat& graph){
+void HeuristicSolver::HeuristicPartition::mergeRanks(MSTGrid& graph){
     vector<edge> edges;   //双向边
 	priority_queue<edge> que;
-	for (int i = 0; i < Map.size(); ++i) {
-		for (int j = 0; j < Map[0].size(); ++j) {
-			if (j < Map[0].size() - 1) 
-				if (Map[i][j] && Map[i][j + 1] && !uf.same(RESHAPE(i, j), RESHAPE(i, j + 1)))
+	for (int i = 0; i < Map.rows(); ++i) {
+		for (int j = 0; j < Map.cols(); ++j) {
+			if (j < Map.cols() - 1) 
+				if (Map.test(i, j) && Map.test(i, j + 1) && !uf.same(RESHAPE(i, j), RESHAPE(i, j + 1)))
                 	edges.push_back({ RESHAPE(i, j), RESHAPE(i, j + 1), 0 });
 			
-			if (i < Map.size() - 1) 
-				if (Map[i][j] && Map[i + 1][j] && !uf.same(RESHAPE(i, j), RESHAPE(i + 1, j)))
+			if (i < Map.rows() - 1) 
+				if (Map.test(i, j) && Map.test(i + 1, j) && !uf.same(RESHAPE(i, j), RESHAPE(i + 1, j)))
                 	edges.push_back({ RESHAPE(i, j), RESHAPE(i + 1, j), 0 });
 		}
 	}
@@ -302,14 +308,13 @@ void HeuristicSolver::HeuristicPartition::mergeRanks(Mat& graph){
 			continue;
 		}
 
-		graph[v1].push_back(v2);
-		graph[v2].push_back(v1);
+		graph.addEdge(v1, v2);
 		uf.unite(v1, v2);
 	}
 
 }
 
-HeuristicSolver::Mat HeuristicSolver::HeuristicPartition::hpSolver(bool merge){
+MSTGrid HeuristicSolver::HeuristicPartition::hpSolver(bool merge){
     vector<vector<rect>> rects = chessboardPartition();
     this->minRanksRec = orientRectangle(rects);
 	minrects2ranks();
@@ -319,9 +324,9 @@ HeuristicSolver::Mat HeuristicSolver::HeuristicPartition::hpSolver(bool merge){
 		for (int i = 0; i < ranks.size(); ++i) {
 			totalTurns += getVertexVal(ranks, i);
 		}
-		cout << "heuristic MST number of turns: " << totalTurns << endl;
+		TMSTC_LOG(SUMMARY, "heuristic MST number of turns: " << totalTurns << endl);
 
-		checkMST(ranks, Map);
+		checkMST(ranks);
 	}
 
 	return ranks;
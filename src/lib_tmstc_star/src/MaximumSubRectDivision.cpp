@@ -99,36 +99,171 @@ vector<rect> Division::findMaximumSubRect(Mat &Map)
 	return retvec;
 }
 
+// Largest sub rectangle (area > 1) whose bottom edge lies on the given row, from the row's column heights.
+// Same choice as findMaximumSubRect() makes within one row: the first column reaching the largest area.
+static rect rowMaximumSubRect(const vector<int> &height, int row, vector<int> &lef, vector<int> &sta)
+{
+	int cols = height.size();
+	rect best{{0, 0}, 0, 0, 0};
+
+	sta.clear();
+	for (int j = 0; j < cols; ++j)
+	{
+		while (!sta.empty() && height[sta.back()] >= height[j])
+			sta.pop_back();
+		lef[j] = sta.empty() ? 0 : sta.back() + 1;
+		sta.push_back(j);
+	}
+
+	sta.clear();
+	for (int j = cols - 1; j >= 0; --j)
+	{
+		while (!sta.empty() && height[sta.back()] >= height[j])
+			sta.pop_back();
+		int rig = sta.empty() ? cols - 1 : sta.back() - 1;
+		sta.push_back(j);
+
+		int area = (rig - lef[j] + 1) * height[j];
+		// Scanning right to left, so ties go to the leftmost column
+		if (area != 1 && area >= best.height * best.width && area > 0)
+		{
+			best.height = height[j];
+			best.width = rig - lef[j] + 1;
+			best.corner.first = row - height[j] + 1;
+			best.corner.second = lef[j];
+		}
+	}
+
+	return best;
+}
+
 // int edgesNum = 0;
-//  Divide the map into several sub-rectangles
-vector<rect> Division::maximumSubRectDivision(Mat &Map)
+//  Divide the map into several sub-rectangles.
+//  Gives the same rectangles, in the same order, as calling findMaximumSubRect() until the map is empty,
+//  but only rescans the rows whose column heights changed when a rectangle was removed.
+vector<rect> Division::maximumSubRectDivision(BitGrid &Map)
 {
 	vector<rect> ret;
-	int numVertex = 0;
-	for (int i = 0; i < Map.size(); ++i)
-		for (int j = 0; j < Map[0].size(); ++j)
-			numVertex += Map[i][j] ? 1 : 0;
-
+	int rows = Map.rows(), cols = Map.cols();
+	int numVertex = Map.count();
+
+	// Column heights of free cells ending at each row, and each row's largest rectangle
+	Mat height(rows, vector<int>(cols, 0));
+	for (int i = 0; i < rows; ++i)
+		for (int j = 0; j < cols; ++j)
+			height[i][j] = Map.test(i, j) ? (i ? height[i - 1][j] : 0) + 1 : 0;
+
+	vector<rect> rowBest(rows);
+	vector<int> lef(cols), sta;
+	sta.reserve(cols);
+
+	// Largest area first, then the upper row, like the row-major scan of findMaximumSubRect().
+	// Entries are not removed when a row changes, stale ones are skipped when they surface.
+	priority_queue<pair<int, int>> candidates;
+	auto updateRow = [&](int i)
+	{
+		rowBest[i] = rowMaximumSubRect(height[i], i, lef, sta);
+		int area = rowBest[i].height * rowBest[i].width;
+		if (area)
+			candidates.push({area, -i});
+	};
+	for (int i = 0; i < rows; ++i)
+		updateRow(i);
+
+	// Cells that may have become isolated, checked (and taken) in row-major order before the next rectangle
+	set<int> isolatedCandidates;
+	for (int i = 0; i < rows; ++i)
+		for (int j = 0; j < cols; ++j)
+			if (Map.test(i, j))
+				isolatedCandidates.insert(i * cols + j);
+
+	auto isFree = [&](int i, int j)
+	{ return i >= 0 && i < rows && j >= 0 && j < cols && Map.test(i, j); };
+
+	vector<char> dirtyRow(rows, 0);
 	while (numVertex)
 	{
-		vector<rect> tmp = findMaximumSubRect(Map);
-		for (int i = 0; i < tmp.size(); ++i)
+		for (int cell : isolatedCandidates)
 		{
-			numVertex -= tmp[i].height * tmp[i].width;
+			int i = cell / cols, j = cell % cols;
+			if (!Map.test(i, j) || isFree(i - 1, j) || isFree(i + 1, j) || isFree(i, j - 1) || isFree(i, j + 1))
+				continue;
+			// Neither the row's best rectangle nor the heights below depend on an isolated cell
+			Map.reset(i, j);
+			height[i][j] = 0;
+			numVertex--;
+			ret.push_back({{i, j}, 1, 1, BOTH_ORI});
+		}
+		isolatedCandidates.clear();
 
-			if (tmp[i].height > tmp[i].width)
-				tmp[i].dir = VERTICAL;
-			else if (tmp[i].height < tmp[i].width)
-				tmp[i].dir = HORIZONTAL;
-			else
-				tmp[i].dir = BOTH_ORI;
+		rect best{{0, 0}, 0, 0, 0};
+		while (!candidates.empty())
+		{
+			pair<int, int> top = candidates.top();
+			int i = -top.second;
+			if (rowBest[i].height * rowBest[i].width == top.first)
+			{
+				best = rowBest[i];
+				break;
+			}
+			candidates.pop();
+		}
+		if (best.height * best.width == 0)
+			continue;
+
+		numVertex -= best.height * best.width;
 
-			for (int row = tmp[i].corner.first; row < tmp[i].corner.first + tmp[i].height; ++row)
-				for (int col = tmp[i].corner.second; col < tmp[i].corner.second + tmp[i].width; ++col)
-					Map[row][col] = 0;
+		if (best.height > best.width)
+			best.dir = VERTICAL;
+		else if (best.height < best.width)
+			best.dir = HORIZONTAL;
+		else
+			best.dir = BOTH_ORI;
+
+		int r0 = best.corner.first, r1 = r0 + best.height - 1;
+		int c0 = best.corner.second, c1 = c0 + best.width - 1;
+		for (int row = r0; row <= r1; ++row)
+			for (int col = c0; col <= c1; ++col)
+				Map.reset(row, col);
 
-			ret.push_back(tmp[i]);
+		// Heights below the rectangle shrink until a column hits an obstacle
+		for (int col = c0; col <= c1; ++col)
+		{
+			for (int row = r0; row < rows; ++row)
+			{
+				int h = Map.test(row, col) ? (row ? height[row - 1][col] : 0) + 1 : 0;
+				if (row > r1 && h == height[row][col])
+					break;
+				height[row][col] = h;
+				dirtyRow[row] = 1;
+			}
+		}
+		for (int row = r0; row < rows; ++row)
+		{
+			if (dirtyRow[row])
+			{
+				dirtyRow[row] = 0;
+				updateRow(row);
+			}
+		}
+
+		// Only cells next to the removed rectangle can lose their last free neighbour
+		for (int row = r0; row <= r1; ++row)
+		{
+			if (isFree(row, c0 - 1))
+				isolatedCandidates.insert(row * cols + c0 - 1);
+			if (isFree(row, c1 + 1))
+				isolatedCandidates.insert(row * cols + c1 + 1);
+		}
+		for (int col = c0; col <= c1; ++col)
+		{
+			if (isFree(r0 - 1, col))
+				isolatedCandidates.insert((r0 - 1) * cols + col);
+			if (isFree(r1 + 1, col))
+				isolatedCandidates.insert((r1 + 1) * cols + col);
 		}
+
+		ret.push_back(best);
 	}
 
 	return ret;
@@ -137,7 +272,7 @@ vector<rect> Division::maximumSubRectDivision(Mat &Map)
 void Division::orientRect(vector<rect> &rectVec)
 {
 	// Record the rectangle number for each cell to make lookup faster
-	Mat label(Map.size(), vector<int>(Map[0].size(), 0));
+	Mat label(Map.rows(), vector<int>(Map.cols(), 0));
 	for (int i = 0; i < rectVec.size(); ++i)
 	{
 		for (int row = rectVec[i].corner.first; row < rectVec[i].corner.first + rectVec[i].height; ++row)
@@ -169,7 +304,7 @@ void Division::orientRect(vector<rect> &rectVec)
 			{
 				// Check the boundary and surrounding area of the rectangle
 				int upper = rectVec[i].corner.first - 1, lower = rectVec[i].corner.first + rectVec[i].height;
-				if (upper >= 0 && Map[upper][col] && lower < Map.size() && Map[lower][col])
+				if (upper >= 0 && Map.test(upper, col) && lower < Map.rows() && Map.test(lower, col))
 				{
 					if (rectVec[label[upper][col]].dir != HORIZONTAL && rectVec[label[lower][col]].dir != HORIZONTAL)
 					{
@@ -182,14 +317,14 @@ void Division::orientRect(vector<rect> &rectVec)
 					else if (rectVec[label[upper][col]].dir == HORIZONTAL && rectVec[label[lower][col]].dir == HORIZONTAL)
 						verticalCost++;
 				}
-				else if (upper >= 0 && Map[upper][col])
+				else if (upper >= 0 && Map.test(upper, col))
 				{
 					if (rectVec[label[upper][col]].dir == HORIZONTAL)
 						verticalCost++;
 					else if (rectVec[label[upper][col]].dir == BOTH_ORI)
 						verticalRectSet.insert(label[upper][col]);
 				}
-				else if (lower < Map.size() && Map[lower][col])
+				else if (lower < Map.rows() && Map.test(lower, col))
 				{
 					if (rectVec[label[lower][col]].dir == HORIZONTAL)
 						verticalCost++;
@@ -204,7 +339,7 @@ void Division::orientRect(vector<rect> &rectVec)
 			for (int row = rectVec[i].corner.first; row < rectVec[i].corner.first + rectVec[i].height; ++row)
 			{
 				int lef = rectVec[i].corner.second - 1, rig = rectVec[i].corner.second + rectVec[i].width;
-				if (lef >= 0 && Map[row][lef] && rig < Map[0].size() && Map[row][rig])
+				if (lef >= 0 && Map.test(row, lef) && rig < Map.cols() && Map.test(row, rig))
 				{
 					if (rectVec[label[row][lef]].dir != VERTICAL && rectVec[label[row][rig]].dir != VERTICAL)
 					{
@@ -217,14 +352,14 @@ void Division::orientRect(vector<rect> &rectVec)
 					else if (rectVec[label[row][lef]].dir == VERTICAL && rectVec[label[row][rig]].dir == VERTICAL)
 						horizontalCost++;
 				}
-				else if (lef >= 0 && Map[row][lef])
+				else if (lef >= 0 && Map.test(row, lef))
 				{
 					if (rectVec[label[row][lef]].dir == VERTICAL)
 						horizontalCost++;
 					else if (rectVec[label[row][lef]].dir == BOTH_ORI)
 						horizontalRectSet.insert(label[row][lef]);
 				}
-				else if (rig < Map[0].size() && Map[row][rig])
+				else if (rig < Map.cols() && Map.test(row, rig))
 				{
 					if (rectVec[label[row][rig]].dir == VERTICAL)
 						horizontalCost++;
@@ -260,11 +395,11 @@ void Division::orientRect(vector<rect> &rectVec)
 void Division::constructMST(vector<rect> &rectVec)
 {
 	// initialize u&f tree and graph
-	int tot = Map.size() * Map[0].size();
+	int tot = Map.size();
 	fa.resize(tot + 5);
 	for (int i = 0; i < tot; ++i)
 		fa[i] = i;
-	MST.resize(tot, vector<int>{});
+	MST = MSTGrid(Map.rows(), Map.cols());
 	// Mat graph(tot, vector<int>{});
 
 	for (int i = 0; i < rectVec.size(); ++i)
@@ -280,8 +415,7 @@ void Division::constructMST(vector<rect> &rectVec)
 				for (int col = rectVec[i].corner.second; col < rectVec[i].corner.second + rectVec[i].width; ++col)
 				{
 					// cout << "*** " << "(" << row << ", " << col << ")" << " *** " << reshape(row, col) << " " << reshape(row + 1, col) << endl;
-					MST[reshape(row, col)].push_back(reshape(row + 1, col));
-					MST[reshape(row + 1, col)].push_back(reshape(row, col));
+					MST.addEdge(reshape(row, col), reshape(row + 1, col));
 					unite(reshape(row, col), reshape(row + 1, col));
 				}
 			}
@@ -292,8 +426,7 @@ void Division::constructMST(vector<rect> &rectVec)
 			{
 				for (int col = rectVec[i].corner.second; col < rectVec[i].corner.second + rectVec[i].width - 1; ++col)
 				{
-					MST[reshape(row, col)].push_back(reshape(row, col + 1));
-					MST[reshape(row, col + 1)].push_back(reshape(row, col));
+					MST.addEdge(reshape(row, col), reshape(row, col + 1));
 					unite(reshape(row, col), reshape(row, col + 1));
 				}
 			}
@@ -305,20 +438,20 @@ void Division::constructMST(vector<rect> &rectVec)
 
 // (a + b) / 2 = c means three points lie in the same line
 // 2n edges, each edge is connected to the MST, and then the connected components are merged
-void Division::mergeMST(Mat &graph)
+void Division::mergeMST(MSTGrid &graph)
 {
 	vector<edge> edges; // double edges
 	priority_queue<edge> que;
-	for (int i = 0; i < Map.size(); ++i)
+	for (int i = 0; i < Map.rows(); ++i)
 	{
-		for (int j = 0; j < Map[0].size(); ++j)
+		for (int j = 0; j < Map.cols(); ++j)
 		{
-			if (j < Map[0].size() - 1)
-				if (!same(reshape(i, j), reshape(i, j + 1)) && Map[i][j] && Map[i][j + 1])
+			if (j < Map.cols() - 1)
+				if (!same(reshape(i, j), reshape(i, j + 1)) && Map.test(i, j) && Map.test(i, j + 1))
 					edges.push_back({reshape(i, j), reshape(i, j + 1), 0});
 
-			if (i < Map.size() - 1)
-				if (!same(reshape(i, j), reshape(i + 1, j)) && Map[i][j] && Map[i + 1][j])
+			if (i < Map.rows() - 1)
+				if (!same(reshape(i, j), reshape(i + 1, j)) && Map.test(i, j) && Map.test(i + 1, j))
 					edges.push_back({reshape(i, j), reshape(i + 1, j), 0});
 		}
 	}
@@ -348,37 +481,31 @@ void Division::mergeMST(Mat &graph)
 			continue;
 		}
 
-		graph[v1].push_back(v2);
-		graph[v2].push_back(v1);
+		graph.addEdge(v1, v2);
 		unite(v1, v2);
 	}
 }
 
-bool Division::checkMST(Mat &graph, Mat &Map)
+bool Division::checkMST(const MSTGrid &graph)
 {
 	int vertexNum = 0;
-	for (int i = 0; i < Map.size(); ++i)
-		for (int j = 0; j < Map[0].size(); ++j)
-			if (Map[i][j])
-				vertexNum++;
+	for (int w = 0; w < Map.wordCount(); ++w)
+		vertexNum += __builtin_popcountll(Map.word(w));
 
-	int edgeNum = 0;
-	for (int i = 0; i < graph.size(); ++i)
-		edgeNum += graph[i].size();
-	edgeNum /= 2;
+	int edgeNum = graph.edgeCount();
 
-	cout << "The number of edges: " << edgeNum << endl;
-	cout << "The number of vertexes: " << vertexNum << endl;
+	TMSTC_LOG(DETAIL, "The number of edges: " << edgeNum << endl);
+	TMSTC_LOG(DETAIL, "The number of vertexes: " << vertexNum << endl);
 	if (edgeNum != vertexNum - 1)
 		return false;
 	return true;
 }
 
-Mat Division::rectDivisionSolver()
+MSTGrid Division::rectDivisionSolver()
 {
 	clock_t start, finish;
 	start = clock();
-	Mat copyMap = Map;
+	BitGrid copyMap(Map);
 
 	vector<rect> ans = maximumSubRectDivision(copyMap);
 
@@ -390,7 +517,7 @@ Mat Division::rectDivisionSolver()
 	mergeMST(MST);
 
 	finish = clock();
-	cout << "rect division solver used time: " << finish - start << endl;
+	TMSTC_LOG(SUMMARY, "rect division solver used time: " << finish - start << endl);
 
 	// calculate the number of turns
 	int totalTurns = 0;
@@ -398,33 +525,33 @@ Mat Division::rectDivisionSolver()
 	{
 		totalTurns += getVertexVal(MST, i);
 	}
-	cout << "rect division solver's number of turns: " << totalTurns << endl;
+	TMSTC_LOG(SUMMARY, "rect division solver's number of turns: " << totalTurns << endl);
 
-	checkMST(MST, Map);
+	checkMST(MST);
 
-	cout << "-------------------RectDiv Solver End-------------------" << endl;
+	TMSTC_LOG(SUMMARY, "-------------------RectDiv Solver End-------------------" << endl);
 
 	return MST;
 }
 
-#define IS_VALID(x, y) (x >= 0 && x < Map.size() && y >= 0 && y < Map[0].size() && Map[x][y] && !vis[reshape(x, y)])
-stack<P> stk; // Prevent stack overflow, so use recursion
-vector<bool> vis;
-Mat Division::dfsWithStackSolver(unsigned char dfsDir)
+#define IS_VALID(x, y) (Map.free(x, y) && !vis[reshape(x, y)])
+MSTGrid Division::dfsWithStackSolver(unsigned char dfsDir)
 {
 	clock_t start, finish;
 	start = clock();
 
-	Mat dfsGraph(Map.size() * Map[0].size(), vector<int>{});
-	vis.resize(Map.size() * Map[0].size());
-	fill(vis.begin(), vis.end(), false);
+	// Kept local (not file-scope) so several Division instances can run concurrently
+	stack<P> stk; // Prevent stack overflow, so use an explicit stack instead of recursion
+	vector<bool> vis(Map.size(), false);
+
+	MSTGrid dfsGraph(Map.rows(), Map.cols());
 	P vertex = {-1, -1};
 
-	for (int i = 0; i < Map.size(); ++i)
+	for (int i = 0; i < Map.rows(); ++i)
 	{
-		for (int j = 0; j < Map[0].size(); ++j)
+		for (int j = 0; j < Map.cols(); ++j)
 		{
-			if (Map[i][j])
+			if (Map.test(i, j))
 			{
 				vertex.first = i;
 				vertex.second = j;
@@ -448,16 +575,15 @@ Mat Division::dfsWithStackSolver(unsigned char dfsDir)
 		if (vis[curEdge.second])
 			continue;
 
-		dfsGraph[curEdge.first].push_back(curEdge.second);
-		dfsGraph[curEdge.second].push_back(curEdge.first);
+		dfsGraph.addEdge(curEdge.first, curEdge.second);
 		vis[curEdge.first] = true;
 		vis[curEdge.second] = true;
 
 		for (int i = 3; i >= 0; --i)
 		{
 			// curEdge.second turn to 2D coordinate
-			int x = curEdge.second / Map[0].size();
-			int y = curEdge.second % Map[0].size();
+			int x = curEdge.second / Map.cols();
+			int y = curEdge.second % Map.cols();
 			int dx = x + (dfsDir == VERTICAL ? dir[i][0] : dir2[i][0]);
 			int dy = y + (dfsDir == VERTICAL ? dir[i][1] : dir2[i][1]);
 			if (IS_VALID(dx, dy))
@@ -469,10 +595,10 @@ Mat Division::dfsWithStackSolver(unsigned char dfsDir)
 
 	finish = clock();
 	if (dfsDir == VERTICAL)
-		cout << "vertical ";
+		TMSTC_LOG(SUMMARY, "vertical ");
 	else
-		cout << "horizontal ";
-	cout << "dfs used time: " << finish - start << endl;
+		TMSTC_LOG(SUMMARY, "horizontal ");
+	TMSTC_LOG(SUMMARY, "dfs used time: " << finish - start << endl);
 
 	int totalTurns = 0;
 	for (int i = 0; i < dfsGraph.size(); ++i)
@@ -481,32 +607,32 @@ Mat Division::dfsWithStackSolver(unsigned char dfsDir)
 	}
 
 	if (dfsDir == VERTICAL)
-		cout << "vertical ";
+		TMSTC_LOG(SUMMARY, "vertical ");
 	else
-		cout << "horizontal ";
-	cout << "dfs' number of turns: " << totalTurns << endl;
+		TMSTC_LOG(SUMMARY, "horizontal ");
+	TMSTC_LOG(SUMMARY, "dfs' number of turns: " << totalTurns << endl);
 
-	checkMST(dfsGraph, Map);
+	checkMST(dfsGraph);
 
-	cout << "-----------------DFS MST Solver End---------------------" << endl;
+	TMSTC_LOG(SUMMARY, "-----------------DFS MST Solver End---------------------" << endl);
 
 	return dfsGraph;
 }
 
-Mat Division::bfsSolver(unsigned char bfsDir)
+MSTGrid Division::bfsSolver(unsigned char bfsDir)
 {
 	clock_t start, finish;
 	start = clock();
-	Mat bfsGraph(Map.size() * Map[0].size(), vector<int>{});
-	std::vector<bool> vis(Map.size() * Map[0].size(), false);
+	MSTGrid bfsGraph(Map.rows(), Map.cols());
+	std::vector<bool> vis(Map.size(), false);
 	std::queue<P> id_que;
 
 	bool flag = false;
-	for (int i = 0; i < Map.size(); ++i)
+	for (int i = 0; i < Map.rows(); ++i)
 	{
-		for (int j = 0; j < Map[0].size(); ++j)
+		for (int j = 0; j < Map.cols(); ++j)
 		{
-			if (Map[i][j])
+			if (Map.test(i, j))
 			{
 				for (int k = 0; k < 4; ++k)
 				{
@@ -537,12 +663,11 @@ Mat Division::bfsSolver(unsigned char bfsDir)
 		}
 
 		vis[p.second] = true;
-		bfsGraph[p.first].push_back(p.second);
-		bfsGraph[p.second].push_back(p.first);
+		bfsGraph.addEdge(p.first, p.second);
 		for (int i = 0; i < 4; ++i)
 		{
-			int dx = p.second / Map[0].size() + (bfsDir == VERTICAL ? dir[i][0] : dir2[i][0]);
-			int dy = p.second % Map[0].size() + (bfsDir == VERTICAL ? dir[i][1] : dir2[i][1]);
+			int dx = p.second / Map.cols() + (bfsDir == VERTICAL ? dir[i][0] : dir2[i][0]);
+			int dy = p.second % Map.cols() + (bfsDir == VERTICAL ? dir[i][1] : dir2[i][1]);
 
 			if (IS_VALID(dx, dy))
 			{
@@ -552,7 +677,7 @@ Mat Division::bfsSolver(unsigned char bfsDir)
 	}
 
 	finish = clock();
-	cout << "BFS solver used time: " << finish - start << endl;
+	TMSTC_LOG(SUMMARY, "BFS solver used time: " << finish - start << endl);
 
 	int totalTurns = 0;
 	for (int i = 0; i < bfsGraph.size(); ++i)
@@ -560,37 +685,37 @@ Mat Division::bfsSolver(unsigned char bfsDir)
 		totalTurns += getVertexVal(bfsGraph, i);
 	}
 
-	cout << "BFS' number of turns: " << totalTurns << endl;
+	TMSTC_LOG(SUMMARY, "BFS' number of turns: " << totalTurns << endl);
 
-	checkMST(bfsGraph, Map);
+	checkMST(bfsGraph);
 
-	cout << "------------------BFS Solver End--------------------" << endl;
+	TMSTC_LOG(SUMMARY, "------------------BFS Solver End--------------------" << endl);
 
 	return bfsGraph;
 }
 
-Mat Division::kruskalSolver()
+MSTGrid Division::kruskalSolver()
 {
 	clock_t start, finish;
 	start = clock();
 
 	vector<P> edges; // costs all equal to 1
-	int tot = Map.size() * Map[0].size();
+	int tot = Map.size();
 	fa.resize(tot + 5);
 	for (int i = 0; i < tot; ++i)
 		fa[i] = i;
 
-	Mat kruskalGraph(tot, vector<int>{});
-	for (int i = 0; i < Map.size(); ++i)
+	MSTGrid kruskalGraph(Map.rows(), Map.cols());
+	for (int i = 0; i < Map.rows(); ++i)
 	{
-		for (int j = 0; j < Map[0].size(); ++j)
+		for (int j = 0; j < Map.cols(); ++j)
 		{
-			if (!Map[i][j])
+			if (!Map.test(i, j))
 				continue;
 
-			if (i + 1 < Map.size() && Map[i + 1][j])
+			if (i + 1 < Map.rows() && Map.test(i + 1, j))
 				edges.push_back({reshape(i, j), reshape(i + 1, j)});
-			if (j + 1 < Map[0].size() && Map[i][j + 1])
+			if (j + 1 < Map.cols() && Map.test(i, j + 1))
 				edges.push_back({reshape(i, j), reshape(i, j + 1)});
 		}
 	}
@@ -600,14 +725,13 @@ Mat Division::kruskalSolver()
 		int from = edges[i].first, to = edges[i].second;
 		if (!same(from, to))
 		{
-			kruskalGraph[from].push_back(to);
-			kruskalGraph[to].push_back(from);
+			kruskalGraph.addEdge(from, to);
 			unite(from, to);
 		}
 	}
 
 	finish = clock();
-	cout << "kruskal solver used time: " << finish - start << endl;
+	TMSTC_LOG(SUMMARY, "kruskal solver used time: " << finish - start << endl);
 
 	int totalTurns = 0;
 	for (int i = 0; i < kruskalGraph.size(); ++i)
@@ -615,11 +739,11 @@ Mat Division::kruskalSolver()
 		totalTurns += getVertexVal(kruskalGraph, i);
 	}
 
-	cout << "kruskal' number of turns: " << totalTurns << endl;
+	TMSTC_LOG(SUMMARY, "kruskal' number of turns: " << totalTurns << endl);
 
-	checkMST(kruskalGraph, Map);
+	checkMST(kruskalGraph);
 
-	cout << "------------------Kruskal Solver End--------------------" << endl;
+	TMSTC_LOG(SUMMARY, "------------------Kruskal Solver End--------------------" << endl);
 
 	return kruskalGraph;
 }
@@ -0,0 +1,147 @@
+#include "PathCut.h"
+
+#include "GeomUtils.h"
+
+// Batch path cost kernels. Each walks a contiguous index path once; the per-element work is kept
+// branch-free over plain arrays so the compiler can vectorize it, and segmentAngle() is only
+// called once per distinct pair of step directions.
+
+namespace
+{
+// Steps of up to TURN_TABLE_REACH cells per axis (every step of an uncut coverage path) hit the table
+constexpr int TURN_TABLE_REACH = 2;
+constexpr int TURN_TABLE_SIDE = 2 * TURN_TABLE_REACH + 1;
+
+// |segmentAngle| only depends on the two step vectors, so it is tabulated once per process
+const vector<double> &turnAngleTable()
+{
+	static const vector<double> table = []
+	{
+		vector<double> t(TURN_TABLE_SIDE * TURN_TABLE_SIDE * TURN_TABLE_SIDE * TURN_TABLE_SIDE);
+		int k = 0;
+		for (int dx1 = -TURN_TABLE_REACH; dx1 <= TURN_TABLE_REACH; ++dx1)
+			for (int dy1 = -TURN_TABLE_REACH; dy1 <= TURN_TABLE_REACH; ++dy1)
+				for (int dx2 = -TURN_TABLE_REACH; dx2 <= TURN_TABLE_REACH; ++dx2)
+					for (int dy2 = -TURN_TABLE_REACH; dy2 <= TURN_TABLE_REACH; ++dy2)
+						t[k++] = std::abs(segmentAngle(0, 0, dx1, dy1, dx1 + dx2, dy1 + dy2));
+		return t;
+	}();
+	return table;
+}
+
+inline bool inTable(int d)
+{
+	return d >= -TURN_TABLE_REACH && d <= TURN_TABLE_REACH;
+}
+
+// One pass over the path with the cost model inlined
+template <typename Model>
+void evaluateWith(const Model &model, const int *path, size_t n, double cellSize, int mapCols, PathCostBreakdown &out)
+{
+	// Segment travel times, independent per segment
+	out.segment_times.resize(n - 1);
+	for (size_t j = 0; j + 1 < n; ++j)
+	{
+		double dx = (path[j] / mapCols - path[j + 1] / mapCols) * cellSize;
+		double dy = (path[j] % mapCols - path[j + 1] % mapCols) * cellSize;
+		out.segment_times[j] = model.segment(std::sqrt(dx * dx + dy * dy));
+	}
+
+	out.turn_flags.resize(n);
+	markTurns(path, n, out.turn_flags.data());
+
+	// Angles only where the path turns
+	out.turn_angles.assign(n, 0.0);
+	for (size_t j = 1; j + 1 < n; ++j)
+	{
+		if (out.turn_flags[j])
+			out.turn_angles[j] = turnAngle(path[j - 1], path[j], path[j + 1], mapCols);
+	}
+
+	// Totals are summed in path order, like computePathCost()
+	for (size_t j = 0; j + 1 < n; ++j)
+	{
+		out.travel_time += out.segment_times[j];
+		if (out.turn_flags[j + 1])
+		{
+			out.turn_time += model.turn(out.turn_angles[j + 1]);
+			out.turns++;
+		}
+	}
+	out.total = out.travel_time + out.turn_time;
+}
+
+template <typename Model>
+double pathCostWith(const Model &model, const int *p, size_t n, double cellSize, int mapCols)
+{
+	double totalCost = 0.0;
+	double turnCost = 0.0;
+	for (size_t j = 0; j + 1 < n; ++j)
+	{
+		double dx = (p[j] / mapCols - p[j + 1] / mapCols) * cellSize;
+		double dy = (p[j] % mapCols - p[j + 1] % mapCols) * cellSize;
+		totalCost += model.segment(std::sqrt(dx * dx + dy * dy));
+
+		if (j + 2 < n && !PathCut::isSameLine(p[j], p[j + 1], p[j + 2]))
+			turnCost += model.turn(Model::USES_TURN_ANGLE ? turnAngle(p[j], p[j + 1], p[j + 2], mapCols) : GRID_TURN_DEG);
+	}
+	return totalCost + turnCost;
+}
+}
+
+double turnAngle(int p0, int p1, int p2, int mapCols)
+{
+	int p0x = p0 % mapCols, p0y = p0 / mapCols;
+	int p1x = p1 % mapCols, p1y = p1 / mapCols;
+	int p2x = p2 % mapCols, p2y = p2 / mapCols;
+
+	int dx1 = p1x - p0x, dy1 = p1y - p0y;
+	int dx2 = p2x - p1x, dy2 = p2y - p1y;
+	if (inTable(dx1) && inTable(dy1) && inTable(dx2) && inTable(dy2))
+	{
+		int k = (((dx1 + TURN_TABLE_REACH) * TURN_TABLE_SIDE + dy1 + TURN_TABLE_REACH) * TURN_TABLE_SIDE + dx2 + TURN_TABLE_REACH) * TURN_TABLE_SIDE + dy2 + TURN_TABLE_REACH;
+		return turnAngleTable()[k];
+	}
+
+	return std::abs(segmentAngle(p0x, p0y, p1x, p1y, p2x, p2y));
+}
+
+void markTurns(const int *path, size_t n, unsigned char *turn_flags)
+{
+	if (n == 0)
+		return;
+
+	turn_flags[0] = 0;
+	turn_flags[n - 1] = 0;
+	for (size_t j = 1; j + 1 < n; ++j)
+		turn_flags[j] = path[j - 1] + path[j + 1] != 2 * path[j];
+}
+
+int countTurns(const int *path, size_t n)
+{
+	int turns = 0;
+	for (size_t j = 1; j + 1 < n; ++j)
+		turns += path[j - 1] + path[j + 1] != 2 * path[j];
+	return turns;
+}
+
+void evaluatePathCost(const int *path, size_t n, const VehicleParameters &vehicleParams, int mapCols, PathCostBreakdown &out)
+{
+	out = PathCostBreakdown();
+	if (n < 2)
+		return;
+
+	withCostModel(vehicleParams, [&](const auto &model)
+				  { evaluateWith(model, path, n, vehicleParams.cellSize_m, mapCols, out); });
+}
+
+double computePathCost(const std::vector<int> &path, const VehicleParameters &vehicleParams, int mapCols)
+{
+	// Assuming path is a vector of (cover) grid indices, compute the cost based on the vehicle parameters
+	if (path.size() < 2)
+		return 0.0;
+
+	// Same pass as evaluatePathCost(), without keeping the per element terms
+	return withCostModel(vehicleParams, [&](const auto &model)
+						 { return pathCostWith(model, path.data(), path.size(), vehicleParams.cellSize_m, mapCols); });
+}
@@ -4,34 +4,31 @@
 
 #include <functional>
 #include <limits>
-
-#include<set>
-
-#include "GeomUtils.h"
-
-// Define a hash function for std::tuple
-struct tuple_hash
-{
-	template <class T>
-	std::size_t operator()(const T &tuple) const
-	{
-		return std::hash<std::string>{}(std::to_string(std::get<0>(tuple)) + "," +
-										std::to_string(std::get<1>(tuple)) + "," +
-										std::to_string(std::get<2>(tuple)));
-	}
-};
+#include <chrono>
 
 // Filter valid points from a path
 std::vector<int> PathCut::filterValidPoints(const std::vector<int> &path)
 {
 	std::vector<int> valid_points;
 
-	// If no filtering function is provided, consider all points valid
-	if (!is_point_filtered_func)
+	// If no filter is provided, consider all points valid
+	if (!hasPointFilter())
+	{
+		return path;
+	}
+
+	// A mask that misses the region entirely filters nothing
+	const bool useMask = pointFilterMask.size() == Region.size();
+	if (useMask && !pointFilterMask.intersects(Region))
 	{
 		return path;
 	}
 
+	auto isFiltered = [&](int point)
+	{
+		return useMask ? pointFilterMask.test(point) : is_point_filtered_func(point);
+	};
+
 	// //print all depos
 	// for (auto d : depot)
 	// {
@@ -39,22 +36,28 @@ std::vector<int> PathCut::filterValidPoints(const std::vector<int> &path)
 	// 	Logger::info("Depot: " + std::to_string(d));
 	// }
 
-	std::set<int> ignored_points;
+	BitGrid ignored_points(bigrows, bigcols);
+	vector<int> depotsAt(Region.size(), 0); // Number of depots on each cell
+	for (int d : depot)
+		depotsAt[d]++;
 
+	valid_points.reserve(path.size());
 	for (int i = 0; i < path.size(); ++i)
 	{
 		int point = path[i];
 
-		if (!is_point_filtered_func(point))
+		if (!isFiltered(point))
 		{
 			valid_points.push_back(point);
 		}
 		else
 		{
-			ignored_points.insert(point); // Store ignored points for later reference
+			ignored_points.set(point); // Store ignored points for later reference
 			// std::cout << "Filtered point: " << point << std::endl;
 			
 			// If point is any depot, change depot to next point
+			if (depotsAt[point] == 0)
+				continue;
 			auto it = std::find(depot.begin(), depot.end(), point);
 			if (it != depot.end())
 			{
@@ -65,9 +68,8 @@ std::vector<int> PathCut::filterValidPoints(const std::vector<int> &path)
 				// If point is depot, change depot to next point
 				// keep changing until next point is not already a depot
 				auto inc = 1;
-				auto next_depot = std::find(depot.begin(), depot.end(), path[(i + inc) % path.size()]); 
 				while ( 
-					( next_depot != depot.end() || ignored_points.find( path[(i + inc) % path.size()]) != ignored_points.end())
+					( depotsAt[path[(i + inc) % path.size()]] > 0 || ignored_points.test(path[(i + inc) % path.size()]))
 					&& (inc < max_iterations)
 				)
 				{
@@ -75,10 +77,11 @@ std::vector<int> PathCut::filterValidPoints(const std::vector<int> &path)
 					// Logger::info("Changing depot to next point: " + std::to_string(path[(i + inc) % path.size()]));
 					
 					inc++;
-					next_depot = std::find(depot.begin(), depot.end(), path[(i + inc) % path.size()]);
 				}
 
 				*it = path[(i + inc) % path.size()]; // Change depot to next point
+				depotsAt[point]--;
+				depotsAt[*it]++;
 				
 				if (inc >= max_iterations)
 				{
@@ -86,8 +89,8 @@ std::vector<int> PathCut::filterValidPoints(const std::vector<int> &path)
 					Logger::error("Max iterations reached while changing depot to next point: " + std::to_string(path[(i + inc) % path.size()]));
 				}
 				
-				std::cout << "Changed depot to next point: " << *it << std::endl;
-				Logger::info("Changed depot to next point: " + std::to_string(*it));
+				TMSTC_LOG(SUMMARY, "Changed depot to next point: " << *it << std::endl);
+				TMSTC_LOG_INFO(SUMMARY, "Changed depot to next point: " + std::to_string(*it));
 			}
 		}
 	}
@@ -110,20 +113,18 @@ std::vector<int> PathCut::filterValidPoints(const std::vector<int> &path)
 // MST2Path is undirected graph, so it contains (i, j) and (j, i)
 void PathCut::MST2Path()
 {
-	vector<unordered_set<int>> vis(Map.size() * Map[0].size(), std::unordered_set<int>{});
 	pathEdge.resize(bigcols * bigrows, vector<int>{});
 
 	// ROS uses x and y when arranging paths, be careful here, bigcols corresponds to x in mapServer map
+	// Each tree edge is visited once, from its left/upper end
 	for (int from = 0; from < MST.size(); ++from)
 	{
-		for (auto to : MST[from])
+		for (MSTEdge e : {MST_RIGHT, MST_DOWN})
 		{
-			if ((!vis[from].empty() && vis[from].find(to) != vis[from].end()) ||
-				(!vis[to].empty() && vis[to].find(from) != vis[to].end()))
+			if (!MST.hasEdge(from, e))
 				continue;
 
-			vis[from].insert(to);
-			vis[to].insert(from);
+			int to = (e == MST_RIGHT) ? from + 1 : from + smallcols;
 
 			int x1, x2, y1, y2;
 			get2DCoordinateMap(from, x1, y1);
@@ -137,7 +138,7 @@ void PathCut::MST2Path()
 			int p8 = 2 * x2 * bigcols + 2 * y2 + 1;
 			int p7 = (2 * x2 + 1) * bigcols + 2 * y2 + 1;
 
-			if (abs(from - to) == 1)
+			if (e == MST_RIGHT)
 			{
 				// horizontal edges
 				pathEdge[p1].push_back(p2);
@@ -156,11 +157,11 @@ void PathCut::MST2Path()
 		}
 	}
 
-	for (int i = 0; i < Map.size(); ++i)
+	for (int i = 0; i < smallrows; ++i)
 	{
-		for (int j = 0; j < Map[0].size(); ++j)
+		for (int j = 0; j < smallcols; ++j)
 		{
-			if (!Map[i][j]) // Skip obstacles
+			if (!Map.test(i, j)) // Skip obstacles
 				continue;
 			int x = 2 * i, y = 2 * j;
 			int cur = i * smallcols + j;
@@ -169,22 +170,22 @@ void PathCut::MST2Path()
 			int p3 = (x + 1) * bigcols + y;
 			int p4 = (x + 1) * bigcols + y + 1;
 
-			if (j == 0 || vis[cur].find(cur - 1) == vis[cur].end())
+			if (j == 0 || !MST.hasEdge(cur, MST_LEFT))
 			{
 				pathEdge[p1].push_back(p3);
 				pathEdge[p3].push_back(p1);
 			}
-			if (j == smallcols - 1 || vis[cur].find(cur + 1) == vis[cur].end())
+			if (j == smallcols - 1 || !MST.hasEdge(cur, MST_RIGHT))
 			{
 				pathEdge[p2].push_back(p4);
 				pathEdge[p4].push_back(p2);
 			}
-			if (i == 0 || vis[cur].find(cur - smallcols) == vis[cur].end())
+			if (i == 0 || !MST.hasEdge(cur, MST_UP))
 			{
 				pathEdge[p1].push_back(p2);
 				pathEdge[p2].push_back(p1);
 			}
-			if (i == smallrows - 1 || vis[cur].find(cur + smallcols) == vis[cur].end())
+			if (i == smallrows - 1 || !MST.hasEdge(cur, MST_DOWN))
 			{
 				pathEdge[p3].push_back(p4);
 				pathEdge[p4].push_back(p3);
@@ -192,12 +193,12 @@ void PathCut::MST2Path()
 		}
 	}
 
-	std::cout << "Generating: Get path edges\n";
+	TMSTC_LOG(DETAIL, "Generating: Get path edges\n");
 
 	// After getting pathEdge, next step is to obtain the path sequence pathSequence and its reverse sequence
 	// pathSequence starts from the position of the first robot
 	// pathSequence's length equals the circle length, invSequence is different
-	vector<bool> inPath(Region[0].size() * Region.size(), false);
+	vector<bool> inPath(Region.size(), false);
 	int cur = depot[0];
 	while (!inPath[depot[0]] || cur != depot[0])
 	{
@@ -219,34 +220,35 @@ void PathCut::MST2Path()
 	circleLen = pathSequence.size();
 
 	// STEP 1: Filter points if a filtering function is provided
+	auto filterStart = std::chrono::steady_clock::now();
 	std::vector<int> original_path = pathSequence;
 	std::vector<int> valid_points;
 
-	std::cout << "Original points: " << original_path.size() << std::endl;
-	Logger::info("TMSTC - Original points: " + std::to_string(original_path.size()));
+	TMSTC_LOG(SUMMARY, "Original points: " << original_path.size() << std::endl);
+	TMSTC_LOG_INFO(SUMMARY, "TMSTC - Original points: " + std::to_string(original_path.size()));
 
-	if (is_point_filtered_func)
+	if (hasPointFilter())
 	{
-		std::cout << "Filtering points based on custom criteria..." << std::endl;
+		TMSTC_LOG(SUMMARY, "Filtering points based on custom criteria..." << std::endl);
 		valid_points = filterValidPoints(original_path);
 
 		if (valid_points.size() < original_path.size())
 		{
-			std::cout << "Filtered out " << (original_path.size() - valid_points.size())
-					  << " points (" << (100.0 * (original_path.size() - valid_points.size()) / original_path.size())
-					  << "% reduction)" << std::endl;
-			Logger::info("TMSTC - Filtered out " + std::to_string(original_path.size() - valid_points.size()) +
-						 " points (" + std::to_string(100.0 * (original_path.size() - valid_points.size()) / original_path.size()) + "% reduction)");
+			TMSTC_LOG(SUMMARY, "Filtered out " << (original_path.size() - valid_points.size())
+										<< " points (" << (100.0 * (original_path.size() - valid_points.size()) / original_path.size())
+										<< "% reduction)" << std::endl);
+			TMSTC_LOG_INFO(SUMMARY, "TMSTC - Filtered out " + std::to_string(original_path.size() - valid_points.size()) +
+										" points (" + std::to_string(100.0 * (original_path.size() - valid_points.size()) / original_path.size()) + "% reduction)");
 			// If we have a very small number of valid points, maintain the original path
 			if (valid_points.size() < 3)
 			{
-				std::cout << "Too few valid points. Using original path." << std::endl;
+				TMSTC_LOG(SUMMARY, "Too few valid points. Using original path." << std::endl);
 				valid_points = original_path;
 			}
 		}
 		else
 		{
-			std::cout << "No points were filtered out." << std::endl;
+			TMSTC_LOG(SUMMARY, "No points were filtered out." << std::endl);
 		}
 	}
 	else
@@ -257,123 +259,89 @@ void PathCut::MST2Path()
 	// STEP 2: If points were filtered, compute an optimized tour through valid points
 	if (valid_points.size() < original_path.size() && valid_points.size() >= 3)
 	{
-		std::cout << "Optimizing path with outliers..." << std::endl;
-		Logger::info("TMSTC - Optimizing path with outliers...");
+		TMSTC_LOG(SUMMARY, "Optimizing path with outliers..." << std::endl);
+		TMSTC_LOG_INFO(SUMMARY, "TMSTC - Optimizing path with outliers...");
 		optimizePathWithOutliersAndUpdateSequence(valid_points);
 		circleLen = pathSequence.size();
 
-		Logger::info("TMSTC - Path optimized with outliers: " + std::to_string(pathSequence.size()) + " points");
-		std::cout << "Path optimized with outliers: " << pathSequence.size() << " points" << std::endl;
+		TMSTC_LOG_INFO(SUMMARY, "TMSTC - Path optimized with outliers: " + std::to_string(pathSequence.size()) + " points");
+		TMSTC_LOG(SUMMARY, "Path optimized with outliers: " << pathSequence.size() << " points" << std::endl);
 	}
+	phaseTimes.filtering_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - filterStart).count();
 
-	std::cout << "Generating: Trim labels\n";
+	TMSTC_LOG(DETAIL, "Generating: Trim labels\n");
 	// Convert label->sequential label
-	invSequence.resize(Region.size() * Region[0].size(), -1);
+	invSequence.resize(Region.size(), -1);
 	for (int i = 0; i < pathSequence.size(); ++i)
 	{
 		invSequence[pathSequence[i]] = i; // Maps each fine-grid cell index to its position in pathSequence, useful for lookups.
 	}
 
 	// construct path value vec
-	// Turning once is equivalent to going through 2 more cells
 	// Note: turning from the first to the last connected point also counts
+	TMSTC_LOG(DETAIL, "Generating: Path value with the vehicle cost model\n");
+	TMSTC_LOG_INFO(DETAIL, "TMSTC - Generating path value with the vehicle cost model");
+	buildPathValues();
 
-#ifdef OLD_COST
-	pathValue.resize(2 * circleLen, 1.0);
-	for (int i = 1; i < 2 * circleLen - 1; ++i)
-	{
-		if (!isSameLine(pathSequence[(i - 1 + circleLen) % circleLen], pathSequence[i % circleLen], pathSequence[(i + 1) % circleLen]) && i != 2 * circleLen - 1)
-			pathValue[i] += ONE_TURN_VAL;
+	TMSTC_LOG(SUMMARY, "Finish Constructing Path from ideal spanning tree.\n");
+	TMSTC_LOG_INFO(SUMMARY, "TMSTC - Finish constructing path from ideal spanning tree.");
+	// checking path and its value
+	/*cout << "display path sequence...\n";
+	for (auto i : pathSequence)	cout << i << " ";
+	cout << "----------------------------------------------" << endl;
+	cout << "display path value...\n";
+	for (auto i : pathValues[0])	cout << i << " ";
+	cout << "----------------------------------------------" << endl;*/
+}
+
+// One prefix cost array per distinct vehicle of the fleet, robots with equal parameters share one
+void PathCut::buildPathValues()
+{
+	vector<VehicleParameters> built{vehicleParams};
+	pathValues.assign(1, vector<double>());
+	withCostModel(vehicleParams, [this](const auto &model)
+				  { buildPathValue(model, pathValues[0]); });
 
-		pathValue[i] += pathValue[i - 1];
+	depotPathValue.assign(depot.size(), 0);
+	for (int d = 0; d < robotParams.size(); ++d)
+	{
+		int k = std::find(built.begin(), built.end(), robotParams[d]) - built.begin();
+		if (k == built.size())
+		{
+			built.push_back(robotParams[d]);
+			pathValues.emplace_back();
+			withCostModel(robotParams[d], [this](const auto &model)
+						  { buildPathValue(model, pathValues.back()); });
+		}
+		depotPathValue[d] = k;
 	}
-	pathValue[2 * circleLen - 1] += pathValue[2 * circleLen - 2];
-#else
-	std::cout << "Generating: Path value with new Cost definition to match speed parameters def\n";
-	Logger::info("TMSTC - Generating path value with new Cost definition to match speed parameters def");
-
-	double omega = vehicleParams.omega_rad;		// rad/s (angular velocity)
-	double a = vehicleParams.acc;				// m/s^2 (acceleration)
-	double vmax = vehicleParams.vmax;			// m/s (max velocity)
-	double cellSize = vehicleParams.cellSize_m; // meters (grid cell size)
-	double phi = vehicleParams.phi_max_rad;		// rad (max banking angle)
-
-	// Computed turn radius
-	const double turn_radius = (vmax * vmax) / (gravity * std::tan(phi)); // Turn radius in meters
-	std::function<double(double)> turn_time = [&](double theta){return (turn_radius * theta) / vmax ; };			  // Time for a turn based on angle
-
-	// Resize pathValue to 2 * circleLen to accommodate the double cycle for multiple robots
-	pathValue.resize(2 * circleLen, 0.0);
-	// Build pathValue with cumulative costs over two cycles
+}
+
+// value[i] is the cost of the first i steps of the circle, unrolled over two laps so that any arc of
+// at most one lap is a single subtraction (arcCost). A turn's cost is added with the segment into it.
+template <typename Model>
+void PathCut::buildPathValue(const Model &model, vector<double> &value)
+{
+	value.assign(2 * circleLen, 0.0);
 	for (int i = 0; i < 2 * circleLen - 1; ++i)
 	{
 		int prev = i % circleLen;
 		int curr = (i + 1) % circleLen;
 
-		// Calculate distance between consecutive points
-		double distance = calculateDistance(pathSequence[prev], pathSequence[curr]);
-
-		// Compute segment time tj
-		double tj;
-#ifdef USE_UAV_COST
-		tj = distance / vmax;
-#else
-		// Segment time tj: sqrt(4d/a) if d < vmax^2/a, else d/vmax + vmax/a (Time under acceleration limit, else time with max velocity reached)
-		tj = (distance < (vmax * vmax) / a) ? std::sqrt(4 * distance / a) : (distance / vmax + vmax / a);
-#endif
+		value[i + 1] = value[i] + model.segment(calculateDistance(pathSequence[prev], pathSequence[curr]));
 
-		// Add segment time to pathValue
-		pathValue[i + 1] = pathValue[i] + tj;
-
-		// Check for a turn at curr (skip if at start or end of the double cycle)
+		// Check for a turn at curr (skip if at the end of the double cycle)
 		if (i < 2 * circleLen - 2)
 		{
 			int next = (i + 2) % circleLen;
 			if (!isSameLine(pathSequence[prev], pathSequence[curr], pathSequence[next]))
 			{
-				double turnCost = 0.0;
-// Add turn costs (assuming 90-degree turns, cost = turn_time)
-#ifdef USE_UAV_COST
-				// Vectors: v1 = P_{i-1} to P_i, v2 = P_i to P_{i+1}
-				int p0 = pathSequence[prev], p1 = pathSequence[curr], p2 = pathSequence[next];
-				double p0x = p0 % smallcols, p0y = p0 / smallcols; // x and y coordinates of p0
-				double p1x = p1 % smallcols, p1y = p1 / smallcols; // x and y coordinates of p1
-				double p2x = p2 % smallcols, p2y = p2 / smallcols; // x and y coordinates of p2
-
-				// double v1x = (p1 % smallcols - p0 % smallcols) * cellSize; // x-component
-				// double v1y = (p1 / smallcols - p0 / smallcols) * cellSize; // y-component
-				// double v2x = (p2 % smallcols - p1 % smallcols) * cellSize;
-				// double v2y = (p2 / smallcols - p1 / smallcols) * cellSize;
-				
-				// // Compute turn angle theta
-				// double dot = v1x * v2x + v1y * v2y;
-				// double det = v1x * v2y - v1y * v2x;
-				// double theta = std::abs(std::atan2(det, dot)); // Absolute angle in [0, pi]
-
-				
-				double theta = std::abs(segmentAngle(p0x,p0y,p1x,p1y, p2x,p2y)); // Angle between two vectors in radians
-
-				turnCost = turn_time(theta); // 90-degree turn time	// cost = turn_time)
-#else
-				turnCost = (M_PI / (2 * omega)); // 90-degree turn time // cost = pi/(2*omega))
-#endif
-
-				pathValue[i + 1] += turnCost; // Add turn cost after segment
-				// Logger::info("TMSTC - Adding cost: " + std::to_string(pathValue[i + 1]) + " at index " + std::to_string(i + 1));
+				// Angle between v1 = P_{i-1} to P_i and v2 = P_i to P_{i+1}, tabulated per step direction pair
+				double theta = Model::USES_TURN_ANGLE ? turnAngle(pathSequence[prev], pathSequence[curr], pathSequence[next], smallcols) : GRID_TURN_DEG;
+				value[i + 1] += model.turn(theta);
 			}
 		}
 	}
-#endif
-
-	cout << "Finish Constructing Path from ideal spanning tree.\n";
-	Logger::info("TMSTC - Finish constructing path from ideal spanning tree.");
-	// checking path and its value
-	/*cout << "display path sequence...\n";
-	for (auto i : pathSequence)	cout << i << " ";
-	cout << "----------------------------------------------" << endl;
-	cout << "display path value...\n";
-	for (auto i : pathValue)	cout << i << " ";
-	cout << "----------------------------------------------" << endl;*/
 }
 
 double PathCut::euclidean_dis(double x1, double y1, double x2, double y2)
@@ -381,130 +349,139 @@ double PathCut::euclidean_dis(double x1, double y1, double x2, double y2)
 	return std::sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
 }
 
-#ifdef OLD_COST
-// u and v are one-dimensional coordinates under region, when generating edges, we need to convert to 2D coordinates to check boundaries
-// To avoid this problem, we need to use flags to judge whether the diagonal edge surrounds an obstacle, otherwise we would later need to set the dis array to infinity; it's better to use A*
-// A* can handle coordinate transformations properly
 double PathCut::A_star(int u, int v)
 {
-	// Use A* on the original map and region
-	std::priority_queue<node> que;
-	int sx = u / bigcols, sy = u % bigcols;
-	int ex = u / bigcols, ey = u % bigcols;
+	return withCostModel(vehicleParams, [&](const auto &model)
+						 { return A_star(u, v, model); });
+}
+
+// Shortest travel cost between two region cells, turns counted as 90-degree turns of the model
+template <typename Model>
+double PathCut::A_star(int u, int v, const Model &model)
+{
+	counters.astar_calls++;
+	std::priority_queue<node> que; // node: {fx, gx, id}
+
+	const double cellSize = vehicleParams.cellSize_m;
+	const double stepCost = model.segment(cellSize);
+	const double turnCost = model.turn(GRID_TURN_DEG);
+
 	vector<double> dis(bigcols * bigrows, 2e9);
 	vector<int> pre(bigcols * bigrows, -1);
 	dis[u] = 0;
 
-	que.push({0 + euclidean_dis(1.0 * sx, 1.0 * sy, 1.0 * ex, 1.0 * ey), 0, u});
+	int sx = u / bigcols, sy = u % bigcols;
+	int ex = v / bigcols, ey = v % bigcols;
+	que.push({model.lowerBound(euclidean_dis(sx, sy, ex, ey) * cellSize), 0, u});
+
 	while (!que.empty())
 	{
 		node cur = que.top();
 		que.pop();
+		counters.nodes_expanded++;
 		if (cur.id == v)
 			break;
-		if (cur.gx - dis[cur.id] > eps)
+		if (cur.gx > dis[cur.id] + eps)
 			continue;
 
 		int cx = cur.id / bigcols, cy = cur.id % bigcols;
 		for (int i = 0; i < 4; ++i)
 		{
 			int dx = cx + dir[i][0], dy = cy + dir[i][1];
-			if (dx < 0 || dx >= bigrows || dy < 0 || dy >= bigcols || !Region[dx][dy])
+			if (!Region.free(dx, dy))
 				continue;
 
 			int nxt_id = dx * bigcols + dy;
-			if (dis[nxt_id] > dis[cur.id] + 1.0)
+
+			// Add turn cost if there's a previous point
+			double newCost = dis[cur.id] + stepCost;
+			if (pre[cur.id] != -1 && !isSameLine(pre[cur.id], cur.id, nxt_id))
+				newCost += turnCost;
+
+			if (newCost < dis[nxt_id])
 			{
+				dis[nxt_id] = newCost;
 				pre[nxt_id] = cur.id;
-				dis[nxt_id] = dis[cur.id] + 1.0;
-				que.push({dis[nxt_id] + euclidean_dis(dx, dy, ex, ey), dis[nxt_id], nxt_id});
+				que.push({newCost + model.lowerBound(euclidean_dis(dx, dy, ex, ey) * cellSize), newCost, nxt_id});
 			}
 		}
 	}
 
-	int hair = v, head = pre[v], cur;
-	double turnVal = 0.0;
-	if (head == -1 || head == u)
-		return dis[v];
-
-	cur = pre[head];
-	do
-	{
-		if (!isSameLine(hair, head, cur))
-			turnVal += ONE_TURN_VAL;
-		hair = head;
-		head = cur;
-		cur = pre[cur];
-	} while (head != u);
-
-	return dis[v] + turnVal;
+	return dis[v];
 }
 
-#else
+// Single-source Dijkstra over (cell, heading) states so turn penalties are exact, using the same step and
+// turn costs as A_star with each depot's own vehicle. Paths reversed have the same steps and turns, so one
+// field per depot answers both the depot->cut start and cut end->depot legs of updateCutVal.
+void PathCut::buildDepotDistanceFields()
+{
+	depotDistField.assign(depot.size(), vector<double>());
+	for (int d = 0; d < depot.size(); ++d)
+		withCostModel(depotParams(d), [&](const auto &model)
+					  { buildDepotDistanceField(d, model); });
+}
 
-double PathCut::A_star(int u, int v)
+template <typename Model>
+void PathCut::buildDepotDistanceField(int d, const Model &model)
 {
-	std::priority_queue<node> que; // node: {fx, gx, id}
+	const double stepCost = model.segment(vehicleParams.cellSize_m);
+	const double turnCost = model.turn(GRID_TURN_DEG);
 
-	double a = vehicleParams.acc;
-	double omega = vehicleParams.omega_rad;
-	double vmax = vehicleParams.vmax;
-	double cellSize = vehicleParams.cellSize_m;
+	const int cells = bigrows * bigcols;
+	vector<double> dis(4 * cells, 2e9);
+	vector<double> &field = depotDistField[d];
+	field.assign(cells, 2e9);
 
-	vector<double> dis(bigcols * bigrows, 2e9);
-	vector<int> pre(bigcols * bigrows, -1);
-	dis[u] = 0;
+	int u = depot[d];
+	field[u] = 0;
 
-	int sx = u / bigcols, sy = u % bigcols;
-	int ex = v / bigcols, ey = v % bigcols;
-	que.push({euclidean_dis(sx, sy, ex, ey), 0, u});
+	// state = cell * 4 + heading of the step that entered the cell
+	std::priority_queue<node> que;
+	int ux = u / bigcols, uy = u % bigcols;
+	for (int k = 0; k < 4; ++k)
+	{
+		int dx = ux + dir[k][0], dy = uy + dir[k][1];
+		if (!Region.free(dx, dy))
+			continue;
+
+		int state = (dx * bigcols + dy) * 4 + k;
+		dis[state] = stepCost;
+		que.push({stepCost, stepCost, state});
+	}
 
 	while (!que.empty())
 	{
 		node cur = que.top();
 		que.pop();
-		if (cur.id == v)
-			break;
+		counters.nodes_expanded++;
 		if (cur.gx > dis[cur.id] + eps)
 			continue;
 
-		int cx = cur.id / bigcols, cy = cur.id % bigcols;
-		for (int i = 0; i < 4; ++i)
+		int cell = cur.id / 4, heading = cur.id % 4;
+		field[cell] = std::min(field[cell], cur.gx);
+
+		int cx = cell / bigcols, cy = cell % bigcols;
+		for (int k = 0; k < 4; ++k)
 		{
-			int dx = cx + dir[i][0], dy = cy + dir[i][1];
-			if (dx < 0 || dx >= bigrows || dy < 0 || dy >= bigcols || !Region[dx][dy])
+			int dx = cx + dir[k][0], dy = cy + dir[k][1];
+			if (!Region.free(dx, dy))
 				continue;
 
-			int nxt_id = dx * bigcols + dy;
-			double distance = euclidean_dis(cx, cy, dx, dy) * cellSize;
-			double tj = (distance < (vmax * vmax) / a) ? sqrt(4 * distance / a) : (distance / vmax + vmax / a);
-
-			// Add turn cost if there's a previous point
-			double turnCost = 0;
-			if (pre[cur.id] != -1 && !isSameLine(pre[cur.id], cur.id, nxt_id))
+			int state = (dx * bigcols + dy) * 4 + k;
+			double newCost = cur.gx + stepCost + (k == heading ? 0.0 : turnCost);
+			if (newCost < dis[state])
 			{
-				turnCost = M_PI / (2 * omega);
-			}
-
-			double newCost = dis[cur.id] + tj + turnCost;
-			if (newCost < dis[nxt_id])
-			{
-				dis[nxt_id] = newCost;
-				pre[nxt_id] = cur.id;
-				double heuristic = euclidean_dis(dx, dy, ex, ey) * cellSize / vmax; // Time-based heuristic
-				que.push({newCost + heuristic, newCost, nxt_id});
+				dis[state] = newCost;
+				que.push({newCost, newCost, state});
 			}
 		}
 	}
-
-	return dis[v];
 }
 
-#endif
-
 // Try to use a compressed A* path
 vector<int> PathCut::A_star_path(int u, int v)
 {
+	counters.astar_calls++;
 	// cout << "In A star. printing u and v: " << u << " " << v << endl;
 	std::priority_queue<node> que;
 	int sx = u / bigcols, sy = u % bigcols;
@@ -520,6 +497,7 @@ vector<int> PathCut::A_star_path(int u, int v)
 	{
 		node cur = que.top();
 		que.pop();
+		counters.nodes_expanded++;
 		if (cur.id == v)
 		{
 			// cout << "reaching the final point!\n";
@@ -532,7 +510,7 @@ vector<int> PathCut::A_star_path(int u, int v)
 		for (int i = 0; i < 4; ++i)
 		{
 			int dx = cx + dir[i][0], dy = cy + dir[i][1];
-			if (dx < 0 || dx >= bigrows || dy < 0 || dy >= bigcols || !Region[dx][dy])
+			if (!Region.free(dx, dy))
 				continue;
 
 			int nxt_id = dx * bigcols + dy;
@@ -564,26 +542,11 @@ vector<int> PathCut::A_star_path(int u, int v)
 	return path;
 }
 
-#ifdef OLD_COST
-double PathCut::getTurnAndLength(int i)
-{
-	// Note: if the end index is smaller than the start index, it means we've added a tail
-	// Also, strictly speaking, if the cut contains a complete path, the number of turns should be -1, but we need to be careful with the modulo operation
-	int start = cuts[i].start;
-	int ending = (cuts[i].start + cuts[i].len - 1 + circleLen) % circleLen;
-	double endingTurn = isSameLine(pathSequence[(ending - 1 + circleLen) % circleLen], pathSequence[ending], pathSequence[(ending + 1) % circleLen]) ? 1.0 : 0.0;
-	if (start <= ending)
-		return pathValue[ending] - pathValue[start] + endingTurn;
-	else
-		return pathValue[circleLen - 1] - pathValue[start] + pathValue[ending] + endingTurn;
-}
-
-#else
-
-double PathCut::getTurnAndLength(int i)
+// A pathValues entry is a prefix sum (segment time + turn cost) unrolled over two laps of the circle, so
+// the cost of any arc of at most one lap is a single subtraction
+double PathCut::arcCost(int start, int len, const vector<double> &value) const
 {
-	int start = cuts.at(i).start;
-	int ending = (cuts.at(i).start + cuts.at(i).len - 1) % circleLen;
+	int ending = (start + len - 1) % circleLen;
 
 	// Handle wrap-around by adjusting ending to the second cycle if needed
 	if (ending < start)
@@ -591,13 +554,14 @@ double PathCut::getTurnAndLength(int i)
 		ending += circleLen;
 	}
 
-	// Cost is the difference in pathValue
-	double cost = pathValue.at(ending) - pathValue.at(start);
-
-	return cost;
+	// Cost is the difference in the prefix sum
+	return value[ending] - value[start];
 }
 
-#endif
+double PathCut::getTurnAndLength(int i) const
+{
+	return arcCost(cuts[i].start, cuts[i].len, cutPathValue(i));
+}
 
 // Helper function to compute distance between two grid points
 double PathCut::calculateDistance(int idx1, int idx2)
@@ -626,20 +590,83 @@ double PathCut::updateCutVal(int i)
 	// cover without back to starting point
 	if (!coverAndReturn)
 	{
-		auto cost_to = A_star(depot[cut_depot[i]], cut_start_region_label);
+		auto cost_to = depotDistance(cut_depot[i], cut_start_region_label);
 
-		return 0.5 * cost_to + mainPathCost;
+		return 0.5 * cost_to + mainPathCost + enduranceOverrun(i);
 	}
 	else
 	{
-		auto cost_to = A_star(depot[cut_depot[i]], cut_start_region_label);
-		auto cost_back = A_star(cut_end_region_label, depot[cut_depot[i]]);
+		auto cost_to = depotDistance(cut_depot[i], cut_start_region_label);
+		auto cost_back = depotDistance(cut_depot[i], cut_end_region_label);
 
 
-		return 0.5*cost_to + mainPathCost + 0.5*cost_back;
+		return 0.5*cost_to + mainPathCost + 0.5*cost_back + enduranceOverrun(i);
 	}
 }
 
+// Full flight of cut i: out to the cut start, the cut, and back when returning (the cut value halves the legs)
+double PathCut::cutFlightCost(int i) const
+{
+	int d = cut_depot[i];
+	double cost = depotDistance(d, pathSequence[cuts[i].start]) + getTurnAndLength(i);
+	if (coverAndReturn)
+		cost += depotDistance(d, pathSequence[(cuts[i].start + cuts[i].len - 1 + circleLen) % circleLen]);
+	return cost;
+}
+
+// Penalty of cut i when its full flight exceeds the robot's endurance: enduranceStep, more than any cut
+// value, plus the overrun. Balancing first hands the overrun to other robots, then minimizes the makespan,
+// whatever the cost units.
+double PathCut::enduranceOverrun(int i) const
+{
+	int d = cut_depot[i];
+	if (d >= robotEndurance.size() || robotEndurance[d] <= 0)
+		return 0.0;
+	double overrun = cutFlightCost(i) - robotEndurance[d];
+	return overrun > eps ? enduranceStep + overrun : 0.0;
+}
+
+// Bound on any cut value without penalty: the costliest circle plus the longest legs to and from a depot
+void PathCut::updateEnduranceStep()
+{
+	double circle = 0.0, leg = 0.0;
+	for (const auto &value : pathValues)
+		if (!value.empty())
+			circle = std::max(circle, value.back());
+	for (const auto &field : depotDistField)
+		for (double dist : field)
+			if (dist < 1e9)
+				leg = std::max(leg, dist);
+	enduranceStep = circle + 2 * leg;
+}
+
+bool PathCut::withinEndurance() const
+{
+	for (int i = 0; i < cuts.size(); ++i)
+	{
+		int d = cut_depot[i];
+		if (d < robotEndurance.size() && robotEndurance[d] > 0 && cutFlightCost(i) > robotEndurance[d] + eps)
+			return false;
+	}
+	return true;
+}
+
+void PathCut::setRobotParameters(const vector<VehicleParameters> &params)
+{
+	robotParams.clear();
+	if (params.empty())
+		return;
+	if (params.size() != depot.size())
+	{
+		Logger::warning("TMSTC - " + std::to_string(params.size()) + " robot vehicle parameters for " + std::to_string(depot.size()) + " robots, using the shared parameters");
+		return;
+	}
+
+	robotParams = params;
+	for (auto &p : robotParams)
+		p.cellSize_m = vehicleParams.cellSize_m; // The grid decides the cell size
+}
+
 void PathCut::MSTC_Star()
 {
 	// Note: each robot's path starting length cannot be simply taken based on the previous and next, because on a circle, a robot might not be between its preceding and following robots
@@ -663,19 +690,34 @@ void PathCut::MSTC_Star()
 	}
 
 	double opt = 0, wst = 2e9;
+	vector<int> depotPos(depot.size());
 	for (int i = 0; i < depot.size(); ++i)
-	{
-		cuts.at(i).start = invSequence[depot[cut_depot.at(i)]];
-		cuts.at(i).len = (invSequence[depot[cut_depot[(i + 1) % depot.size()]]] - invSequence[depot[cut_depot.at(i)]] + circleLen) % circleLen; // nr - nl + 1 - 1
-		cuts.at(i).val = updateCutVal(i);
-		opt = std::max(opt, cuts.at(i).val);
-		wst = std::min(wst, cuts.at(i).val);
+		depotPos[i] = invSequence[depot[i]];
+	initCutsFromStarts(depotPos, opt, wst, false);
 
-		// Logger::info("TMSTC - opt: " + std::to_string(opt) + " wst: " + std::to_string(wst) + " cut[" + std::to_string(i) + "] val: " + std::to_string(cuts[i].val));
+	// A previous plan's cut starts are usually close to balanced already, so keep them if they are better
+	if (warmStartCells.size() == depot.size())
+	{
+		vector<cut> depotCuts = cuts;
+		double warmOpt = 0, warmWst = 2e9;
+		vector<int> warmPos(depot.size(), -1);
+		for (int i = 0; i < depot.size(); ++i)
+			if (warmStartCells[i] >= 0 && warmStartCells[i] < invSequence.size())
+				warmPos[i] = invSequence[warmStartCells[i]];
+
+		if (initCutsFromStarts(warmPos, warmOpt, warmWst) && warmOpt < opt)
+		{
+			TMSTC_LOG(SUMMARY, "Using warm start cuts, opt " << warmOpt << " instead of " << opt << endl);
+			TMSTC_LOG_INFO(SUMMARY, "TMSTC - Using warm start cuts, opt " + std::to_string(warmOpt) + " instead of " + std::to_string(opt));
+			opt = warmOpt;
+			wst = warmWst;
+		}
+		else
+			cuts = depotCuts;
 	}
 
-	cout << "opt and wst: " << opt << "  " << wst << endl;
-	Logger::info("TMSTC - Initial opt and wst: " + std::to_string(opt) + "  " + std::to_string(wst));
+	TMSTC_LOG(SUMMARY, "opt and wst: " << opt << "  " << wst << endl);
+	TMSTC_LOG_INFO(SUMMARY, "TMSTC - Initial opt and wst: " + std::to_string(opt) + "  " + std::to_string(wst));
 
 	// Note: MSTC* does not consider that in some cases the path weight of cutting a single path is greater than cutting multiple paths, so in practice it may not converge for some maps. We need to modify it
 	int cur_iter = 0; // , max_iter = 10;
@@ -685,12 +727,25 @@ void PathCut::MSTC_Star()
 	double curr_diff = opt - wst;
 	double prev_diff = opt - wst;
 
+	// A balancing step can end worse than it started, so remember the best cuts seen
+	vector<cut> bestCuts = cuts;
+	pair<double, double> bestScore = cutsScore();
+
 	while (opt - wst > 10.0 && cur_iter < maxIterations)
 	{
+		// The current cuts are always a valid plan, so a stop request just ends balancing early
+		if (stop_flag && stop_flag->load())
+		{
+			TMSTC_LOG(SUMMARY, "MSTC_Star stopped at iteration " << cur_iter << "\n");
+			TMSTC_LOG_INFO(SUMMARY, "TMSTC - MSTC_Star stopped at iteration " + std::to_string(cur_iter));
+			break;
+		}
+
 		cur_iter++;
-		cout << "MSTC_Star Iteration: " << cur_iter << "\n";
-		cout << "cutting for balancing...\n"; // just a sign
-		Logger::info("TMSTC - Cutting for balancing... at iteration " + std::to_string(cur_iter));
+		counters.balancing_iterations++;
+		TMSTC_LOG(DETAIL, "MSTC_Star Iteration: " << cur_iter << "\n");
+		TMSTC_LOG(DETAIL, "cutting for balancing...\n"); // just a sign
+		TMSTC_LOG_INFO(DETAIL, "TMSTC - Cutting for balancing... at iteration " + std::to_string(cur_iter));
 
 		double minn = 2e9, maxx = -1;
 		int min_cut = -1, max_cut = -1;
@@ -710,13 +765,36 @@ void PathCut::MSTC_Star()
 
 		curr_diff = maxx - minn;
 
-		cout << "before adjustment opt and wst: " << maxx << "  " << minn << " diff: (" << (maxx - minn) << ")\n";
-		Logger::info("TMSTC - Before adjustment opt and wst: " + std::to_string(maxx) + "  " + std::to_string(minn) + " diff: (" + std::to_string(maxx - minn) + ")");
+		TMSTC_LOG(DETAIL, "before adjustment opt and wst: " << maxx << "  " << minn << " diff: (" << (maxx - minn) << ")\n");
+		TMSTC_LOG_INFO(DETAIL, "TMSTC - Before adjustment opt and wst: " + std::to_string(maxx) + "  " + std::to_string(minn) + " diff: (" + std::to_string(maxx - minn) + ")");
 		// Judge whether to go clockwise or counter-clockwise
 		vector<int> clw = getHalfCuts(min_cut, max_cut, 1);
 		vector<int> ccw = getHalfCuts(min_cut, max_cut, -1);
-		Logger::info("before balanced cut");
-		clw.size() < ccw.size() ? Balanced_Cut(clw) : Balanced_Cut(ccw);
+		TMSTC_LOG_INFO(DETAIL, "before balanced cut");
+
+		// Arc costs are O(1), so try both directions and keep the one with the lower max (then total) cost
+		vector<cut> before = cuts;
+		Balanced_Cut(clw);
+		vector<cut> clwCuts = cuts;
+		pair<double, double> clwScore = cutsScore();
+
+		cuts = before;
+		Balanced_Cut(ccw);
+		pair<double, double> ccwScore = cutsScore();
+
+		if (clwScore.first < ccwScore.first - eps ||
+			(std::abs(clwScore.first - ccwScore.first) <= eps && clwScore.second < ccwScore.second))
+		{
+			cuts = clwCuts;
+			ccwScore = clwScore;
+		}
+
+		if (ccwScore.first < bestScore.first - eps ||
+			(std::abs(ccwScore.first - bestScore.first) <= eps && ccwScore.second < bestScore.second))
+		{
+			bestCuts = cuts;
+			bestScore = ccwScore;
+		}
 
 
 		opt = 0, wst = 2e9;
@@ -726,19 +804,66 @@ void PathCut::MSTC_Star()
 			wst = std::min(wst, cuts.at(i).val);
 		}
 
-		cout << "after adjustment opt and wst: " << opt << "  " << wst << " diff: (" << (opt - wst) << ")\n";
-		Logger::info("TMSTC - After adjustment opt and wst: " + std::to_string(opt) + "  " + std::to_string(wst) + " diff: (" + std::to_string(opt - wst) + ")");
+		TMSTC_LOG(DETAIL, "after adjustment opt and wst: " << opt << "  " << wst << " diff: (" << (opt - wst) << ")\n");
+		TMSTC_LOG_INFO(DETAIL, "TMSTC - After adjustment opt and wst: " + std::to_string(opt) + "  " + std::to_string(wst) + " diff: (" + std::to_string(opt - wst) + ")");
 
 		prev_diff = curr_diff;
 		curr_diff = opt - wst;
 		if (std::abs(prev_diff - curr_diff) < 10 && opt - wst < 500)
 		{
-			cout << "MSTC_Star Cutoff finished!\n\n\n";
-			Logger::info("TMSTC - MSTC_Star cutoff finished at iteration " + std::to_string(cur_iter));
+			TMSTC_LOG(SUMMARY, "MSTC_Star Cutoff finished!\n\n\n");
+			TMSTC_LOG_INFO(SUMMARY, "TMSTC - MSTC_Star cutoff finished at iteration " + std::to_string(cur_iter));
 			break;
 		}
 		
 	}
+
+	if (cutsScore() != bestScore)
+		cuts = bestCuts;
+}
+
+// Start cut i at startPos[cut_depot[i]] (positions on the circle) and run it up to the next cut.
+// With checkOrder, returns false and leaves the cuts untouched when the starts are missing, repeated or
+// not in the depots' circle order.
+bool PathCut::initCutsFromStarts(const vector<int> &startPos, double &opt, double &wst, bool checkOrder)
+{
+	int n = depot.size();
+	int descents = 0;
+	for (int i = 0; i < n && checkOrder; ++i)
+	{
+		int cur = startPos[cut_depot[i]], nxt = startPos[cut_depot[(i + 1) % n]];
+		if (cur < 0 || cur >= circleLen || (n > 1 && cur == nxt))
+			return false;
+		if (nxt < cur)
+			descents++;
+	}
+	if (checkOrder && n > 1 && descents != 1)
+		return false;
+
+	opt = 0, wst = 2e9;
+	for (int i = 0; i < n; ++i)
+	{
+		cuts.at(i).start = startPos[cut_depot[i]];
+		cuts.at(i).len = (startPos[cut_depot[(i + 1) % n]] - startPos[cut_depot[i]] + circleLen) % circleLen; // nr - nl + 1 - 1
+		cuts.at(i).val = updateCutVal(i);
+		opt = std::max(opt, cuts.at(i).val);
+		wst = std::min(wst, cuts.at(i).val);
+
+		// Logger::info("TMSTC - opt: " + std::to_string(opt) + " wst: " + std::to_string(wst) + " cut[" + std::to_string(i) + "] val: " + std::to_string(cuts[i].val));
+	}
+	return true;
+}
+
+// Max and total value over all cuts
+pair<double, double> PathCut::cutsScore() const
+{
+	double maxVal = 0, sumVal = 0;
+	for (const auto &c : cuts)
+	{
+		maxVal = std::max(maxVal, c.val);
+		sumVal += c.val;
+	}
+	return {maxVal, sumVal};
 }
 
 vector<int> PathCut::getHalfCuts(int cut_min, int cut_max, int dir)
@@ -777,16 +902,22 @@ void PathCut::Balanced_Cut(vector<int> &adjustCuts)
 	double cur_val_max = -1, cur_val_sum = 0;
 	bool update_success = false;
 
+	// The split point is searched in r_first's own cost, so with a mixed fleet both arcs are valued as r_first flies them
+	const vector<double> &firstValue = cutPathValue(r_first);
+
 	// int lef = 0, rig = cuts.at(r_first).len + cuts.at(r_last).len - 1;  // -1 ensures the divided length is not 0
-	double lef = 0, rig = getTurnAndLength(r_first) + getTurnAndLength(r_last);
+	double lef = 0, rig = getTurnAndLength(r_first) + arcCost(cuts.at(r_last).start, cuts.at(r_last).len, firstValue);
 
 	// Originally we only used length comparison to divide, now we changed to weights, i.e., path length + turn weight to divide, then update the length
 	// Updated length can only start from the beginning and divide the path length
 	
 	while (rig - lef > eps)
 	{
+		counters.balanced_cut_evaluations++;
 		double mid = (lef + rig) / 2;
-		int firstCutLen = std::lower_bound(pathValue.begin() + cuts.at(r_first).start, pathValue.end(), mid + pathValue.at(cuts.at(r_first).start)) - pathValue.begin() - cuts.at(r_first).start + 1;
+		int firstCutLen = std::lower_bound(firstValue.begin() + cuts.at(r_first).start, firstValue.end(), mid + firstValue.at(cuts.at(r_first).start)) - firstValue.begin() - cuts.at(r_first).start + 1;
+		// The two outer cuts only trade cells, neither may end up with a negative length
+		firstCutLen = std::min(firstCutLen, old_len_r_first + old_len_r_last);
 		cuts.at(r_first).len = firstCutLen;
 		cuts.at(r_last).len = old_len_r_first + old_len_r_last - firstCutLen;
 
@@ -873,121 +1004,60 @@ Mat PathCut::generatePath()
 
 Mat PathCut::cutSolver()
 {
-	cout << "Entering MSTC Cut Solver...\n";
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point since)
+	{ return std::chrono::duration<double>(clock::now() - since).count(); };
+
+	phaseTimes = CutPhaseTimes();
+	counters = PlanCounters();
+
+	TMSTC_LOG(SUMMARY, "Entering MSTC Cut Solver...\n");
+	auto start = clock::now();
 	MST2Path();
+	phaseTimes.mst2path_s = seconds(start) - phaseTimes.filtering_s;
 
 	if (depot.size() == 1)
 	{
-		cout << "Only one robot, no need to balance, return...\n";
+		TMSTC_LOG(SUMMARY, "Only one robot, no need to balance, return...\n");
 		return Mat(1, pathSequence);
 	}
 
-	cout << "Begin MSTC_Star Algorithm to find the best cut for each robot...\n";
+	// Depots are final after MST2Path (filtering may move them), so the fields can be built once here
+	start = clock::now();
+	buildDepotDistanceFields();
+	updateEnduranceStep();
+	phaseTimes.depot_fields_s = seconds(start);
+
+	TMSTC_LOG(SUMMARY, "Begin MSTC_Star Algorithm to find the best cut for each robot...\n");
+	start = clock::now();
 	MSTC_Star();
+	phaseTimes.mstc_star_s = seconds(start);
 
-	return generatePath();
+	start = clock::now();
+	Mat paths = generatePath();
+	phaseTimes.generate_s = seconds(start);
+	return paths;
 }
 
 int PathCut::getTurnsNum()
 {
-	int turns = 0;
-	for (int i = 1; i < pathSequence.size() - 1; ++i)
-	{
-		turns += isSameLine(pathSequence[i - 1], pathSequence[i], pathSequence[i + 1]) ? 0 : 1;
-	}
-
-	return turns;
+	return countTurns(pathSequence.data(), pathSequence.size());
 }
 
-double computePathCost(const std::vector<int> &path, const VehicleParameters &vehicleParams, int mapCols)
+double PathCut::segmentCost(int prev, int curr, int next)
 {
-	// Assuming path is a vector of (cover) grid indices, compute the cost based on the vehicle parameters
-	double omega = vehicleParams.omega_rad; // rad/s (angular velocity)
-	double a = vehicleParams.acc;			// m/s^2 (acceleration)
-	double vmax = vehicleParams.vmax;		// m/s (max velocity)
-	double phi = vehicleParams.phi_max_rad; // rad (max banking angle)
-
+	const uint64_t cellMask = (1ULL << 21) - 1;
+	if ((uint64_t)prev > cellMask || (uint64_t)curr > cellMask || (uint64_t)next > cellMask)
+		return computePathCost({prev, curr, next}, vehicleParams, smallcols);
 
-
-	// Computed turn radius
-	const double turn_radius = (vmax * vmax) / (gravity * std::tan(phi)); // Turn radius in meters
-	std::function<double(double)> turn_time = [&](double theta){return (turn_radius * theta) / vmax ; };			  // Time for a turn based on angle
-
-	// Check if path is valid
-	if (path.size() < 2)
-		return 0.0;
-
-	std::function<double(int, int)> calculateDistanceMap = [smallcols = mapCols, cellSize = vehicleParams.cellSize_m](int idx1, int idx2)
-	{
-		int x1, y1, x2, y2;
-		x1 = idx1 / smallcols;
-		y1 = idx1 % smallcols;
-		x2 = idx2 / smallcols;
-		y2 = idx2 % smallcols;
-		double dx = (x1 - x2) * cellSize; // Adjust with actual cell size
-		double dy = (y1 - y2) * cellSize;
-		return sqrt(dx * dx + dy * dy);
-	};
-
-	double totalCost = 0.0;
-	int turnCount = 0;
-	double turnCost = 0.0;
-	// Compute segment traversal times
-	for (size_t j = 0; j < path.size() - 1; ++j)
+	uint64_t key = ((uint64_t)prev << 42) | ((uint64_t)curr << 21) | (uint64_t)next;
+	size_t slot = (key * 0x9E3779B97F4A7C15ULL) >> (64 - SEGMENT_CACHE_BITS);
+	if (segmentCacheKeys[slot] != key)
 	{
-		double distance = calculateDistanceMap(path[j], path[j + 1]);
-		double tj = 0;
-#ifdef USE_UAV_COST
-		tj = distance / vmax;
-#else
-		// Segment time tj: sqrt(4d/a) if d < vmax^2/a, else d/vmax + vmax/a
-		tj = (distance < (vmax * vmax) / a) ? std::sqrt(4 * distance / a) : (distance / vmax + vmax / a);
-#endif
-
-		totalCost += tj;
-
-		// Count turns (check if next segment changes direction)
-		if (j < path.size() - 2 && !PathCut::isSameLine(path[j], path[j + 1], path[j + 2]))
-		{
-			// Vectors: v1 = P_{i-1} to P_i, v2 = P_i to P_{i+1}
-			int p0 = path[j], p1 = path[j+1], p2 = path[j + 2];
-
-			double p0x = p0 % mapCols, p0y = p0 / mapCols; // x and y coordinates of p0
-			double p1x = p1 % mapCols, p1y = p1 / mapCols; // x and y coordinates of p1
-			double p2x = p2 % mapCols, p2y = p2 / mapCols; // x and y coordinates of p2
-
-			double theta = std::abs(segmentAngle(p0x,p0y,p1x,p1y, p2x,p2y)); // Angle between two vectors in radians
-
-
-			// double v1x = (p1 % mapCols - p0 % mapCols) * vehicleParams.cellSize_m; // x-component
-			// double v1y = (p1 / mapCols - p0 / mapCols) * vehicleParams.cellSize_m; // y-component
-			// double v2x = (p2 % mapCols - p1 % mapCols) * vehicleParams.cellSize_m;
-			// double v2y = (p2 / mapCols - p1 / mapCols) * vehicleParams.cellSize_m;
-			
-			// // Compute turn angle theta
-			// double dot = v1x * v2x + v1y * v2y;
-			// double det = v1x * v2y - v1y * v2x;
-			// double theta = std::abs(std::atan2(det, dot)); // Absolute angle in [0, pi]
-
-
-
-			turnCost += turn_time(theta); // Time for the turn based on angle
-			turnCount++;
-		}
+		segmentCacheKeys[slot] = key;
+		segmentCacheVals[slot] = computePathCost({prev, curr, next}, vehicleParams, smallcols);
 	}
-
-	
-#ifdef USE_UAV_COST
-	// Add turn costs (assuming 90-degree turns, cost = turn_time)
-	// turnCost = turn_time * turnCount;
-#else
-	// Add turn costs (assuming 90-degree turns, cost = pi/(2*omega))
-	turnCost = (M_PI / (2 * omega)) * turnCount;
-#endif
-
-	totalCost += turnCost;
-
-	return totalCost;
+	return segmentCacheVals[slot];
 }
 
 void PathCut::optimizePathWithOutliersAndUpdateSequence(const std::vector<int> &valid_points)
@@ -995,32 +1065,12 @@ void PathCut::optimizePathWithOutliersAndUpdateSequence(const std::vector<int> &
 	// Create a working copy of the valid points
 	std::vector<int> working_path = valid_points;
 
-	// Create a lookup table for segment costs
-	static std::unordered_map<std::tuple<int, int, int>, double, tuple_hash> cost_lookup;
-	auto computeSegmentCost = [&](int prev, int curr, int next)
+	// Start every solve with an empty cache, its size stays fixed
+	segmentCacheKeys.assign(size_t(1) << SEGMENT_CACHE_BITS, SEGMENT_CACHE_EMPTY);
+	segmentCacheVals.assign(size_t(1) << SEGMENT_CACHE_BITS, 0.0);
+	auto computeSegmentCost = [this](int prev, int curr, int next)
 	{
-		auto key = std::make_tuple(prev, curr, next);
-		if (cost_lookup.find(key) == cost_lookup.end())
-		{
-			
-			// std::function<double(int, int)> calculateDistanceMap = [smallcols = smallcols, cellSize = vehicleParams.cellSize_m](int idx1, int idx2)
-			// {
-			// 	int x1, y1, x2, y2;
-			// 	x1 = idx1 / smallcols;
-			// 	y1 = idx1 % smallcols;
-			// 	x2 = idx2 / smallcols;
-			// 	y2 = idx2 % smallcols;
-			// 	double dx = (x1 - x2) * cellSize; // Adjust with actual cell size
-			// 	double dy = (y1 - y2) * cellSize;
-			// 	return sqrt(dx * dx + dy * dy);
-			// };
-			
-			// cost_lookup[key] = calculateDistanceMap(prev, curr) + calculateDistanceMap(curr, next); // computePathCost(segment, vehicleParams, smallcols);
-			
-			std::vector<int> segment = {prev, curr, next};
-			cost_lookup[key] = computePathCost(segment, vehicleParams, smallcols);
-		}
-		return cost_lookup[key];
+		return segmentCost(prev, curr, next);
 	};
 
 	// Iterate through the working path and adjust points
@@ -1063,8 +1113,8 @@ void PathCut::optimizePathWithOutliersAndUpdateSequence(const std::vector<int> &
 		auto threshold = 15.0; // Adjust this threshold as needed
 		while ((current_cost > threshold * neighbor_cost_prev || current_cost > threshold * neighbor_cost_next) && iteration_count < working_path.size() - 2)
 		{
-			Logger::info("TMSTC - Iteration: " + std::to_string(iteration_count) + ", Current cost: " + std::to_string(current_cost) + ", Neighbor costs: " + std::to_string(neighbor_cost_prev) + ", " + std::to_string(neighbor_cost_next));
-			std::cout << "Iteration: " << iteration_count << ", Current cost: " << current_cost << ", Neighbor costs: " << neighbor_cost_prev << ", " << neighbor_cost_next << std::endl;
+			TMSTC_LOG_INFO(DETAIL, "TMSTC - Iteration: " + std::to_string(iteration_count) + ", Current cost: " + std::to_string(current_cost) + ", Neighbor costs: " + std::to_string(neighbor_cost_prev) + ", " + std::to_string(neighbor_cost_next));
+			TMSTC_LOG(DETAIL, "Iteration: " << iteration_count << ", Current cost: " << current_cost << ", Neighbor costs: " << neighbor_cost_prev << ", " << neighbor_cost_next << std::endl);
 			// Try moving the current point either past next or before prev
 			double cost_move_past_next = computeSegmentCost(next_point, current_point, next_next_point);
 			double cost_move_before_prev = computeSegmentCost(prev_prev_point, current_point, prev_point);
@@ -1075,8 +1125,8 @@ void PathCut::optimizePathWithOutliersAndUpdateSequence(const std::vector<int> &
 				working_path.erase(working_path.begin() + j);
 				working_path.insert(working_path.begin() + next_index, current_point);
 				j = next_index; 
-				Logger::info("TMSTC - Moved current point past next");
-				std::cout << "Moved current point past next" << std::endl;
+				TMSTC_LOG_INFO(DETAIL, "TMSTC - Moved current point past next");
+				TMSTC_LOG(DETAIL, "Moved current point past next" << std::endl);
 			}
 			else if (cost_move_before_prev < current_cost)
 			{
@@ -1084,8 +1134,8 @@ void PathCut::optimizePathWithOutliersAndUpdateSequence(const std::vector<int> &
 				working_path.erase(working_path.begin() + j);
 				working_path.insert(working_path.begin() + prev_index, current_point);
 				j = prev_index;
-				Logger::info("TMSTC - Moved current point before prev");
-				std::cout << "Moved current point before prev" << std::endl;
+				TMSTC_LOG_INFO(DETAIL, "TMSTC - Moved current point before prev");
+				TMSTC_LOG(DETAIL, "Moved current point before prev" << std::endl);
 			}
 			else
 			{
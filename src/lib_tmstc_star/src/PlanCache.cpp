@@ -0,0 +1,290 @@
+#include "PlanCache.h"
+
+#include <stdexcept>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// File layout (host byte order, the cache is not meant to be moved between machines):
+//   header: magic[8] | uint32 version | uint32 generation (bumped on every reset)
+//   entry:  uint64 key lo | uint64 key hi | uint32 payload bytes | uint32 0 | uint64 payload checksum | payload
+// Payloads are padded to 8 bytes. An entry that fails its checksum ends the valid part of the file
+// (a writer died mid-append) and is overwritten by the next store.
+
+namespace
+{
+const char MAGIC[8] = {'T', 'M', 'S', 'T', 'C', 'P', 'C', '\0'};
+constexpr size_t HEADER_BYTES = 16;
+constexpr size_t ENTRY_BYTES = 32;
+
+size_t padded(size_t bytes) { return (bytes + 7) & ~size_t(7); }
+
+uint64_t checksum(const unsigned char *data, size_t bytes)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < bytes; ++i)
+	{
+		h ^= data[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+template <typename T>
+T load(const unsigned char *p)
+{
+	T v;
+	std::memcpy(&v, p, sizeof(T));
+	return v;
+}
+
+template <typename T>
+void append(std::vector<unsigned char> &buf, T v)
+{
+	size_t at = buf.size();
+	buf.resize(at + sizeof(T));
+	std::memcpy(buf.data() + at, &v, sizeof(T));
+}
+
+void appendMat(std::vector<unsigned char> &buf, const std::vector<std::vector<int>> &mat)
+{
+	append<uint32_t>(buf, mat.size());
+	for (const auto &row : mat)
+	{
+		append<uint32_t>(buf, row.size());
+		size_t at = buf.size();
+		buf.resize(at + row.size() * sizeof(int32_t));
+		std::memcpy(buf.data() + at, row.data(), row.size() * sizeof(int32_t));
+	}
+}
+
+void appendGrid(std::vector<unsigned char> &buf, const MSTGrid &grid)
+{
+	append<uint32_t>(buf, grid.rows());
+	append<uint32_t>(buf, grid.cols());
+	size_t at = buf.size();
+	buf.resize(at + grid.size());
+	std::memcpy(buf.data() + at, grid.data(), grid.size());
+}
+
+// Bounds-checked reader over a payload
+class Reader
+{
+public:
+	Reader(const unsigned char *data, size_t bytes) : p_(data), end_(data + bytes) {}
+
+	bool u32(uint32_t &v)
+	{
+		if (end_ - p_ < 4)
+			return false;
+		v = load<uint32_t>(p_);
+		p_ += 4;
+		return true;
+	}
+
+	bool bytes(void *out, size_t n)
+	{
+		if (static_cast<size_t>(end_ - p_) < n)
+			return false;
+		std::memcpy(out, p_, n);
+		p_ += n;
+		return true;
+	}
+
+	bool mat(std::vector<std::vector<int>> &mat)
+	{
+		uint32_t rows;
+		if (!u32(rows) || rows > static_cast<size_t>(end_ - p_) / 4)
+			return false;
+		mat.assign(rows, {});
+		for (auto &row : mat)
+		{
+			uint32_t len;
+			if (!u32(len) || len > static_cast<size_t>(end_ - p_) / 4)
+				return false;
+			row.resize(len);
+			if (!bytes(row.data(), len * sizeof(int32_t)))
+				return false;
+		}
+		return true;
+	}
+
+	bool grid(MSTGrid &grid)
+	{
+		uint32_t rows, cols;
+		if (!u32(rows) || !u32(cols) || (cols && rows > static_cast<size_t>(end_ - p_) / cols))
+			return false;
+		grid = MSTGrid(rows, cols);
+		return bytes(grid.data(), grid.size());
+	}
+
+private:
+	const unsigned char *p_;
+	const unsigned char *end_;
+};
+
+// Holds an flock for its scope
+class FileLock
+{
+public:
+	FileLock(int fd, int op) : fd_(fd) { while (flock(fd_, op) == -1 && errno == EINTR); }
+	~FileLock() { flock(fd_, LOCK_UN); }
+
+private:
+	int fd_;
+};
+}
+
+PlanCache::PlanCache(const std::string &path, size_t max_bytes) : path_(path), max_bytes_(max_bytes)
+{
+	fd_ = open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd_ == -1)
+		throw std::runtime_error("PlanCache: cannot open " + path_);
+
+	{
+		FileLock lock(fd_, LOCK_EX);
+		struct stat st;
+		unsigned char header[HEADER_BYTES];
+		bool empty = fstat(fd_, &st) == 0 && st.st_size == 0;
+		if (!empty && (pread(fd_, header, HEADER_BYTES, 0) != (ssize_t)HEADER_BYTES ||
+					   std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0))
+		{
+			close(fd_);
+			fd_ = -1;
+			throw std::runtime_error("PlanCache: " + path_ + " is not a plan cache");
+		}
+		// New file, or one written by another format version
+		if (empty || load<uint32_t>(header + 8) != FORMAT_VERSION)
+			resetLocked();
+	}
+
+	FileLock lock(fd_, LOCK_SH);
+	remap();
+}
+
+PlanCache::~PlanCache()
+{
+	if (data_)
+		munmap(const_cast<unsigned char *>(data_), mapped_);
+	if (fd_ != -1)
+		close(fd_);
+}
+
+void PlanCache::resetLocked()
+{
+	uint32_t generation = 0;
+	unsigned char header[HEADER_BYTES];
+	if (pread(fd_, header, HEADER_BYTES, 0) == (ssize_t)HEADER_BYTES && std::memcmp(header, MAGIC, sizeof(MAGIC)) == 0)
+		generation = load<uint32_t>(header + 12) + 1;
+
+	std::memcpy(header, MAGIC, sizeof(MAGIC));
+	uint32_t version = FORMAT_VERSION;
+	std::memcpy(header + 8, &version, 4);
+	std::memcpy(header + 12, &generation, 4);
+	if (ftruncate(fd_, 0) != 0 || pwrite(fd_, header, HEADER_BYTES, 0) != (ssize_t)HEADER_BYTES)
+		throw std::runtime_error("PlanCache: cannot write " + path_);
+}
+
+void PlanCache::remap()
+{
+	struct stat st;
+	if (fstat(fd_, &st) != 0 || st.st_size < (off_t)HEADER_BYTES)
+		throw std::runtime_error("PlanCache: cannot read " + path_);
+	size_t size = st.st_size;
+
+	if (size != mapped_)
+	{
+		if (data_)
+			munmap(const_cast<unsigned char *>(data_), mapped_);
+		void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+		if (p == MAP_FAILED)
+		{
+			data_ = nullptr;
+			mapped_ = 0;
+			throw std::runtime_error("PlanCache: cannot map " + path_);
+		}
+		data_ = static_cast<const unsigned char *>(p);
+		mapped_ = size;
+	}
+
+	// Another process started the file over, the old offsets mean nothing now
+	uint32_t generation = load<uint32_t>(data_ + 12);
+	if (indexed_end_ == 0 || generation != generation_ || indexed_end_ > size)
+	{
+		index_.clear();
+		indexed_end_ = HEADER_BYTES;
+		generation_ = generation;
+	}
+
+	while (indexed_end_ + ENTRY_BYTES <= size)
+	{
+		const unsigned char *e = data_ + indexed_end_;
+		uint32_t bytes = load<uint32_t>(e + 16);
+		size_t payload = indexed_end_ + ENTRY_BYTES;
+		if (padded(bytes) > size - payload || checksum(data_ + payload, bytes) != load<uint64_t>(e + 24))
+			break;
+
+		PlanKey key = PlanKey::fromParts(load<uint64_t>(e), load<uint64_t>(e + 8));
+		index_[key] = {payload, bytes};
+		indexed_end_ = payload + padded(bytes);
+	}
+}
+
+bool PlanCache::lookup(const PlanKey &key, CachedPlan &plan)
+{
+	std::lock_guard<std::mutex> guard(mtx_);
+	// Shared lock: a writer may not start the file over while the mapping is read
+	FileLock lock(fd_, LOCK_SH);
+	remap();
+
+	auto it = index_.find(key);
+	if (it == index_.end())
+		return false;
+
+	Reader in(data_ + it->second.offset, it->second.bytes);
+	uint32_t shape_len;
+	if (!in.u32(shape_len) || shape_len > it->second.bytes)
+		return false;
+	plan.shape.resize(shape_len);
+	return in.bytes(&plan.shape[0], shape_len) && in.grid(plan.mst) && in.mat(plan.paths);
+}
+
+void PlanCache::store(const PlanKey &key, const CachedPlan &plan)
+{
+	std::vector<unsigned char> payload;
+	append<uint32_t>(payload, plan.shape.size());
+	payload.insert(payload.end(), plan.shape.begin(), plan.shape.end());
+	appendGrid(payload, plan.mst);
+	appendMat(payload, plan.paths);
+
+	std::vector<unsigned char> entry;
+	append<uint64_t>(entry, key.lo());
+	append<uint64_t>(entry, key.hi());
+	append<uint32_t>(entry, payload.size());
+	append<uint32_t>(entry, 0);
+	append<uint64_t>(entry, checksum(payload.data(), payload.size()));
+	entry.insert(entry.end(), payload.begin(), payload.end());
+	entry.resize(ENTRY_BYTES + padded(payload.size()), 0);
+
+	std::lock_guard<std::mutex> guard(mtx_);
+	FileLock lock(fd_, LOCK_EX);
+	remap();
+	if (index_.count(key))
+		return;
+
+	if (indexed_end_ + entry.size() > max_bytes_)
+	{
+		resetLocked();
+		remap();
+	}
+
+	// Drop whatever a crashed writer left behind the last valid entry
+	size_t at = indexed_end_;
+	if (ftruncate(fd_, at) != 0 || pwrite(fd_, entry.data(), entry.size(), at) != (ssize_t)entry.size())
+		throw std::runtime_error("PlanCache: cannot write " + path_);
+	remap();
+}
@@ -0,0 +1,145 @@
+#include "SortiePlanner.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "PathCut.h"
+
+namespace
+{
+	// Coverage cost of path[i, j] under the cost model: the segments in between and the turns at the
+	// vertices strictly inside, the path's turns at i and j are taken by the transits
+	struct CoverageCosts
+	{
+		std::vector<double> segments; // segments[k]: segments of path[0, k]
+		std::vector<double> turns;	  // turns[k]: turns at path[1, k]
+
+		double between(int i, int j) const
+		{
+			if (j <= i)
+				return 0.0;
+			return segments[j] - segments[i] + turns[j - 1] - turns[i];
+		}
+	};
+
+	template <typename Model>
+	void planWith(const Model &model, const std::vector<int> &path, int cols, int refuel_idx, const VehicleParameters &vp,
+				  double range_m, double first_range_m, double refuel_time_s, SortiePlan &plan)
+	{
+		const int n = path.size();
+		const double cs = vp.cellSize_m;
+		auto dist = [&](int a, int b)
+		{ return std::hypot((a % cols - b % cols) * cs, (a / cols - b / cols) * cs); };
+
+		// Same terms as computePathCost()
+		PathCostBreakdown breakdown;
+		evaluatePathCost(path.data(), n, vp, cols, breakdown);
+		CoverageCosts coverage;
+		coverage.segments.assign(n, 0.0);
+		coverage.turns.assign(n, 0.0);
+
+		// prefix[k]: coverage distance from path[0] to path[k], home[k]: straight leg to the refuel point
+		std::vector<double> prefix(n, 0.0), home_m(n), home(n);
+		for (int k = 0; k < n; ++k)
+		{
+			if (k > 0)
+			{
+				prefix[k] = prefix[k - 1] + dist(path[k - 1], path[k]);
+				coverage.segments[k] = coverage.segments[k - 1] + breakdown.segment_times[k - 1];
+				coverage.turns[k] = coverage.turns[k - 1] + (breakdown.turn_flags[k] ? model.turn(breakdown.turn_angles[k]) : 0.0);
+			}
+			home_m[k] = dist(refuel_idx, path[k]);
+			home[k] = model.segment(home_m[k]);
+		}
+
+		auto makeSortie = [&](int i, int j)
+		{
+			Sortie s;
+			s.begin = i;
+			s.end = j + 1;
+			s.transit_out_m = home_m[i];
+			s.coverage_m = prefix[j] - prefix[i];
+			s.transit_back_m = home_m[j];
+			s.cost = home[i] + coverage.between(i, j) + home[j];
+			return s;
+		};
+
+		// A tank holds range_m of straight flight at vmax, turns and stops spend it as the model says
+		const double range = model.lowerBound(range_m);
+		const double first_range = (first_range_m > 0 && first_range_m < range_m) ? model.lowerBound(first_range_m) : range;
+		// A refuel is weighed as the flight the vehicle would have made meanwhile
+		const double refuel = model.lowerBound(refuel_time_s * vp.vmax);
+
+		Sortie whole = makeSortie(0, n - 1);
+		if (range_m <= 0 || whole.cost <= first_range)
+		{
+			// One sortie, the common case with a large range, needs no split
+			plan.sorties.push_back(whole);
+		}
+		else
+		{
+			const double inf = std::numeric_limits<double>::infinity();
+
+			// best[j]: cheapest mission covering path[0, j), from[j]: start of its last sortie
+			std::vector<double> best(n + 1, inf);
+			std::vector<int> from(n + 1, -1);
+			best[0] = 0.0;
+			for (int j = 0; j < n; ++j)
+			{
+				// Sorties [i, j] only get costlier as i moves back, so the scan stops once coverage alone is out of range
+				for (int i = j; i >= 0; --i)
+				{
+					double cost = coverage.between(i, j);
+					if (cost > range)
+						break;
+					if (best[i] == inf)
+						continue;
+
+					cost += home[i] + home[j];
+					if (cost > (i == 0 ? first_range : range))
+						continue;
+
+					double total = best[i] + cost + (i > 0 ? refuel : 0.0);
+					if (total < best[j + 1])
+					{
+						best[j + 1] = total;
+						from[j + 1] = i;
+					}
+				}
+
+				// Out of reach within range: fly the cell on its own and report the plan as infeasible
+				if (best[j + 1] == inf && best[j] < inf)
+				{
+					plan.feasible = false;
+					best[j + 1] = best[j] + 2 * home[j] + (j > 0 ? refuel : 0.0);
+					from[j + 1] = j;
+				}
+			}
+
+			for (int j = n; j > 0; j = from[j])
+				plan.sorties.push_back(makeSortie(from[j], j - 1));
+			std::reverse(plan.sorties.begin(), plan.sorties.end());
+		}
+
+		for (const auto &s : plan.sorties)
+		{
+			plan.length_m += s.length_m();
+			plan.mission_time_s += s.cost;
+		}
+		plan.mission_time_s += refuel * (plan.sorties.size() - 1);
+	}
+}
+
+SortiePlan planSorties(const std::vector<int> &path, int cols, int refuel_idx, const VehicleParameters &vp,
+					   double range_m, double first_range_m, double refuel_time_s)
+{
+	SortiePlan plan;
+	plan.refuel_idx = refuel_idx;
+	if (path.empty() || cols <= 0)
+		return plan;
+
+	withCostModel(vp, [&](const auto &model)
+				  { planWith(model, path, cols, refuel_idx, vp, range_m, first_range_m, refuel_time_s, plan); });
+	return plan;
+}
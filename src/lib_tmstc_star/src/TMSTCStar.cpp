@@ -1,9 +1,94 @@
 #include "TMSTCStar.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <limits>
+
+#include "../../lib_common/Logger.h"
+
+namespace
+{
+// Waits with a cancel flag set are cut into slices of this length, so a cancel is noticed within it
+constexpr std::chrono::milliseconds CANCEL_POLL(20);
+
+// Waits on cv until pred holds (true), or the deadline passes or cancel is set (false)
+template <typename Pred>
+bool waitUntilOrCancelled(std::condition_variable &cv, std::unique_lock<std::mutex> &lock,
+                          std::chrono::steady_clock::time_point deadline, const std::atomic<bool> *cancel, Pred pred)
+{
+    while (true)
+    {
+        if (pred())
+            return true;
+        if (cancel && cancel->load())
+            return false;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return false;
+        if (!cancel && deadline == std::chrono::steady_clock::time_point::max())
+        {
+            cv.wait(lock, pred);
+            return true;
+        }
+
+        auto wake = cancel && deadline - now > CANCEL_POLL ? now + CANCEL_POLL : deadline;
+        if (cv.wait_until(lock, wake, pred))
+            return true;
+    }
+}
+
+// Raises a stop flag when a deadline passes or the cancel flag is set, for as long as it is alive
+class DeadlineWatch
+{
+public:
+    explicit DeadlineWatch(std::chrono::steady_clock::time_point deadline, const std::atomic<bool> *cancel = nullptr)
+        : cancel_(cancel)
+    {
+        // Without a deadline the solvers read the cancel flag directly
+        if (deadline == std::chrono::steady_clock::time_point::max())
+            return;
+
+        watcher_ = std::thread([this, deadline]()
+                               {
+            std::unique_lock<std::mutex> lock(mtx_);
+            if (!waitUntilOrCancelled(cv_, lock, deadline, cancel_, [this]() { return done_; }))
+                stop_ = true; });
+    }
+
+    ~DeadlineWatch()
+    {
+        if (!watcher_.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            done_ = true;
+        }
+        cv_.notify_all();
+        watcher_.join();
+    }
+
+    // nullptr without a deadline or cancel flag, so solvers skip the checks entirely
+    const std::atomic<bool> *flag() const { return watcher_.joinable() ? &stop_ : cancel_; }
+    bool expired() const { return stop_.load() || (cancel_ && cancel_->load()); }
+
+private:
+    const std::atomic<bool> *cancel_;
+    std::atomic<bool> stop_{false};
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool done_ = false;
+    std::thread watcher_;
+};
+}
+
 TMSTCStar::TMSTCStar(const Mat &map, const std::vector<int> &robot_positions,
                      const TMSTCStarConfig &config)
     : map_(map), robot_init_pos_(robot_positions), config_(config)
 {
+    tmstc::setVerbosity(config_.verbosity);
 
     // Initialize dimensions
     smallrows_ = map_.size();
@@ -20,7 +105,7 @@ TMSTCStar::TMSTCStar(const Mat &map, const std::vector<std::pair<int, int>> &rob
                      const TMSTCStarConfig &config)
     : map_(map), config_(config)
 {
-
+    tmstc::setVerbosity(config_.verbosity);
 
     // Initialize dimensions
     smallrows_ = map_.size();
@@ -36,12 +121,12 @@ TMSTCStar::TMSTCStar(const Mat &map, const std::vector<std::pair<int, int>> &rob
         auto indx = coordToIndex(robot_positions[i].first * 2, robot_positions[i].second * 2, bigcols_);
 
         robot_init_pos_[i] = indx;
-        std::cout << "Robot " << i + 1 << " position: (" << robot_positions[i].first << ","
-                  << robot_positions[i].second << ") -> index: " << robot_init_pos_[i] << std::endl;
+        TMSTC_LOG(DETAIL, "Robot " << i + 1 << " position: (" << robot_positions[i].first << ","
+                                   << robot_positions[i].second << ") -> index: " << robot_init_pos_[i] << std::endl);
 
         auto coord = indexToCoord(robot_init_pos_[i], bigcols_);
-        std::cout << "Index " << robot_init_pos_[i] << " -> reg coordinates: (" << coord.first << ","
-                  << coord.second << ")" << std::endl;
+        TMSTC_LOG(DETAIL, "Index " << robot_init_pos_[i] << " -> reg coordinates: (" << coord.first << ","
+                                   << coord.second << ")" << std::endl);
 
         if (std::find(robot_init_pos_.begin(), robot_init_pos_.end(), indx) == robot_init_pos_.end())
         {
@@ -91,6 +176,9 @@ void TMSTCStar::preprocessMap()
 
 void TMSTCStar::showMapInfo()
 {
+    if (!tmstc::logEnabled(Verbosity::SUMMARY))
+        return;
+
     int free_cells = 0;
     for (int i = 0; i < smallrows_; ++i)
     {
@@ -121,70 +209,540 @@ void TMSTCStar::getPathInfo()
 
 
 
-        int turns = 0;
-        for (int j = 1; j < paths_.at(i).size()!=0 && paths_.at(i).size() - 1 ; ++j)
-        {
-            turns += isSameLine(paths_.at(i)[j - 1], paths_.at(i)[j], paths_.at(i)[j + 1]) ? 0 : 1;
-        }
+        PathCostBreakdown cost;
+        evaluatePathCost(paths_.at(i).data(), paths_.at(i).size(), robotVehicleParams(i), smallcols_, cost);
 
         std::cout << "Path " << i << ": length=" << paths_.at(i).size()
-                  << ", turns=" << turns
+                  << ", turns=" << cost.turns
                 //   << ", total_cost=" << (1.0 * paths_.at(i).size() + ONE_TURN_VAL * turns)
-                  << ", total_cost=" << computePathCost(paths_.at(i), config_.vehicle_params, smallcols_)
+                  << ", total_cost=" << cost.total
                   << std::endl;
     }
 }
 
-Mat TMSTCStar::calculateRegionIndxPaths()
+MSTGrid TMSTCStar::buildMST(const std::string &shape, const std::atomic<bool> *stop_flag) const
 {
-    std::cout << "Calculating paths with " << config_.allocate_method << " using "
-              << config_.mst_shape << " shape..." << std::endl;
+    if (config_.tile_size > 0 && (smallrows_ > config_.tile_size || smallcols_ > config_.tile_size))
+        return buildTiledMST(shape, stop_flag);
 
-    if (config_.allocate_method == "MSTC")
+    return buildTree(map_grid_.view(), shape, stop_flag, dinic_, config_.aco_threads);
+}
+
+MSTGrid TMSTCStar::buildTree(BitGridView map, const std::string &shape, const std::atomic<bool> *stop_flag, Dinic &dinic,
+                             int aco_threads) const
+{
+    Division div(map);
+
+    // Create the MST based on the shape configuration
+    if (shape == "RECT_DIV")
     {
-        Division div(map_);
+        return div.rectDivisionSolver();
+    }
+    else if (shape == "DFS_VERTICAL")
+    {
+        return div.dfsWithStackSolver(VERTICAL);
+    }
+    else if (shape == "DFS_HORIZONTAL")
+    {
+        return div.dfsWithStackSolver(HORIZONTAL);
+    }
+    else if (shape == "KRUSKAL")
+    {
+        return div.kruskalSolver();
+    }
+    else if (shape == "ACO_OPT")
+    {
+        ACO_STC aco(1, 1, 1, 0.15, 60, config_.max_iterations, map, MSTGrid());
+        aco.setStopFlag(stop_flag);
+        aco.setSeed(config_.aco_seed);
+        aco.setThreads(aco_threads);
+        return aco.aco_stc_solver();
+    }
+    else if (shape == "DINIC")
+    {
+        return dinic.dinic_solver(map, true);
+    }
+    else if (shape == "HEURISTIC")
+    {
+        HeuristicSolver::HeuristicPartition hp(map, config_.max_iterations);
+        hp.setStopFlag(stop_flag);
+        return hp.hpSolver(true);
+    }
+
+    std::cout << "Unknown MST shape: " << shape << ", defaulting to RECT_DIV" << std::endl;
+    return div.rectDivisionSolver();
+}
+
+MSTGrid TMSTCStar::buildTiledMST(const std::string &shape, const std::atomic<bool> *stop_flag) const
+{
+    const int tile = config_.tile_size;
+    const int tile_rows = (smallrows_ + tile - 1) / tile;
+    const int tile_cols = (smallcols_ + tile - 1) / tile;
+    const int num_tiles = tile_rows * tile_cols;
 
-        // Create the MST based on the shape configuration
-        if (config_.mst_shape == "RECT_DIV")
+    // Tile-local trees, each on its own grid so workers share nothing
+    std::vector<MSTGrid> local_trees(num_tiles);
+    std::atomic<int> next_tile{0};
+    int aco_threads = 1; // Set with the thread count below, before any worker starts
+
+    auto worker = [&]()
+    {
+        Dinic dinic;
+        for (int t = next_tile++; t < num_tiles; t = next_tile++)
         {
-            mst_ = div.rectDivisionSolver();
+            int r0 = (t / tile_cols) * tile, c0 = (t % tile_cols) * tile;
+            int rows = std::min(tile, smallrows_ - r0), cols = std::min(tile, smallcols_ - c0);
+
+            BitGrid sub(rows, cols);
+            bool any_free = false;
+            for (int i = 0; i < rows; ++i)
+            {
+                for (int j = 0; j < cols; ++j)
+                {
+                    if (map_grid_.test(r0 + i, c0 + j))
+                    {
+                        sub.set(i * cols + j);
+                        any_free = true;
+                    }
+                }
+            }
+            if (!any_free)
+                continue;
+
+            // A tile the solver cannot handle is left empty, stitching then covers its cells
+            try
+            {
+                local_trees[t] = buildTree(sub.view(), shape, stop_flag, dinic, aco_threads);
+            }
+            catch (const std::exception &e)
+            {
+                std::cout << "Tiled MST: tile " << t << " failed: " << e.what() << std::endl;
+                Logger::warning("TMSTC - Tiled MST: tile " + std::to_string(t) + " failed: " + e.what());
+            }
         }
-        else if (config_.mst_shape == "DFS_VERTICAL")
+    };
+
+    int num_threads = config_.tile_threads > 0 ? config_.tile_threads
+                                               : static_cast<int>(std::thread::hardware_concurrency());
+    num_threads = std::max(1, std::min(num_threads, num_tiles));
+
+    // Tiles already run in parallel, an ACO_OPT tile gets its share of the cores
+    int aco_budget = config_.aco_threads > 0 ? config_.aco_threads
+                                             : static_cast<int>(std::thread::hardware_concurrency());
+    aco_threads = std::max(1, aco_budget / num_threads);
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < num_threads; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &t : threads)
+        t.join();
+
+    // Copy the tile trees into the full grid. Solvers are not built for the fragmented maps a tile
+    // can hold, so edges touching blocked cells or closing a cycle are dropped.
+    MSTGrid tree(smallrows_, smallcols_);
+    UnionFind uf(smallrows_ * smallcols_);
+    auto addTileEdge = [&](int from, int to)
+    {
+        if (!map_[from / smallcols_][from % smallcols_] || !map_[to / smallcols_][to % smallcols_] || uf.same(from, to))
+            return;
+        tree.addEdge(from, to);
+        uf.unite(from, to);
+    };
+
+    for (int t = 0; t < num_tiles; ++t)
+    {
+        const MSTGrid &local = local_trees[t];
+        int r0 = (t / tile_cols) * tile, c0 = (t % tile_cols) * tile;
+        for (int idx = 0; idx < local.size(); ++idx)
         {
-            mst_ = div.dfsWithStackSolver(VERTICAL);
+            int from = (r0 + idx / local.cols()) * smallcols_ + c0 + idx % local.cols();
+            if (local.hasEdge(idx, MST_RIGHT))
+                addTileEdge(from, from + 1);
+            if (local.hasEdge(idx, MST_DOWN))
+                addTileEdge(from, from + smallcols_);
         }
-        else if (config_.mst_shape == "DFS_HORIZONTAL")
+    }
+
+    // Stitch the tiles (and anything a tile solver left out) through the boundary edges adding the fewest turns
+    connectComponents(tree, uf, 0, smallrows_ - 1, 0, smallcols_ - 1);
+    if (!spansMap(uf))
+        Logger::warning("TMSTC - Tiled MST does not span the map, is eliminateIslands() missing?");
+
+    TMSTC_LOG(SUMMARY, "Tiled MST: " << num_tiles << " tiles of " << tile << "x" << tile << " on " << num_threads << " threads" << std::endl);
+    return tree;
+}
+
+Mat TMSTCStar::cutMST(const MSTGrid &mst, const std::atomic<bool> *stop_flag, PlanReport *report) const
+{
+    PathCut cut(map_grid_.view(), region_grid_.view(), mst.view(), robot_init_pos_,
+                config_.vehicle_params, config_.max_iterations, config_.cover_and_return);
+    cut.setPointFilteringFunction(config_.is_point_filtered_func);
+    cut.setPointFilterMask(config_.point_filter_mask.view());
+    cut.setStopFlag(stop_flag);
+    cut.setWarmStart(warm_start_cells_);
+    cut.setRobotParameters(config_.robot_vehicle_params);
+    cut.setEnduranceLimits(config_.robot_endurance_s);
+    Mat paths = cut.cutSolver();
+    if (report)
+    {
+        report->phases.cut = cut.getPhaseTimes();
+        report->counters = cut.getCounters();
+        report->within_endurance = cut.withinEndurance();
+        if (!report->within_endurance)
+            Logger::warning("TMSTC - The plan exceeds the endurance of at least one robot");
+    }
+    return paths;
+}
+
+const std::vector<std::string> TMSTCStar::PORTFOLIO_SHAPES = {
+    "RECT_DIV", "DFS_VERTICAL", "DFS_HORIZONTAL", "KRUSKAL", "ACO_OPT", "DINIC", "HEURISTIC"};
+
+Mat TMSTCStar::solvePortfolio(std::chrono::steady_clock::time_point deadline)
+{
+    struct Candidate
+    {
+        MSTGrid mst;
+        Mat paths;
+        double max_cost = 0.0;
+        double total_cost = 0.0;
+        bool within_endurance = true;
+        bool done = false;     // Produced a plan
+        bool finished = false; // Ran to the end, successfully or not
+    };
+
+    // Shared with the workers, which may outlive this call: once the budget is spent the best finished
+    // candidate is returned without waiting for shapes still in a stage that does not poll the stop flag.
+    // Those workers are kept in portfolio_workers_ and joined by the next run or the destructor.
+    struct PortfolioRun
+    {
+        explicit PortfolioRun(const TMSTCStar &planner) : solver(planner) {}
+
+        TMSTCStar solver;                // Snapshot of the planner, so workers never touch it
+        std::vector<std::string> shapes; // Copy of PORTFOLIO_SHAPES, which a static planner may outlive
+        std::vector<Candidate> candidates;
+        std::atomic<size_t> next_shape{0};
+        std::atomic<bool> stop{false};
+        std::mutex mtx;
+        std::condition_variable cv;
+        size_t finished = 0;
+    };
+
+    // Stragglers of the previous run were stopped, wait for them so runs never pile up
+    portfolio_workers_.join();
+
+    const size_t num_shapes = PORTFOLIO_SHAPES.size();
+    auto run = std::make_shared<PortfolioRun>(*this);
+    run->solver.config_.cancel_flag = nullptr; // Owned by the caller, the run has its own stop flag
+    run->solver.plan_cache_.reset();
+    run->shapes = PORTFOLIO_SHAPES;
+    run->candidates.resize(num_shapes);
+
+    // Workers pull shapes until all are taken or the run is stopped
+    auto worker = [run, num_shapes]()
+    {
+        const TMSTCStar &solver = run->solver;
+        while (!run->stop.load())
         {
-            mst_ = div.dfsWithStackSolver(HORIZONTAL);
+            size_t i = run->next_shape++;
+            if (i >= num_shapes)
+                break;
+
+            Candidate c;
+            try
+            {
+                c.mst = solver.buildMST(run->shapes[i], &run->stop);
+                PlanReport report;
+                c.paths = solver.cutMST(c.mst, &run->stop, &report);
+                c.within_endurance = report.within_endurance;
+                for (size_t r = 0; r < c.paths.size(); ++r)
+                {
+                    double cost = computePathCost(c.paths[r], solver.robotVehicleParams(r), solver.smallcols_);
+                    c.max_cost = std::max(c.max_cost, cost);
+                    c.total_cost += cost;
+                }
+                c.done = !c.paths.empty();
+            }
+            catch (const std::exception &e)
+            {
+                std::cout << "Portfolio: " << run->shapes[i] << " failed: " << e.what() << std::endl;
+                Logger::warning("TMSTC - Portfolio: " + run->shapes[i] + " failed: " + e.what());
+            }
+            c.finished = true;
+
+            {
+                std::lock_guard<std::mutex> lock(run->mtx);
+                run->candidates[i] = std::move(c);
+                run->finished++;
+            }
+            run->cv.notify_all();
         }
-        else if (config_.mst_shape == "KRUSKAL")
+    };
+
+    int num_threads = config_.portfolio_threads > 0 ? config_.portfolio_threads
+                                                    : static_cast<int>(std::thread::hardware_concurrency());
+    num_threads = std::max(1, std::min(num_threads, static_cast<int>(num_shapes)));
+
+    // ACO_OPT runs next to the other shapes, so it gets one worker's share of the cores
+    int aco_budget = config_.aco_threads > 0 ? config_.aco_threads
+                                             : static_cast<int>(std::thread::hardware_concurrency());
+    run->solver.config_.aco_threads = std::max(1, aco_budget / num_threads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+        threads.emplace_back(worker);
+
+    std::vector<Candidate> candidates;
+    bool cut_short = false;
+    {
+        std::unique_lock<std::mutex> lock(run->mtx);
+        auto all_finished = [&]()
+        { return run->finished == num_shapes; };
+        auto any_done = [&]()
         {
-            mst_ = div.kruskalSolver();
+            return all_finished() || std::any_of(run->candidates.begin(), run->candidates.end(),
+                                                 [](const Candidate &c) { return c.done; });
+        };
+
+        // Without a budget the portfolio takes as long as the default shape, and keeps any shape
+        // that finished meanwhile with a better plan
+        auto budget_spent = [&]()
+        { return all_finished() || (config_.portfolio_time_budget_s <= 0 && run->candidates[PORTFOLIO_REFERENCE].finished); };
+        if (config_.portfolio_time_budget_s > 0)
+        {
+            auto budget_end = std::chrono::steady_clock::now() +
+                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<double>(config_.portfolio_time_budget_s));
+            deadline = std::min(deadline, budget_end);
         }
-        else if (config_.mst_shape == "ACO_OPT")
+        waitUntilOrCancelled(run->cv, lock, deadline, config_.cancel_flag, budget_spent);
+
+        // Nothing finished in time: running shapes stop at their next iteration and still return a valid plan
+        if (!any_done())
         {
-            ACO_STC aco(1, 1, 1, 0.15, 60, config_.max_iterations, map_, mst_);
-            mst_ = aco.aco_stc_solver();
+            run->stop = true;
+            run->cv.wait(lock, any_done);
         }
-        else if (config_.mst_shape == "DINIC")
+
+        cut_short = !all_finished();
+        candidates = std::move(run->candidates);
+        run->candidates.assign(num_shapes, Candidate());
+    }
+
+    run->stop = true;
+    portfolio_workers_.threads = std::move(threads);
+    // A caller's filter function must not be called after we return, so those workers are waited for
+    if (config_.is_point_filtered_func)
+        portfolio_workers_.join();
+    portfolio_cut_short_ = cut_short;
+
+    int best = -1;
+    for (size_t i = 0; i < num_shapes; ++i)
+    {
+        const Candidate &c = candidates[i];
+        if (!c.done)
+            continue;
+
+        TMSTC_LOG(SUMMARY, "Portfolio: " << PORTFOLIO_SHAPES[i] << " max cost " << c.max_cost
+                                         << ", total cost " << c.total_cost << std::endl);
+
+        // A plan every robot can fly comes first, then the makespan
+        if (best == -1 || c.within_endurance != candidates[best].within_endurance)
+        {
+            if (best == -1 || c.within_endurance)
+                best = i;
+        }
+        else if (c.max_cost < candidates[best].max_cost - eps ||
+                 (std::abs(c.max_cost - candidates[best].max_cost) <= eps && c.total_cost < candidates[best].total_cost))
+            best = i;
+    }
+
+    if (best == -1)
+        throw std::runtime_error("Portfolio: no spanning tree shape produced a plan");
+
+    portfolio_winner_ = PORTFOLIO_SHAPES[best];
+    report_.within_endurance = candidates[best].within_endurance;
+    TMSTC_LOG(SUMMARY, "Portfolio: selected " << portfolio_winner_
+                                              << (cut_short ? " (budget spent before every shape finished)" : "") << std::endl);
+    TMSTC_LOG_INFO(SUMMARY, "TMSTC - Portfolio selected " + portfolio_winner_ + " with max cost " +
+                                std::to_string(candidates[best].max_cost));
+
+    mst_ = std::move(candidates[best].mst);
+    return std::move(candidates[best].paths);
+}
+
+Mat TMSTCStar::calculateRegionIndxPaths()
+{
+    return calculateRegionIndxPaths(std::chrono::steady_clock::time_point::max());
+}
+
+Mat TMSTCStar::calculateRegionIndxPaths(std::chrono::steady_clock::time_point deadline)
+{
+    tmstc::setVerbosity(config_.verbosity);
+
+    PlanKey key;
+    PlanCache *cache = planCacheKey(key) ? planCache() : nullptr;
+    if (cache)
+    {
+        auto start = std::chrono::steady_clock::now();
+        CachedPlan cached;
+        bool hit = false;
+        try
         {
-            mst_ = dinic.dinic_solver(map_, true);
+            hit = cache->lookup(key, cached) && cached.paths.size() == robot_init_pos_.size();
         }
-        else if (config_.mst_shape == "HEURISTIC")
+        catch (const std::exception &e)
         {
-            HeuristicSolver::HeuristicPartition hp(map_, config_.max_iterations);
-            mst_ = hp.hpSolver(true);
+            Logger::warning("TMSTC - Plan cache lookup failed: " + std::string(e.what()));
         }
-        else
+
+        if (hit)
+        {
+            mst_ = std::move(cached.mst);
+            paths_ = std::move(cached.paths);
+            report_ = PlanReport();
+            report_.shape = cached.shape;
+            report_.cache_hit = true;
+            if (config_.mst_shape == "PORTFOLIO")
+                portfolio_winner_ = cached.shape;
+            updatePlanBalance(false);
+            report_.phases.total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            TMSTC_LOG(SUMMARY, "Plan cache hit: " << cached.shape << " plan for " << paths_.size() << " robots" << std::endl);
+            TMSTC_LOG_INFO(SUMMARY, "TMSTC - Plan cache hit, " + cached.shape + " plan loaded from " + cache->path());
+            return paths_;
+        }
+    }
+
+    // Iterative tree shapes get part of the budget, so cut balancing still has time to run
+    auto tree_deadline = deadline;
+    if (deadline != std::chrono::steady_clock::time_point::max())
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (deadline > now)
+            tree_deadline = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      (deadline - now) * DEADLINE_TREE_SHARE);
+    }
+
+    DeadlineWatch tree_watch(tree_deadline, config_.cancel_flag);
+    DeadlineWatch watch(deadline, config_.cancel_flag);
+    solvePlan(tree_watch.flag(), watch.flag(), deadline);
+    updatePlanBalance(watch.expired() || tree_watch.expired() || portfolio_cut_short_);
+
+    // Plans cut short by the deadline or the portfolio budget depend on timing, and would keep answering
+    // for the converged one. Plans past a robot's endurance are not kept either, a hit could not tell.
+    if (cache && !report_.balance.deadline_expired && report_.within_endurance)
+    {
+        try
         {
-            std::cout << "Unknown MST shape: " << config_.mst_shape << ", defaulting to RECT_DIV" << std::endl;
-            mst_ = div.rectDivisionSolver();
+            cache->store(key, {report_.shape, mst_, paths_});
         }
+        catch (const std::exception &e)
+        {
+            Logger::warning("TMSTC - Plan cache store failed: " + std::string(e.what()));
+        }
+    }
+    return paths_;
+}
+
+PlanCache *TMSTCStar::planCache()
+{
+    if (config_.plan_cache_path.empty())
+        return nullptr;
+
+    if (!plan_cache_ || plan_cache_->path() != config_.plan_cache_path)
+    {
+        try
+        {
+            plan_cache_ = std::make_shared<PlanCache>(config_.plan_cache_path, config_.plan_cache_max_bytes);
+        }
+        catch (const std::exception &e)
+        {
+            plan_cache_.reset();
+            std::cout << "Plan cache disabled: " << e.what() << std::endl;
+            Logger::warning("TMSTC - Plan cache disabled: " + std::string(e.what()));
+        }
+    }
+    return plan_cache_.get();
+}
 
-        // Create PathCut solver
-        PathCut cut(map_, region_, mst_, robot_init_pos_, config_.vehicle_params, config_.max_iterations ,config_.cover_and_return);
-        cut.setPointFilteringFunction(config_.is_point_filtered_func);
-        paths_ = cut.cutSolver();
+bool TMSTCStar::planCacheKey(PlanKey &key) const
+{
+    if (config_.plan_cache_path.empty() || map_.empty())
+        return false;
+
+    // A filter function cannot be hashed, the region mask can
+    const BitGrid &mask = config_.point_filter_mask;
+    bool use_mask = mask.size() == bigrows_ * bigcols_;
+    if (!use_mask && config_.is_point_filtered_func)
+        return false;
+
+    key.add(static_cast<uint64_t>(PlanCache::FORMAT_VERSION));
+
+    key.add(smallrows_).add(smallcols_);
+    BitGrid map_bits(map_);
+    for (uint64_t w : map_bits.words())
+        key.add(w);
+
+    key.add(static_cast<int>(robot_init_pos_.size()));
+    for (int pos : robot_init_pos_)
+        key.add(pos);
+
+    // Every setting that changes the plan (thread counts and verbosity do not)
+    key.add(config_.allocate_method).add(config_.mst_shape);
+    key.add(config_.robot_num).add(config_.cover_and_return).add(config_.max_iterations);
+    const VehicleParameters &vp = config_.vehicle_params;
+    key.add(vp.omega_rad).add(vp.acc).add(vp.vmax).add(vp.phi_max_rad).add(vp.cellSize_m);
+    key.add(static_cast<int>(vp.cost_model)).add(vp.turn_cells);
+    key.add(static_cast<int>(config_.robot_vehicle_params.size()));
+    for (const VehicleParameters &rp : config_.robot_vehicle_params)
+    {
+        key.add(rp.omega_rad).add(rp.acc).add(rp.vmax).add(rp.phi_max_rad);
+        key.add(static_cast<int>(rp.cost_model)).add(rp.turn_cells);
+    }
+    key.add(static_cast<int>(config_.robot_endurance_s.size()));
+    for (double e : config_.robot_endurance_s)
+        key.add(e);
+    key.add(static_cast<uint64_t>(config_.aco_seed)).add(config_.tile_size).add(config_.portfolio_time_budget_s);
+
+    key.add(use_mask);
+    if (use_mask)
+    {
+        for (uint64_t w : mask.words())
+            key.add(w);
+    }
+    return true;
+}
+
+Mat TMSTCStar::solvePlan(const std::atomic<bool> *tree_stop_flag, const std::atomic<bool> *stop_flag,
+                         std::chrono::steady_clock::time_point deadline)
+{
+    tmstc::setVerbosity(config_.verbosity);
+    TMSTC_LOG(SUMMARY, "Calculating paths with " << config_.allocate_method << " using "
+                                                 << config_.mst_shape << " shape..." << std::endl);
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    report_ = PlanReport();
+    report_.shape = config_.mst_shape;
+    portfolio_cut_short_ = false;
+
+    map_grid_ = BitGrid(map_);
+    region_grid_ = BitGrid(region_);
+
+    if (config_.allocate_method == "MSTC")
+    {
+        if (config_.mst_shape == "PORTFOLIO")
+        {
+            paths_ = solvePortfolio(deadline);
+            report_.shape = portfolio_winner_;
+        }
+        else
+        {
+            mst_ = buildMST(config_.mst_shape, tree_stop_flag);
+            report_.phases.mst_build_s = std::chrono::duration<double>(clock::now() - start).count();
+            paths_ = cutMST(mst_, stop_flag, &report_);
+        }
     }
     else if (config_.allocate_method == "MTSP")
     {
@@ -195,19 +753,257 @@ Mat TMSTCStar::calculateRegionIndxPaths()
     else
     {
         std::cout << "Unknown allocation method: " << config_.allocate_method << ", defaulting to MSTC" << std::endl;
-        
-        Division div(map_);
-        mst_ = div.rectDivisionSolver();
-        
-        PathCut cut(map_, region_, mst_, robot_init_pos_, config_.vehicle_params, config_.max_iterations ,config_.cover_and_return);
-        cut.setPointFilteringFunction(config_.is_point_filtered_func);
-        paths_ = cut.cutSolver();
+
+        mst_ = buildMST("RECT_DIV", tree_stop_flag);
+        report_.shape = "RECT_DIV";
+        report_.phases.mst_build_s = std::chrono::duration<double>(clock::now() - start).count();
+        paths_ = cutMST(mst_, stop_flag, &report_);
     }
 
-    getPathInfo();
+    if (tmstc::logEnabled(Verbosity::SUMMARY))
+        getPathInfo();
+    report_.phases.total_s = std::chrono::duration<double>(clock::now() - start).count();
     return paths_;
 }
 
+void TMSTCStar::updatePlanBalance(bool deadline_expired)
+{
+    report_.balance = PlanBalance();
+    report_.balance.deadline_expired = deadline_expired;
+
+    int num_paths = 0;
+    double total_cost = 0.0;
+    report_.balance.min_cost = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < paths_.size(); ++i)
+    {
+        double cost = computePathCost(paths_[i], robotVehicleParams(i), smallcols_);
+        report_.balance.max_cost = std::max(report_.balance.max_cost, cost);
+        report_.balance.min_cost = std::min(report_.balance.min_cost, cost);
+        total_cost += cost;
+        num_paths++;
+    }
+
+    if (num_paths == 0)
+    {
+        report_.balance.min_cost = 0.0;
+        return;
+    }
+
+    report_.balance.mean_cost = total_cost / num_paths;
+    if (report_.balance.mean_cost > 0.0)
+        report_.balance.imbalance = report_.balance.max_cost / report_.balance.mean_cost - 1.0;
+
+    if (deadline_expired)
+    {
+        TMSTC_LOG(SUMMARY, "Deadline expired, returning best plan so far (imbalance " << report_.balance.imbalance << ")" << std::endl);
+        TMSTC_LOG_INFO(SUMMARY, "TMSTC - Deadline expired, best plan so far has imbalance " + std::to_string(report_.balance.imbalance));
+    }
+}
+
+Mat TMSTCStar::replanIncremental(const Mat &map, const std::vector<int> &robot_positions,
+                                 std::chrono::steady_clock::time_point deadline)
+{
+    tmstc::setVerbosity(config_.verbosity);
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+
+    bool usable = hasPlan() && config_.allocate_method == "MSTC" &&
+                  map.size() == smallrows_ && !map.empty() && map[0].size() == smallcols_ &&
+                  robot_positions.size() == paths_.size();
+
+    Mat old_map = map_;
+    Mat old_paths = paths_;
+
+    reconfigureMapRobot(map, robot_positions);
+    eliminateIslands();
+
+    std::vector<int> changed_cells;
+    int free_cells = 0;
+    if (usable)
+    {
+        for (int i = 0; i < smallrows_; ++i)
+        {
+            for (int j = 0; j < smallcols_; ++j)
+            {
+                if (map_[i][j] != old_map[i][j])
+                    changed_cells.push_back(i * smallcols_ + j);
+                if (map_[i][j])
+                    free_cells++;
+            }
+        }
+
+        if (changed_cells.size() > config_.incremental_max_change_ratio * std::max(free_cells, 1))
+        {
+            TMSTC_LOG(SUMMARY, "Incremental replan: " << changed_cells.size() << " changed cells, solving from scratch" << std::endl);
+            usable = false;
+        }
+    }
+
+    if (!usable || !repairMST(changed_cells))
+    {
+        TMSTC_LOG_INFO(SUMMARY, "TMSTC - Incremental replan not possible, solving from scratch");
+        return calculateRegionIndxPaths(deadline);
+    }
+
+    report_ = PlanReport();
+    report_.shape = config_.mst_shape;
+    report_.incremental = true;
+    report_.phases.mst_build_s = std::chrono::duration<double>(clock::now() - start).count();
+
+    TMSTC_LOG(SUMMARY, "Incremental replan: repaired spanning tree around " << changed_cells.size() << " changed cells" << std::endl);
+    TMSTC_LOG_INFO(SUMMARY, "TMSTC - Incremental replan around " + std::to_string(changed_cells.size()) + " changed cells");
+
+    map_grid_ = BitGrid(map_);
+    region_grid_ = BitGrid(region_);
+
+    // Previous cut starts, per depot
+    warm_start_cells_.clear();
+    for (const auto &path : old_paths)
+        warm_start_cells_.push_back(path.empty() ? -1 : path.front());
+
+    bool deadline_expired = false;
+    try
+    {
+        DeadlineWatch watch(deadline, config_.cancel_flag);
+        paths_ = cutMST(mst_, watch.flag(), &report_);
+        deadline_expired = watch.expired();
+    }
+    catch (...)
+    {
+        warm_start_cells_.clear();
+        throw;
+    }
+    warm_start_cells_.clear();
+
+    if (tmstc::logEnabled(Verbosity::SUMMARY))
+        getPathInfo();
+    updatePlanBalance(deadline_expired);
+    report_.phases.total_s = std::chrono::duration<double>(clock::now() - start).count();
+    return paths_;
+}
+
+bool TMSTCStar::repairMST(const std::vector<int> &changed_cells)
+{
+    // Patched in place, a failed repair leaves a tree the caller rebuilds anyway
+    MSTGrid &tree = mst_;
+
+    // Drop the edges of cells that are no longer free. changed_cells is taken after eliminateIslands(),
+    // so it already holds the cells of removed islands and nothing outside it needs to be visited.
+    int min_r = smallrows_, max_r = -1, min_c = smallcols_, max_c = -1;
+    for (int cell : changed_cells)
+    {
+        int r = cell / smallcols_, c = cell % smallcols_;
+        min_r = std::min(min_r, r), max_r = std::max(max_r, r);
+        min_c = std::min(min_c, c), max_c = std::max(max_c, c);
+        if (!map_[r][c])
+            tree.removeCell(cell);
+    }
+
+    // Current tree components. Two cells of the changed window can still be joined through the rest of
+    // the tree, so the components are taken over the whole map: O(map), like the cut that follows.
+    int cell_num = smallrows_ * smallcols_;
+    UnionFind uf(cell_num);
+    for (int idx = 0; idx < cell_num; ++idx)
+    {
+        if (tree.hasEdge(idx, MST_RIGHT))
+            uf.unite(idx, idx + 1);
+        if (tree.hasEdge(idx, MST_DOWN))
+            uf.unite(idx, idx + smallcols_);
+    }
+
+    // Join the components inside the changed window (plus a one cell margin) first,
+    // and over the whole map only if that is not enough
+    if (max_r >= 0)
+        connectComponents(tree, uf, min_r - 1, max_r + 1, min_c - 1, max_c + 1);
+    if (!spansMap(uf))
+    {
+        connectComponents(tree, uf, 0, smallrows_ - 1, 0, smallcols_ - 1);
+        if (!spansMap(uf))
+            return false;
+    }
+
+    return true;
+}
+
+void TMSTCStar::connectComponents(MSTGrid &tree, UnionFind &uf, int r0, int r1, int c0, int c1) const
+{
+    // Turn count a vertex adds to the coverage path for a given edge mask
+    auto vertexTurns = [](uint8_t mask)
+    {
+        int degree = __builtin_popcount(mask);
+        if (degree == 0)
+            return 0;
+        if (degree == 2)
+            return (mask == (MST_LEFT | MST_RIGHT) || mask == (MST_UP | MST_DOWN)) ? 0 : 2;
+        return degree == 4 ? 4 : 2;
+    };
+
+    struct Candidate
+    {
+        int cost, from, to;
+        bool operator<(const Candidate &c) const { return cost > c.cost; }
+    };
+
+    auto edgeCost = [&](int from, int to)
+    {
+        uint8_t e_from = (to == from + 1) ? MST_RIGHT : MST_DOWN;
+        uint8_t e_to = (to == from + 1) ? MST_LEFT : MST_UP;
+        return vertexTurns(tree.edges(from) | e_from) - vertexTurns(tree.edges(from)) +
+               vertexTurns(tree.edges(to) | e_to) - vertexTurns(tree.edges(to));
+    };
+
+    // Greedily join components with the edges that add the fewest turns
+    std::priority_queue<Candidate> que;
+    for (int i = std::max(r0, 0); i <= std::min(r1, smallrows_ - 1); ++i)
+    {
+        for (int j = std::max(c0, 0); j <= std::min(c1, smallcols_ - 1); ++j)
+        {
+            if (!map_[i][j])
+                continue;
+            int idx = i * smallcols_ + j;
+            if (j + 1 < smallcols_ && map_[i][j + 1] && !uf.same(idx, idx + 1))
+                que.push({edgeCost(idx, idx + 1), idx, idx + 1});
+            if (i + 1 < smallrows_ && map_[i + 1][j] && !uf.same(idx, idx + smallcols_))
+                que.push({edgeCost(idx, idx + smallcols_), idx, idx + smallcols_});
+        }
+    }
+
+    while (!que.empty())
+    {
+        Candidate cur = que.top();
+        que.pop();
+        if (uf.same(cur.from, cur.to))
+            continue;
+
+        int cost = edgeCost(cur.from, cur.to);
+        if (cost != cur.cost)
+        {
+            cur.cost = cost;
+            que.push(cur);
+            continue;
+        }
+
+        tree.addEdge(cur.from, cur.to);
+        uf.unite(cur.from, cur.to);
+    }
+}
+
+bool TMSTCStar::spansMap(UnionFind &uf) const
+{
+    int root = -1;
+    for (int idx = 0; idx < smallrows_ * smallcols_; ++idx)
+    {
+        if (!map_[idx / smallcols_][idx % smallcols_])
+            continue;
+        if (root == -1)
+            root = uf.find(idx);
+        else if (uf.find(idx) != root)
+            return false;
+    }
+    return true;
+}
+
 Mat TMSTCStar::shortenPaths(Mat &checkpoints, int interval_max)
 {
     if (paths_.empty())
@@ -219,8 +1015,12 @@ Mat TMSTCStar::shortenPaths(Mat &checkpoints, int interval_max)
     Mat shortened_paths(robot_num, std::vector<int>{});
     checkpoints.resize(robot_num);
 
+    std::vector<unsigned char> turns;
     for (int i = 0; i < robot_num; ++i)
     {
+        turns.resize(paths_[i].size());
+        markTurns(paths_[i].data(), paths_[i].size(), turns.data());
+
         // Always include the first point
         shortened_paths[i].push_back(paths_[i][0]);
         checkpoints[i].push_back(0);
@@ -232,7 +1032,7 @@ Mat TMSTCStar::shortenPaths(Mat &checkpoints, int interval_max)
         for (size_t step = 1; step < paths_[i].size() - 1; step++)
         {
             // Check if this point is a turning point
-            is_checkpoint = !isSameLine(paths_[i][step - 1], paths_[i][step], paths_[i][step + 1]);
+            is_checkpoint = turns[step];
 
             if (!is_checkpoint && interval)
             {
@@ -258,13 +1058,16 @@ Mat TMSTCStar::shortenPaths(Mat &checkpoints, int interval_max)
         shortened_paths[i].push_back(paths_[i].back());
     }
 
-    std::cout << "Path shortening: reduced from ";
-    for (int i = 0; i < robot_num; ++i)
+    if (tmstc::logEnabled(Verbosity::SUMMARY))
     {
-        std::cout << paths_[i].size() << " to " << shortened_paths[i].size()
-                  << " points (Robot " << i + 1 << "), ";
+        std::cout << "Path shortening: reduced from ";
+        for (int i = 0; i < robot_num; ++i)
+        {
+            std::cout << paths_[i].size() << " to " << shortened_paths[i].size()
+                      << " points (Robot " << i + 1 << "), ";
+        }
+        std::cout << std::endl;
     }
-    std::cout << std::endl;
 
     return shortened_paths;
 }
@@ -280,18 +1083,17 @@ TMSTCStar::PathStats TMSTCStar::getPathStatistics()
 
     stats.min_path_length = 1e9;
 
-    for (const auto& path : paths_) {
+    PathCostBreakdown cost;
+
+    for (size_t i = 0; i < paths_.size(); ++i) {
+        const auto &path = paths_[i];
         if (path.empty()) continue;
-        int path_turns = 0;
-        for (size_t j = 1; j < path.size() - 1; ++j) {
-            if (!isSameLine(path[j - 1], path[j], path[j + 1])) {
-                path_turns++;
-            }
-        }
-        
+
+        evaluatePathCost(path.data(), path.size(), robotVehicleParams(i), smallcols_, cost);
+
         stats.total_length += path.size() > 0 ? path.size() - 1 : 0;
-        stats.total_turns += path_turns;
-        double path_cost = computePathCost(path, config_.vehicle_params, smallcols_);
+        stats.total_turns += cost.turns;
+        double path_cost = cost.total;
         stats.total_cost += path_cost;
         stats.max_path_length = std::max(stats.max_path_length, path_cost);
         stats.min_path_length = std::min(stats.min_path_length, path_cost);
@@ -383,7 +1185,7 @@ Mat TMSTCStar::removeDuplicateEdgesOnPath()
                 continue;
             }
 
-            std::cout << (equal ? "true" : "false") << " Adding " << paths_[i][j] << " (" << coords.first << ", " << coords.second << ")" << " prev: (" << prev_coords.first << ", " << prev_coords.second << ")" << std::endl;
+            TMSTC_LOG(DETAIL, (equal ? "true" : "false") << " Adding " << paths_[i][j] << " (" << coords.first << ", " << coords.second << ")" << " prev: (" << prev_coords.first << ", " << prev_coords.second << ")" << std::endl);
 
             new_path.push_back(paths_[i][j]);
             prev_coords = coords;
@@ -391,7 +1193,7 @@ Mat TMSTCStar::removeDuplicateEdgesOnPath()
         new_path.push_back(paths_[i].back());
         paths_[i] = new_path;
 
-        std::cout << "New path size: " << paths_[i].size() << std::endl;
+        TMSTC_LOG(DETAIL, "New path size: " << paths_[i].size() << std::endl);
     }
 
     return paths_;
@@ -0,0 +1,123 @@
+#include "CoverageTable.h"
+
+#include <cmath>
+#include <algorithm>
+
+CoverageTable::CoverageTable()
+    : m_minX(0.0), m_minY(0.0), m_cellSize(0.0), m_cols(0), m_rows(0), m_dirty(false)
+{
+}
+
+void CoverageTable::setGrid(const XYConvexGrid &grid)
+{
+    m_cellOfIndex.clear();
+    m_cols = m_rows = 0;
+    m_dirty = true;
+
+    m_cellSize = grid.getCellSize();
+    if (!grid.valid() || m_cellSize <= 0)
+        return;
+
+    XYSquare bbox = grid.getSBound();
+    m_minX = bbox.get_min_x();
+    m_minY = bbox.get_min_y();
+    m_cols = static_cast<int>(bbox.getLengthX() / m_cellSize);
+    m_rows = static_cast<int>(bbox.getLengthY() / m_cellSize);
+
+    m_cellOfIndex.resize(grid.size(), -1);
+    for (unsigned int ix = 0; ix < grid.size(); ix++)
+    {
+        const XYSquare &cell = grid.getElement(ix);
+        int col = static_cast<int>(std::floor((cell.getCenterX() - m_minX) / m_cellSize));
+        int row = static_cast<int>(std::floor((cell.getCenterY() - m_minY) / m_cellSize));
+        if (col >= 0 && col < m_cols && row >= 0 && row < m_rows)
+            m_cellOfIndex[ix] = row * m_cols + col;
+    }
+
+    refresh(grid);
+}
+
+void CoverageTable::refresh(const XYConvexGrid &grid)
+{
+    if (!m_dirty || !valid() || grid.size() != m_cellOfIndex.size())
+        return;
+
+    m_discovered.assign(m_rows * m_cols, 0);
+    for (unsigned int ix = 0; ix < grid.size(); ix++)
+    {
+        if (m_cellOfIndex[ix] >= 0 && grid.getVal(ix, 0) > 0)
+            m_discovered[m_cellOfIndex[ix]] = 1;
+    }
+
+    const int stride = m_cols + 1;
+    m_sums.assign((m_rows + 1) * stride, 0);
+    for (int r = 0; r < m_rows; r++)
+    {
+        int row_sum = 0;
+        const unsigned char *bits = &m_discovered[r * m_cols];
+        int *above = &m_sums[r * stride];
+        int *sums = &m_sums[(r + 1) * stride];
+        for (int c = 0; c < m_cols; c++)
+        {
+            row_sum += bits[c];
+            sums[c + 1] = above[c + 1] + row_sum;
+        }
+    }
+    m_dirty = false;
+}
+
+void CoverageTable::cellRange(double x_min, double x_max, double y_min, double y_max,
+                              int &col_lo, int &col_hi, int &row_lo, int &row_hi) const
+{
+    // Cell c has its center at m_minX + (c + 0.5) * m_cellSize
+    col_lo = std::max(0, static_cast<int>(std::ceil((x_min - m_minX) / m_cellSize - 0.5)));
+    col_hi = std::min(m_cols - 1, static_cast<int>(std::floor((x_max - m_minX) / m_cellSize - 0.5)));
+    row_lo = std::max(0, static_cast<int>(std::ceil((y_min - m_minY) / m_cellSize - 0.5)));
+    row_hi = std::min(m_rows - 1, static_cast<int>(std::floor((y_max - m_minY) / m_cellSize - 0.5)));
+}
+
+int CoverageTable::sum(int col_lo, int col_hi, int row_lo, int row_hi) const
+{
+    const int stride = m_cols + 1;
+    return m_sums[(row_hi + 1) * stride + col_hi + 1] - m_sums[row_lo * stride + col_hi + 1] -
+           m_sums[(row_hi + 1) * stride + col_lo] + m_sums[row_lo * stride + col_lo];
+}
+
+void CoverageTable::countSquare(double x_min, double x_max, double y_min, double y_max, int &total, int &discovered) const
+{
+    total = discovered = 0;
+    if (!valid() || m_sums.empty())
+        return;
+
+    int col_lo, col_hi, row_lo, row_hi;
+    cellRange(x_min, x_max, y_min, y_max, col_lo, col_hi, row_lo, row_hi);
+    if (col_lo > col_hi || row_lo > row_hi)
+        return;
+
+    total = (col_hi - col_lo + 1) * (row_hi - row_lo + 1);
+    discovered = sum(col_lo, col_hi, row_lo, row_hi);
+}
+
+void CoverageTable::countSquares(const std::vector<double> &xs, const std::vector<double> &ys, double half_side,
+                                 std::vector<int> &total, std::vector<int> &discovered) const
+{
+    const size_t n = std::min(xs.size(), ys.size());
+    total.assign(n, 0);
+    discovered.assign(n, 0);
+    if (!valid() || m_sums.empty())
+        return;
+
+    // Empty ranges become zero-width ones, whose four corners cancel out, so the loop has no branches
+    const int stride = m_cols + 1;
+    const int *sums = m_sums.data();
+    for (size_t i = 0; i < n; i++)
+    {
+        int col_lo, col_hi, row_lo, row_hi;
+        cellRange(xs[i] - half_side, xs[i] + half_side, ys[i] - half_side, ys[i] + half_side,
+                  col_lo, col_hi, row_lo, row_hi);
+        int c0 = std::min(col_lo, m_cols), c1 = std::max(c0, col_hi + 1);
+        int r0 = std::min(row_lo, m_rows), r1 = std::max(r0, row_hi + 1);
+        total[i] = (c1 - c0) * (r1 - r0);
+        discovered[i] = sums[r1 * stride + c1] - sums[r0 * stride + c1] - sums[r1 * stride + c0] + sums[r0 * stride + c0];
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef COVERAGE_TABLE_H
+#define COVERAGE_TABLE_H
+
+#include <vector>
+#include "XYConvexGrid.h"
+
+// Dense bitmap of the discovered cells (value > 0) of a square-celled XYConvexGrid, with a summed-area
+// table on top, so the number of discovered cells in any axis-aligned square is four lookups.
+// Cells are laid out by their position in the grid's bounding box; cells missing from the grid count as
+// undiscovered.
+class CoverageTable
+{
+public:
+    CoverageTable();
+
+    // Take the layout and values of a new grid
+    void setGrid(const XYConvexGrid &grid);
+    // The grid's values changed (e.g. a VIEW_GRID_DELTA), the next refresh() reads them again
+    void invalidate() { m_dirty = true; }
+    // Rebuild the bitmap and the table from the grid's values if they changed
+    void refresh(const XYConvexGrid &grid);
+
+    bool valid() const { return m_cols > 0 && m_rows > 0; }
+
+    // Cells whose centers lie within [x_min, x_max] x [y_min, y_max], and how many of them are discovered
+    void countSquare(double x_min, double x_max, double y_min, double y_max, int &total, int &discovered) const;
+
+    // countSquare() for squares of half side half_side around each (xs[i], ys[i])
+    void countSquares(const std::vector<double> &xs, const std::vector<double> &ys, double half_side,
+                      std::vector<int> &total, std::vector<int> &discovered) const;
+
+private:
+    // Column and row ranges of the cell centers within the square, empty when lo > hi
+    void cellRange(double x_min, double x_max, double y_min, double y_max,
+                   int &col_lo, int &col_hi, int &row_lo, int &row_hi) const;
+    int sum(int col_lo, int col_hi, int row_lo, int row_hi) const;
+
+    double m_minX, m_minY, m_cellSize;
+    int m_cols, m_rows;
+    std::vector<int> m_cellOfIndex;       // Grid element index -> row * m_cols + col, -1 outside the box
+    std::vector<unsigned char> m_discovered;
+    std::vector<int> m_sums;              // (m_rows + 1) x (m_cols + 1), m_sums[r][c] = discovered cells above and left of (r, c)
+    bool m_dirty;
+};
+
+#endif
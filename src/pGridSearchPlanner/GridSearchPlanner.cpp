@@ -20,6 +20,7 @@
 #include "common.h"
 #include "Logger.h"
 #include "TMSTCVisualization.h"
+#include "Assignment.h"
 //---------------------------------------------------------
 // Constructor()
 
@@ -38,6 +39,20 @@ GridSearchPlanner::GridSearchPlanner()
 
   m_start_point_closest = false;
   m_tmstc_star_point_filtering = false;
+  m_tmstc_star_incremental_replan = true;
+  m_tmstc_star_dubins_smoothing = false;
+  m_tmstc_star_sortie_range = 0;
+  m_tmstc_star_time_budget = 0;
+  m_ignored_regions_changed = false;
+
+  m_posted_grids_version = 0;
+  m_posted_grids_visible = false;
+  m_assignment_makespan = 0;
+
+  m_plan_generation = 0;
+  m_plan_in_flight = false;
+  m_plan_worker_stop = false;
+  m_plan_cancel = false;
 
   m_path_publish_variable = "SURVEY_UPDATE";
 
@@ -61,6 +76,21 @@ GridSearchPlanner::GridSearchPlanner()
   m_tmstc_star_ptr = std::move(std::make_unique<TMSTCStar>(config));
 }
 
+//---------------------------------------------------------
+// Destructor
+
+GridSearchPlanner::~GridSearchPlanner()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+    m_plan_worker_stop = true;
+    m_plan_cancel = true;
+  }
+  m_plan_cv.notify_all();
+  if (m_plan_worker.joinable())
+    m_plan_worker.join();
+}
+
 //---------------------------------------------------------
 // Procedure: OnNewMail()
 
@@ -162,14 +192,14 @@ bool GridSearchPlanner::Iterate()
 {
   AppCastingMOOSApp::Iterate();
 
+  // Plans are solved in the background, a finished one is checked and sent out here
+  if (publishFinishedPlan())
+    notifyCalculatedPathsAndExecute(m_missionEnabled);
+
   if (m_do_plan_paths)
   {
-    if(doPlanPaths()){
-
-      notifyCalculatedPathsAndExecute(m_missionEnabled);
+    if (doPlanPaths())
       m_do_plan_paths = false;
-    };
-
   }
   else if (m_do_start_voronoi_searching)
   {
@@ -232,6 +262,40 @@ bool GridSearchPlanner::OnStartUp()
         handled = setBooleanOnString(m_isRunningMoosPid, value);
       else if (param == "tmstc_star_point_filtering")
         handled = setBooleanOnString(m_tmstc_star_point_filtering, value);
+      else if (param == "tmstc_star_incremental_replan")
+        handled = setBooleanOnString(m_tmstc_star_incremental_replan, value);
+      else if (param == "tmstc_star_dubins_smoothing")
+        handled = setBooleanOnString(m_tmstc_star_dubins_smoothing, value);
+      else if (param == "tmstc_star_sortie_range")
+      {
+        // Same quantity as pRefuelReplace's total_range, a MOOS distance
+        handled = setDoubleOnString(m_tmstc_star_sortie_range, value);
+        m_tmstc_star_ptr->getConfig().sortie_range_m = m_tmstc_star_sortie_range * MOOSDIST2METERS;
+      }
+      else if (param == "tmstc_star_refuel_time")
+        handled = setDoubleOnString(m_tmstc_star_ptr->getConfig().refuel_time_s, value);
+      else if (param == "tmstc_star_time_budget")
+        handled = setDoubleOnString(m_tmstc_star_time_budget, value);
+      else if (param == "tmstc_star_tile_size")
+        handled = setIntOnString(m_tmstc_star_ptr->getConfig().tile_size, value);
+      else if (param == "tmstc_star_plan_cache")
+      {
+        m_tmstc_star_ptr->getConfig().plan_cache_path = value;
+        handled = true;
+      }
+      else if (param == "tmstc_star_verbosity")
+      {
+        std::string level = tolower(value);
+        handled = true;
+        if (level == "quiet")
+          m_tmstc_star_ptr->getConfig().verbosity = Verbosity::QUIET;
+        else if (level == "summary")
+          m_tmstc_star_ptr->getConfig().verbosity = Verbosity::SUMMARY;
+        else if (level == "detail")
+          m_tmstc_star_ptr->getConfig().verbosity = Verbosity::DETAIL;
+        else
+          handled = false;
+      }
       else if (param == "path_publish_variable")
       {
         m_path_publish_variable = value;
@@ -255,6 +319,19 @@ bool GridSearchPlanner::OnStartUp()
           handled = true;
         }
       }
+      else if (param == "tmstc_star_config_cost_model")
+      {
+        std::string model = tolower(value);
+        handled = true;
+        if (model == "fixed_wing")
+          m_tmstc_star_ptr->getConfig().vehicle_params.cost_model = CostModelType::FIXED_WING;
+        else if (model == "multirotor")
+          m_tmstc_star_ptr->getConfig().vehicle_params.cost_model = CostModelType::MULTIROTOR;
+        else if (model == "turn_count")
+          m_tmstc_star_ptr->getConfig().vehicle_params.cost_model = CostModelType::TURN_COUNT;
+        else
+          handled = false;
+      }
       else if (param == "planner_mode")
       {
         std::string mode_str = toupper(value);
@@ -345,12 +422,14 @@ bool GridSearchPlanner::doPlanPaths()
 
   m_tmstc_grid_converter.transformGrid();
 
-  Mat spanningMap = m_tmstc_grid_converter.getSpanningGrid();
-  std::vector<int> robot_region_indeces = m_tmstc_grid_converter.getUniqueVehicleRegionIndices();
+  auto request = std::make_unique<PlanRequest>();
+  request->spanning_map = m_tmstc_grid_converter.getSpanningGrid();
+  request->robot_region_indices = m_tmstc_grid_converter.getUniqueVehicleRegionIndices();
+  request->robot_names = m_tmstc_vehicle_names;
 
-  if (robot_region_indeces.size() != m_map_drone_records.size())
+  if (request->robot_region_indices.size() != m_map_drone_records.size())
   {
-    std::string msg = "Number of robot region indeces (" + std::to_string(robot_region_indeces.size()) + ") does not match number of drones (" + std::to_string(m_map_drone_records.size()) + ").";
+    std::string msg = "Number of robot region indeces (" + std::to_string(request->robot_region_indices.size()) + ") does not match number of drones (" + std::to_string(m_map_drone_records.size()) + ").";
     m_generate_warnings.push_back(msg);
     Logger::error("doPlanPaths:" + msg);
     reportRunWarning(msg);
@@ -359,189 +438,209 @@ bool GridSearchPlanner::doPlanPaths()
     return false;
   }
 
-  // Create the TMSTC* instance and calculate paths
-  m_tmstc_star_ptr->reconfigureMapRobot(spanningMap, robot_region_indeces);
+  // Ignored regions only change a few cells, so the previous plan can be repaired instead of resolved
+  request->incremental = m_tmstc_star_incremental_replan && m_ignored_regions_changed;
+  m_ignored_regions_changed = false;
 
-  m_tmstc_star_ptr->getConfig().is_point_filtered_func =  [this](int point_idx)
-  {
-    return is_pathIdx_filtered(point_idx);
-  };
+  // Evaluate the point filter once per solve, the solver then filters whole paths against the bitmap
+  request->config = m_tmstc_star_ptr->getConfig();
+  request->config.is_point_filtered_func = nullptr;
+  request->config.point_filter_mask = buildPointFilterMask(request->spanning_map);
+  request->config.cancel_flag = &m_plan_cancel;
 
-  Mat paths_robot_indx;
+  // With a time budget the solver returns its best plan so far when the budget runs out
+  request->time_budget = m_tmstc_star_time_budget;
 
-  const int tries = 1;
-  for(int i = 0; i < tries; i++)
-  { 
-    try
-    {
-      if(i == 0){
-        m_tmstc_star_ptr->eliminateIslands();
-        reportEvent("Calculating paths...");
-        Logger::info("doPlanPat<hs: Calculating paths...");
-      }
-      else{
-        reportEvent("Retrying path calculation...");
-        Logger::info("doPlanPaths: Retrying path calculation...");
-      }
-      paths_robot_indx = m_tmstc_star_ptr->calculateRegionIndxPaths();
-      Logger::info("doPlanPaths: Calculating paths... Region Index paths calculated.");
+  reportEvent(request->incremental ? "Replanning paths around changed ignored regions..." : "Calculating paths...");
+  Logger::info("doPlanPaths: Plan request submitted to the planning thread.");
+  submitPlanRequest(std::move(request));
+  return true;
+}
 
+void GridSearchPlanner::submitPlanRequest(std::unique_ptr<PlanRequest> request)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+    request->generation = ++m_plan_generation;
+
+    // A request still waiting is replaced (its ignored region changes are kept), one being solved is cancelled
+    if (m_pending_plan && m_pending_plan->incremental)
+      request->incremental = true;
+    m_pending_plan = std::move(request);
+    m_finished_plan.reset();
+    if (m_plan_in_flight)
+      m_plan_cancel = true;
+  }
 
-      m_is_paths_calculated = true;
-      break; // Exit loop if successful
-    }
-    catch (const std::exception &e)
+  if (!m_plan_worker.joinable())
+    m_plan_worker = std::thread(&GridSearchPlanner::planWorkerLoop, this);
+  m_plan_cv.notify_one();
+}
+
+void GridSearchPlanner::planWorkerLoop()
+{
+  while (true)
+  {
+    std::unique_ptr<PlanRequest> request;
     {
+      std::unique_lock<std::mutex> lock(m_plan_mutex);
+      m_plan_cv.wait(lock, [this]()
+                     { return m_plan_worker_stop || m_pending_plan != nullptr; });
+      if (m_plan_worker_stop)
+        return;
+      request = std::move(m_pending_plan);
+      m_plan_cancel = false;
+      m_plan_in_flight = true;
+    }
 
-      std::string msg = "Failed to calculate paths. Exception: " + std::string(e.what());
-      m_generate_warnings.push_back(msg);
+    auto result = std::make_unique<PlanResult>();
+    result->generation = request->generation;
+    result->robot_names = request->robot_names;
+    try
+    {
+      // The worker's own solver keeps the previous plan for incremental repairs
+      if (m_plan_solver == nullptr)
+        m_plan_solver = std::make_unique<TMSTCStar>(request->config);
+      else
+        m_plan_solver->getConfig() = request->config;
 
-      Logger::error("doPlanPaths:" + msg);
-      reportRunWarning(msg);
-      postCalculatedPaths(false);
-      m_is_paths_calculated = false;
+      auto deadline = std::chrono::steady_clock::time_point::max();
+      if (request->time_budget > 0)
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(request->time_budget));
 
-      if(i == tries - 1)
+      result->incremental = request->incremental && m_plan_solver->hasPlan();
+      if (result->incremental)
       {
-        Logger::error("doPlanPaths: Max retries reached. Unable to calculate paths.");
-        return false; // Exit if max retries reached
+        Logger::info("planWorkerLoop: Replanning paths incrementally...");
+        m_plan_solver->replanIncremental(request->spanning_map, request->robot_region_indices, deadline);
       }
-
+      else
+      {
+        Logger::info("planWorkerLoop: Calculating paths...");
+        m_plan_solver->reconfigureMapRobot(request->spanning_map, request->robot_region_indices);
+        m_plan_solver->eliminateIslands();
+        m_plan_solver->calculateRegionIndxPaths(deadline);
+      }
+      result->solver = std::make_unique<TMSTCStar>(*m_plan_solver);
+    }
+    catch (const std::exception &e)
+    {
+      result->error = e.what();
     }
+
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+    m_plan_in_flight = false;
+    // A superseded result is dropped, the newer request is already waiting
+    if (result->generation == m_plan_generation)
+      m_finished_plan = std::move(result);
   }
+}
 
+bool GridSearchPlanner::publishFinishedPlan()
+{
+  std::unique_ptr<PlanResult> result;
+  {
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+    result = std::move(m_finished_plan);
+  }
+  if (result == nullptr)
+    return false;
 
-  if(paths_robot_indx.size() != m_map_drone_records.size())
-    {
-      std::string msg = "Number of paths calculated (" + std::to_string(paths_robot_indx.size()) + ") does not match number of drones (" + std::to_string(m_map_drone_records.size()) + ").";
-      m_generate_warnings.push_back(msg);
-      reportRunWarning(msg);
-      Logger::error("doPlanPaths:" + msg);
-      m_is_paths_calculated = false;
-      return false;
-    }
+  // Failed plans are requested again on the next iteration
+  if (!result->error.empty())
+  {
+    std::string msg = "Failed to calculate paths. Exception: " + result->error;
+    m_generate_warnings.push_back(msg);
+    Logger::error("publishFinishedPlan:" + msg);
+    reportRunWarning(msg);
+    postCalculatedPaths(false);
+    m_is_paths_calculated = false;
+    m_do_plan_paths = true;
+    return false;
+  }
 
-  for(auto path : paths_robot_indx)
+  const Mat &paths_robot_indx = result->solver->getPaths();
+  std::string msg;
+  if (paths_robot_indx.size() != m_map_drone_records.size())
+    msg = "Number of paths calculated (" + std::to_string(paths_robot_indx.size()) + ") does not match number of drones (" + std::to_string(m_map_drone_records.size()) + ").";
+  for (const auto &path : paths_robot_indx)
   {
-    if(path.size() == 0)
-    {
-      std::string msg = "Empty path calculated for a vehicle.";
-      m_generate_warnings.push_back(msg);
-      reportRunWarning(msg);
-      Logger::error("doPlanPaths:" + msg);
-      m_is_paths_calculated = false;
-      return false;
-    }
+    if (path.empty())
+      msg = "Empty path calculated for a vehicle.";
+  }
+  if (!msg.empty())
+  {
+    m_generate_warnings.push_back(msg);
+    reportRunWarning(msg);
+    Logger::error("publishFinishedPlan:" + msg);
+    m_is_paths_calculated = false;
+    m_do_plan_paths = true;
+    return false;
   }
 
-  assignPathsToVehicles(paths_robot_indx);
+  m_tmstc_star_ptr = std::move(result->solver);
+  m_plan_robot_names = std::move(result->robot_names);
+  m_is_paths_calculated = true;
+  assignPathsToVehicles(m_tmstc_star_ptr->getPaths());
 
-  Logger::info("doPlanPaths: Paths calculated.");
+  Logger::info("publishFinishedPlan: Paths calculated.");
   reportEvent("Paths calculated.");
 
   clearAllGenerateWarnings();
   return true;
 }
 
-bool GridSearchPlanner::is_pathIdx_filtered(int idx)
+BitGrid GridSearchPlanner::buildPointFilterMask(const Mat &spanningMap)
 {
+  if (spanningMap.empty())
+    return BitGrid();
+
+  // The region grid splits every spanning cell in four, only cells of free spanning cells can be on a path
+  int rows = spanningMap.size() * 2;
+  int cols = spanningMap[0].size() * 2;
+  BitGrid mask(rows, cols);
+  m_coverage_table.refresh(m_grid_viz);
+  for (int r = 0; r < rows; r++)
+    for (int c = 0; c < cols; c++)
+      if (spanningMap[r / 2][c / 2] && is_regionCoord_filtered(c, r))
+        mask.set(r * cols + c);
+
+  return mask;
+}
 
+bool GridSearchPlanner::is_pathIdx_filtered(int idx)
+{
   std::pair<int, int> region_coord = m_tmstc_star_ptr->indexToRegionCoord(idx);
-  XYPoint xy_point = m_tmstc_grid_converter.regionCoord2XYPointMoos(region_coord.first, region_coord.second);
-  if (!xy_point.valid())
-  {
-    Logger::error("is_pathIdx_filtered: Invalid XYPoint for index " + std::to_string(idx));
-    return true; // Filter out invalid points
-  }
-
-  // Check if the point is inside any ignored region
-  // Get grid properties
-  static const XYPolygon searchRegion = m_tmstc_grid_converter.getSearchRegion();
-  static const XYSquare bbox = m_grid_viz.getSBound();
-  static const double bbox_min_x = bbox.get_min_x();
-  static const double bbox_min_y = bbox.get_min_y();
-  static const double grid_cell_size = m_grid_viz.getCellSize();
+  return is_regionCoord_filtered(region_coord.first, region_coord.second);
+}
 
-  double x = xy_point.get_vx();
-  double y = xy_point.get_vy();
+bool GridSearchPlanner::is_regionCoord_filtered(int col, int row)
+{
 
-  // Check if waypoint is in an ignored region or outside the search region
-  if (!searchRegion.contains(x, y))
+  XYPoint xy_point = m_tmstc_grid_converter.regionCoord2XYPointMoos(col, row);
+  if (!xy_point.valid())
   {
-    // Logger::info("Pruning waypoint at: (" + doubleToStringX(x, 2) +
-    //             ", " + doubleToStringX(y, 2) + ") - Outside search region");
+    Logger::error("is_regionCoord_filtered: Invalid XYPoint for region coordinate (" + std::to_string(col) + "," + std::to_string(row) + ")");
     return true; // Filter out invalid points
   }
 
-  // Check if waypoint is in an ignored region
-  for (const auto &[_, region] : m_map_ignored_regions_poly)
-  {
-    if (region.contains(x, y))
-    {
-      // Logger::info("Pruning waypoint at: (" + doubleToStringX(x, 2) +
-      //             ", " + doubleToStringX(y, 2) + ") - In ignored region");
-      return true; // Filter out invalid points
-    }
-  }
+  // Outside the search region or in an ignored region, read from the converter's rasterized mask
+  if (!m_tmstc_grid_converter.isRegionCellFree(col, row))
+    return true; // Filter out invalid points
 
   if (!m_tmstc_star_point_filtering)
     return false; // No filtering needed
 
-  // Define the square area around the waypoint (sensor coverage)
-  double x_min = x - m_coveragecellradius;
-  double x_max = x + m_coveragecellradius;
-  double y_min = y - m_coveragecellradius;
-  double y_max = y + m_coveragecellradius;
-
-  // Convert world coordinates to grid cell indices
-  int col_start = static_cast<int>(std::floor((x_min - bbox_min_x) / grid_cell_size));
-  int col_end = static_cast<int>(std::floor((x_max - bbox_min_x) / grid_cell_size));
-  int row_start = static_cast<int>(std::floor((y_min - bbox_min_y) / grid_cell_size));
-  int row_end = static_cast<int>(std::floor((y_max - bbox_min_y) / grid_cell_size));
-
-  // Clamp to valid grid indices
-  col_start = std::max(0, col_start);
-  row_start = std::max(0, row_start);
-  col_end = std::min(col_end, static_cast<int>(bbox.getLengthX() / grid_cell_size) - 1);
-  row_end = std::min(row_end, static_cast<int>(bbox.getLengthY() / grid_cell_size) - 1);
-
-  // Check if area is completely outside the grid
-  if (col_start > col_end || row_start > row_end)
-  {
-    return false; // No cells to check, dont filter
-  }
+  double x = xy_point.get_vx();
+  double y = xy_point.get_vy();
 
-  // Count discovered cells in this area
+  // Count discovered cells in the square area around the waypoint (sensor coverage)
   int total_cells = 0;
   int discovered_cells = 0;
-
-  for (int row = row_start; row <= row_end; row++)
-  {
-    for (int col = col_start; col <= col_end; col++)
-    {
-      // Calculate the center of this cell in world coordinates
-      double cell_center_x = bbox_min_x + (col + 0.5) * grid_cell_size;
-      double cell_center_y = bbox_min_y + (row + 0.5) * grid_cell_size;
-
-      // Only count cells whose centers are in the waypoint's coverage area
-      if (cell_center_x >= x_min && cell_center_x <= x_max &&
-          cell_center_y >= y_min && cell_center_y <= y_max)
-      {
-
-        total_cells++;
-
-        // Find this cell in the grid
-        cellP cell_center(cell_center_x, cell_center_y);
-        if (m_map_grid_cellCenter_idxs.count(cell_center) == 0)
-          continue;
-
-        unsigned int ix = m_map_grid_cellCenter_idxs[cell_center];
-        double cell_val = m_grid_viz.getVal(ix, 0);
-        if (cell_val > 0)
-          discovered_cells++;
-      }
-    }
-  }
+  m_coverage_table.countSquare(x - m_coveragecellradius, x + m_coveragecellradius,
+                               y - m_coveragecellradius, y + m_coveragecellradius,
+                               total_cells, discovered_cells);
 
   // If more than 50% of cells in this area are already discovered, remove the waypoint
   if (total_cells > 0 && ((double)discovered_cells / total_cells) > 0.5)
@@ -564,47 +663,131 @@ void GridSearchPlanner::assignPathsToVehicles(Mat paths_robot_indx)
 
   auto paths_robot_coords = m_tmstc_star_ptr->pathsIndxToRegionCoords(paths_robot_indx);
 
-  std::set<std::string> drone_names;
-  for (const auto &[drone_name, record] : m_map_drone_records)
+  m_smoothed_paths.clear();
+  m_sortie_plans.clear();
+
+  // Robot r of the plan is the drone m_plan_robot_names[r]: its start position is r's depot, its parameters r's
+  const size_t robot_count = m_plan_robot_names.size();
+  if (robot_count == 0 || robot_count > paths_robot_indx.size())
   {
-    drone_names.insert(drone_name);
+    Logger::error("assignPathsToVehicles: " + std::to_string(robot_count) + " vehicles for " +
+                  std::to_string(paths_robot_indx.size()) + " paths.");
+    return;
   }
-  for (const auto &path : paths_robot_coords)
-  {
-    // Convert the paths to XYSegList format
-    XYSegList seglist = m_tmstc_grid_converter.regionCoords2XYSeglistMoos(path);
 
-    // Prune waypoints in path that are already discovered by looking at m_grid_viz
-    // seglist = pruneDiscoveredWaypoints(seglist);
+  // Mission time of each vehicle on each path: transit to the nearer allowed end, then the path under the
+  // vehicle's own cost model, split into sorties from and back to the vehicle's own start position
+  std::vector<std::vector<SortiePlan>> sortie_plans(robot_count, std::vector<SortiePlan>(paths_robot_indx.size()));
+  std::vector<std::vector<double>> cost(robot_count, std::vector<double>(paths_robot_indx.size()));
+  std::vector<std::vector<bool>> reverse(robot_count, std::vector<bool>(paths_robot_indx.size(), false));
+  for (size_t r = 0; r < robot_count; ++r)
+  {
+    auto record_it = m_map_drone_records.find(m_plan_robot_names[r]);
+    if (record_it == m_map_drone_records.end())
+    {
+      Logger::error("assignPathsToVehicles: No node report of " + m_plan_robot_names[r] + ".");
+      return;
+    }
+    const NodeRecord &record = record_it->second;
 
-    // Find the closest drone
-    XYPoint firstPoint = seglist.get_first_point();
-    std::string drone = "";
-    double min_dist = std::numeric_limits<double>::max();
-    for (const auto drone_name : drone_names)
+    for (size_t i = 0; i < paths_robot_indx.size(); ++i)
     {
-      double dist = hypot(firstPoint.x() - m_map_drone_records[drone_name].getX(), firstPoint.y() - m_map_drone_records[drone_name].getY());
-      if (dist < min_dist)
+      SortiePlan &sorties = sortie_plans[r][i];
+      if (m_tmstc_star_sortie_range > 0)
+        sorties = m_tmstc_star_ptr->planSorties(i, r);
+      if (sorties.sorties.empty())
+        sorties.sorties.push_back({0, (int)paths_robot_indx[i].size()});
+
+      // Path cost on the region grid, plus the legs back to the refuel point and out again between sorties
+      double path_cost = m_tmstc_star_ptr->getPathCost(i, r);
+      for (size_t k = 0; k + 1 < sorties.sorties.size(); ++k)
+        path_cost += m_tmstc_star_ptr->transitCost(sorties.sorties[k].transit_back_m + sorties.sorties[k + 1].transit_out_m, r);
+
+      XYPoint firstPoint = m_tmstc_grid_converter.regionCoord2XYPointMoos(paths_robot_coords[i].front().first, paths_robot_coords[i].front().second);
+      XYPoint lastPoint = m_tmstc_grid_converter.regionCoord2XYPointMoos(paths_robot_coords[i].back().first, paths_robot_coords[i].back().second);
+      double dist_firstPoint = hypot(firstPoint.x() - record.getX(), firstPoint.y() - record.getY());
+      double dist_lastPoint = hypot(lastPoint.x() - record.getX(), lastPoint.y() - record.getY());
+
+      // Sorties are split for the path's direction, so only single-sortie paths are reversed
+      double dist = dist_firstPoint;
+      if (m_start_point_closest && sorties.sorties.size() == 1 && dist_lastPoint < dist_firstPoint)
       {
-        min_dist = dist;
-        drone = drone_name;
+        dist = dist_lastPoint;
+        reverse[r][i] = true;
       }
+      cost[r][i] = m_tmstc_star_ptr->transitCost(dist * MOOSDIST2METERS, r) + path_cost;
     }
+  }
 
-    drone_names.erase(drone); // remove the drone from the set
+  // Minimum makespan, rather than giving each path in turn to the closest remaining vehicle
+  std::vector<int> assignment = minMakespanAssignment(cost);
+  if (assignment.size() != robot_count)
+  {
+    Logger::error("assignPathsToVehicles: No assignment of " + std::to_string(paths_robot_indx.size()) + " paths to " +
+                  std::to_string(robot_count) + " vehicles.");
+    return;
+  }
 
-    if (m_start_point_closest)
+  m_assignment_makespan = 0.0;
+  for (size_t r = 0; r < robot_count; ++r)
+  {
+    int i = assignment[r];
+    const SortiePlan &sorties = sortie_plans[r][i];
+    if (m_tmstc_star_sortie_range > 0)
     {
-      XYPoint firstPoint = seglist.get_first_point();
-      XYPoint lastPoint = seglist.get_last_point();
+      m_sortie_plans.push_back(sorties);
+      if (!sorties.feasible)
+        reportRunWarning("Path " + std::to_string(i) + " has cells out of reach of " + m_plan_robot_names[r] + "'s sortie range");
+    }
 
-      double dist_firstPoint = hypot(firstPoint.x() - m_map_drone_records[drone].getX(), firstPoint.y() - m_map_drone_records[drone].getY());
-      double dist_lastPoint = hypot(lastPoint.x() - m_map_drone_records[drone].getX(), lastPoint.y() - m_map_drone_records[drone].getY());
+    // Convert the path to XYSegList format, as a track the assigned vehicle can fly when smoothing is on
+    XYSegList seglist;
+    SmoothedPath smoothed;
+    for (size_t k = 0; k < sorties.sorties.size(); ++k)
+    {
+      const Sortie &sortie = sorties.sorties[k];
+      XYSegList sortie_seglist;
+      if (m_tmstc_star_dubins_smoothing)
+      {
+        std::vector<int> sortie_path(paths_robot_indx[i].begin() + sortie.begin, paths_robot_indx[i].begin() + sortie.end);
+        SmoothedPath sp = m_tmstc_star_ptr->smoothPath(sortie_path, m_sensor_radius * MOOSDIST2METERS, r);
+        sortie_seglist = m_tmstc_grid_converter.regionPoints2XYSeglistMoos(sp.waypoints);
+        smoothed.waypoints.insert(smoothed.waypoints.end(), sp.waypoints.begin(), sp.waypoints.end());
+        smoothed.length_m += sp.length_m;
+        smoothed.flight_time_s += sp.flight_time_s;
+        smoothed.fillets += sp.fillets;
+        smoothed.turnarounds += sp.turnarounds;
+        smoothed.loops += sp.loops;
+        smoothed.cells += sp.cells;
+        smoothed.covered_cells += sp.covered_cells;
+      }
+      else
+      {
+        std::vector<std::pair<int, int>> sortie_coords(paths_robot_coords[i].begin() + sortie.begin, paths_robot_coords[i].begin() + sortie.end);
+        sortie_seglist = m_tmstc_grid_converter.regionCoords2XYSeglistMoos(sortie_coords);
+      }
+      for (unsigned int v = 0; v < sortie_seglist.size(); ++v)
+        seglist.add_vertex(sortie_seglist.get_vx(v), sortie_seglist.get_vy(v));
 
-      if (dist_lastPoint < dist_firstPoint)
-        seglist.reverse();
+      // Back to the refuel point between sorties, the refuel itself is left to the vehicle's refuel behaviors
+      if (k + 1 < sorties.sorties.size())
+      {
+        auto depot = m_tmstc_star_ptr->indexToRegionCoord(sorties.refuel_idx);
+        XYPoint depot_point = m_tmstc_grid_converter.regionCoord2XYPointMoos(depot.first, depot.second);
+        if (depot_point.valid())
+          seglist.add_vertex(depot_point.get_vx(), depot_point.get_vy());
+      }
     }
-    m_map_drone_paths[drone] = seglist;
+    if (m_tmstc_star_dubins_smoothing)
+      m_smoothed_paths.push_back(smoothed);
+
+    // Prune waypoints in path that are already discovered by looking at m_grid_viz
+    // seglist = pruneDiscoveredWaypoints(seglist);
+
+    if (reverse[r][i])
+      seglist.reverse();
+    m_map_drone_paths[m_plan_robot_names[r]] = seglist;
+    m_assignment_makespan = std::max(m_assignment_makespan, cost[r][i]);
   }
   // Logger::info("doPlanPaths: Paths distributed to vehicles.");
 }
@@ -728,23 +911,17 @@ void GridSearchPlanner::postCalculatedPaths(bool visible)
 void GridSearchPlanner::updateTMSTCVehiclePositions()
 {
   std::vector<XYPoint> vpos;
+  m_tmstc_vehicle_names.clear();
   for (auto [name, record] : m_map_drone_records)
   {
     double posx = record.getX();
     double posy = record.getY();
     vpos.emplace_back(posx, posy);
+    m_tmstc_vehicle_names.push_back(name);
   }
 
   m_tmstc_grid_converter.setVehiclePositions(vpos);
 }
-void GridSearchPlanner::updateTMSTCIgnoredRegions()
-{
-  std::vector<XYPolygon> iregs;
-  for (auto [name, poly] : m_map_ignored_regions_poly)
-    iregs.push_back(poly);
-
-  m_tmstc_grid_converter.setIgnoreRegions(iregs);
-}
 //------------------------------------------------------------
 // Procedure: handleMailNodeReport()
 
@@ -773,18 +950,14 @@ bool GridSearchPlanner::handleMailViewGrid(std::string str)
     return false;
   }
   m_grid_viz = grid;
+  m_coverage_table.setGrid(m_grid_viz);
 
   bool nonemptyGrid = false;
   double lowerlimit = m_grid_viz.getMinLimit(0);
   for (unsigned int ix = 0; ix < m_grid_viz.size(); ix++)
   {
-    XYSquare cell = m_grid_viz.getElement(ix);
-    cellP cell_center(cell.getCenterX(), cell.getCenterY());
-    m_map_grid_cellCenter_idxs[cell_center] = ix;
-
     if(m_grid_viz.getVal(ix, 0) > lowerlimit)
       nonemptyGrid = true;
-    // Logger::info("Grid cell index: " + doubleToStringX(ix, 2) + " at center: (" + doubleToStringX(cell_center.first, 2) + ", " + doubleToStringX(cell_center.second, 2) + ")");
   }
 
   if(!nonemptyGrid){
@@ -799,6 +972,7 @@ bool GridSearchPlanner::handleMailViewGridUpdate(std::string str)
 {
 
   m_grid_viz.processDelta(str);
+  m_coverage_table.invalidate();
   return true;
 }
 
@@ -868,8 +1042,9 @@ void GridSearchPlanner::registerIgnoredRegion(std::string str)
   XYPolygon region = ignoredRegion.getPoly();
 
   m_map_ignored_regions_poly[name] = region;
+  m_ignored_regions_changed = true;
 
-  updateTMSTCIgnoredRegions();
+  m_tmstc_grid_converter.addIgnoreRegion(name, region);
   // Logger::info("Registered ignored region: " + name);
 }
 
@@ -881,8 +1056,9 @@ void GridSearchPlanner::unregisterIgnoredRegion(std::string name)
     return;
 
   m_map_ignored_regions_poly.erase(name);
+  m_ignored_regions_changed = true;
 
-  updateTMSTCIgnoredRegions();
+  m_tmstc_grid_converter.removeIgnoreRegion(name);
   // Logger::info("Unregistered ignored region: " + name);
 }
 
@@ -929,6 +1105,59 @@ bool GridSearchPlanner::buildReport()
     m_msgs << "TMSTC* algorithm" << std::endl;
     m_msgs << "---------------------------------" << std::endl;
     m_msgs << "   TMSTC* point filtering: " << boolToString(m_tmstc_star_point_filtering) << std::endl;
+    {
+      std::lock_guard<std::mutex> lock(m_plan_mutex);
+      m_msgs << "   Planning thread: " << (m_plan_in_flight ? "solving" : "idle")
+             << (m_pending_plan ? ", request waiting" : "") << " (requests: " << m_plan_generation << ")" << std::endl;
+    }
+    m_msgs << "   Incremental replan: " << boolToString(m_tmstc_star_incremental_replan)
+           << " (last replan " << (m_tmstc_star_ptr->wasLastReplanIncremental() ? "incremental" : "full") << ")" << std::endl;
+    m_msgs << "   Dubins smoothing: " << boolToString(m_tmstc_star_dubins_smoothing) << std::endl;
+    if (!m_smoothed_paths.empty())
+    {
+      double max_time = 0;
+      int cells = 0, covered = 0, turnarounds = 0, loops = 0;
+      for (const auto &sp : m_smoothed_paths)
+      {
+        max_time = std::max(max_time, sp.flight_time_s);
+        cells += sp.cells;
+        covered += sp.covered_cells;
+        turnarounds += sp.turnarounds;
+        loops += sp.loops;
+      }
+      m_msgs << "     Est. flight time: " << doubleToStringX(max_time, 1) << " s (longest vehicle), covered cells: "
+             << intToString(covered) << "/" << intToString(cells) << std::endl;
+      m_msgs << "     Turnarounds: " << intToString(turnarounds) << ", loops: " << intToString(loops) << std::endl;
+    }
+    m_msgs << "   Sortie range: " << (m_tmstc_star_sortie_range > 0 ? doubleToStringX(m_tmstc_star_sortie_range, 1) : "off") << std::endl;
+    if (!m_sortie_plans.empty())
+    {
+      double max_time = 0;
+      size_t sortie_count = 0;
+      bool feasible = true;
+      for (const auto &plan : m_sortie_plans)
+      {
+        max_time = std::max(max_time, plan.mission_time_s);
+        sortie_count += plan.sorties.size();
+        feasible = feasible && plan.feasible;
+      }
+      m_msgs << "     Sorties: " << uintToString(sortie_count) << ", est. mission time: " << doubleToStringX(max_time, 1)
+             << " s (longest vehicle)" << (feasible ? "" : ", cells out of range") << std::endl;
+    }
+    m_msgs << "   Path assignment: min makespan, est. " << doubleToStringX(m_assignment_makespan, 1)
+           << (m_tmstc_star_ptr->getConfig().vehicle_params.cost_model == CostModelType::TURN_COUNT ? " cells" : " s")
+           << " (longest vehicle, transit included)" << std::endl;
+    m_msgs << "   Tile size: " << (m_tmstc_star_ptr->getConfig().tile_size > 0 ? intToString(m_tmstc_star_ptr->getConfig().tile_size) : "off") << std::endl;
+    m_msgs << "   Time budget: " << (m_tmstc_star_time_budget > 0 ? doubleToStringX(m_tmstc_star_time_budget, 2) + " s" : "none")
+           << " (last plan " << (m_tmstc_star_ptr->getPlanBalance().deadline_expired ? "cut short" : "converged")
+           << ", imbalance " << doubleToStringX(m_tmstc_star_ptr->getPlanBalance().imbalance * 100, 1) << "%)" << std::endl;
+    const PlanReport &report = m_tmstc_star_ptr->getPlanReport();
+    m_msgs << "   Plan cache: " << (m_tmstc_star_ptr->getConfig().plan_cache_path.empty() ? "off" : m_tmstc_star_ptr->getConfig().plan_cache_path)
+           << (report.cache_hit ? " (last plan loaded from cache)" : "") << std::endl;
+    m_msgs << "   Last plan: " << (report.shape.empty() ? "none" : report.shape)
+           << " in " << doubleToStringX(report.phases.total_s, 3) << " s"
+           << " (tree " << doubleToStringX(report.phases.mst_build_s, 3) << " s, "
+           << intToString(report.counters.balancing_iterations) << " balancing iterations)" << std::endl;
     // m_msgs << "   Allocate method: " << m_tmstc_star_ptr->getConfig().allocate_method << std::endl;
     // m_msgs << "   MST shape: " << m_tmstc_star_ptr->getConfig().mst_shape << std::endl;
     // m_msgs << "   Robot num: " << m_tmstc_star_ptr->getConfig().robot_num << std::endl;
@@ -1108,69 +1337,48 @@ void GridSearchPlanner::convertGridToTMSTC()
 
 void GridSearchPlanner::postTMSTCGrids(bool visible)
 {
-
-  static bool prev_active = false;
-
-  if (!visible && !prev_active) // if not active and not previously active
-    return;
-
   if (!m_tmstc_grid_converter.isGridsConverted())
     return;
 
-  std::vector<XYPoint> regionGridPoints = m_tmstc_grid_converter.getRegionGridCenters();
-  std::vector<XYPoint> downsampledGridPoints = m_tmstc_grid_converter.getSpanningGridCenters();
-
-  double transparancy = 0.1;
+  // Post only when the grids or their visibility changed, hidden grids are posted once they are shown
+  unsigned int version = m_tmstc_grid_converter.getGridsVersion();
+  bool changed = (version != m_posted_grids_version);
+  if (visible == m_posted_grids_visible && (!visible || !changed))
+    return;
 
-  int idx = 0;
-  for (auto point : regionGridPoints)
+  // One seglist per grid and cell state, drawn as vertices only, instead of a circle per cell
+  auto postCells = [&](const std::vector<XYPoint> &centers, const std::string &label,
+                       const std::string &color, bool free)
   {
-    XYCircle circle(point.x(), point.y(), m_coveragecellradius);
-
-    circle.set_label("Sr_" + std::to_string(idx++));
-    circle.set_label_color("off");
-    circle.set_edge_color("yellow");
-    circle.set_color("fill", "off");
-    circle.set_transparency(transparancy);
-    circle.set_edge_size(2);
-    circle.set_vertex_size(2);
-    circle.set_active(visible);
-
-    if (point.z() == 0)
+    XYSegList cells;
+    for (const auto &point : centers)
     {
-      circle.set_color("fill", "yellow");
-      circle.set_transparency(0.4);
+      if ((point.z() != 0) == free)
+        cells.add_vertex(point.x(), point.y());
     }
-    // Logger::info("Region point: " + doubleToStringX(point.x(), 2) + ", " + doubleToStringX(point.y(), 2) + ", " + doubleToStringX(point.z(), 2));
-    Notify("VIEW_CIRCLE", circle.get_spec());
-  }
+    cells.set_label(label);
+    cells.set_label_color("off");
+    cells.set_color("edge", "off");
+    cells.set_edge_size(0);
+    cells.set_color("vertex", color);
+    cells.set_vertex_size(free ? 2 : 6);
+    cells.set_active(visible && cells.size() > 0);
+    Notify("VIEW_SEGLIST", cells.get_spec());
+  };
 
-  idx = 0;
-  for (auto point : downsampledGridPoints)
-  {
-    XYCircle circle(point.x(), point.y(), m_coveragecellradius);
-
-    circle.set_label("Sdr_" + std::to_string(idx++));
-    circle.set_label_color("off");
-    circle.set_edge_color("red");
-    circle.set_color("fill", "off");
-    circle.set_transparency(transparancy);
-    circle.set_edge_size(2);
-    circle.set_vertex_size(2);
-    circle.set_active(visible);
-
-    if (point.z() == 0)
-    {
-      circle.set_color("fill", "red");
-      circle.set_transparency(0.6);
-    }
+  std::vector<XYPoint> regionGridPoints = m_tmstc_grid_converter.getRegionGridCenters();
+  std::vector<XYPoint> downsampledGridPoints = m_tmstc_grid_converter.getSpanningGridCenters();
+  postCells(regionGridPoints, "Sr_free", "yellow", true);
+  postCells(regionGridPoints, "Sr_occupied", "yellow", false);
+  postCells(downsampledGridPoints, "Sdr_free", "red", true);
+  postCells(downsampledGridPoints, "Sdr_occupied", "red", false);
 
-    Notify("VIEW_CIRCLE", circle.get_spec());
+  m_posted_grids_visible = visible;
+  if (visible && changed)
+  {
+    m_posted_grids_version = version;
+    m_tmstc_grid_converter.saveSpanningGridToFile("downsampled_grid.txt");
   }
-
-  prev_active = visible;
-
-  m_tmstc_grid_converter.saveSpanningGridToFile("downsampled_grid.txt");
 }
 
 //------------------------------------------------------------
@@ -1220,38 +1428,38 @@ XYSegList GridSearchPlanner::pruneDiscoveredWaypoints(const XYSegList &original_
 
   XYSegList pruned_path = original_path;
 
-  // Get grid properties
-  XYPolygon searchRegion = m_tmstc_grid_converter.getSearchRegion();
-  XYSquare bbox = m_grid_viz.getSBound();
-  double bbox_min_x = bbox.get_min_x();
-  double bbox_min_y = bbox.get_min_y();
-  double grid_cell_size = m_grid_viz.getCellSize();
+  // Discovered cells around every waypoint in one pass over the summed-area table
+  m_coverage_table.refresh(m_grid_viz);
+  std::vector<double> xs(pruned_path.size()), ys(pruned_path.size());
+  for (unsigned int i = 0; i < pruned_path.size(); i++)
+  {
+    xs[i] = pruned_path.get_vx(i);
+    ys[i] = pruned_path.get_vy(i);
+  }
+  std::vector<int> total_cells, discovered_cells;
+  m_coverage_table.countSquares(xs, ys, m_coveragecellradius, total_cells, discovered_cells);
 
   // Process from the end of the path towards the beginning
   // This allows us to safely remove points without affecting our iteration
   for (int i = pruned_path.size() - 1; i >= 0; i--)
   {
-    double x = pruned_path.get_vx(i);
-    double y = pruned_path.get_vy(i);
+    double x = xs[i];
+    double y = ys[i];
 
     // Check if waypoint is in an ignored region or outside the search region
+    // (by the region grid cell it falls in, from the converter's rasterized mask)
     bool is_wpt_ignored = false;
-    if (!searchRegion.contains(x, y))
+    if (!m_tmstc_grid_converter.isInSearchRegion(x, y))
     {
       is_wpt_ignored = true;
       Logger::info("Pruning waypoint at: (" + doubleToStringX(x, 2) +
                    ", " + doubleToStringX(y, 2) + ") - Outside search region");
     }
-
-    for (const auto &[_, region] : m_map_ignored_regions_poly)
+    else if (m_tmstc_grid_converter.isInIgnoredRegion(x, y))
     {
-      if (region.contains(x, y))
-      {
-        is_wpt_ignored = true;
-        Logger::info("Pruning waypoint at: (" + doubleToStringX(x, 2) +
-                     ", " + doubleToStringX(y, 2) + ") - In ignored region");
-        break;
-      }
+      is_wpt_ignored = true;
+      Logger::info("Pruning waypoint at: (" + doubleToStringX(x, 2) +
+                   ", " + doubleToStringX(y, 2) + ") - In ignored region");
     }
 
     if (is_wpt_ignored)
@@ -1260,70 +1468,14 @@ XYSegList GridSearchPlanner::pruneDiscoveredWaypoints(const XYSegList &original_
       continue;
     }
 
-    // Define the square area around the waypoint (sensor coverage)
-    double x_min = x - m_coveragecellradius;
-    double x_max = x + m_coveragecellradius;
-    double y_min = y - m_coveragecellradius;
-    double y_max = y + m_coveragecellradius;
-
-    // Convert world coordinates to grid cell indices
-    int col_start = static_cast<int>(std::floor((x_min - bbox_min_x) / grid_cell_size));
-    int col_end = static_cast<int>(std::floor((x_max - bbox_min_x) / grid_cell_size));
-    int row_start = static_cast<int>(std::floor((y_min - bbox_min_y) / grid_cell_size));
-    int row_end = static_cast<int>(std::floor((y_max - bbox_min_y) / grid_cell_size));
-
-    // Clamp to valid grid indices
-    col_start = std::max(0, col_start);
-    row_start = std::max(0, row_start);
-    col_end = std::min(col_end, static_cast<int>(bbox.getLengthX() / grid_cell_size) - 1);
-    row_end = std::min(row_end, static_cast<int>(bbox.getLengthY() / grid_cell_size) - 1);
-
-    // Check if area is completely outside the grid
-    if (col_start > col_end || row_start > row_end)
-    {
-      continue;
-    }
-
-    // Count discovered cells in this area
-    int total_cells = 0;
-    int discovered_cells = 0;
-
-    for (int row = row_start; row <= row_end; row++)
-    {
-      for (int col = col_start; col <= col_end; col++)
-      {
-        // Calculate the center of this cell in world coordinates
-        double cell_center_x = bbox_min_x + (col + 0.5) * grid_cell_size;
-        double cell_center_y = bbox_min_y + (row + 0.5) * grid_cell_size;
-
-        // Only count cells whose centers are in the waypoint's coverage area
-        if (cell_center_x >= x_min && cell_center_x <= x_max &&
-            cell_center_y >= y_min && cell_center_y <= y_max)
-        {
-
-          total_cells++;
-
-          // Find this cell in the grid
-          cellP cell_center(cell_center_x, cell_center_y);
-          if (m_map_grid_cellCenter_idxs.count(cell_center) == 0)
-            continue;
-
-          unsigned int ix = m_map_grid_cellCenter_idxs[cell_center];
-          double cell_val = m_grid_viz.getVal(ix, 0);
-          if (cell_val > 0)
-            discovered_cells++;
-        }
-      }
-    }
-
     // If more than 50% of cells in this area are already discovered, remove the waypoint
-    if (total_cells > 0 && ((double)discovered_cells / total_cells) > 0.5)
+    if (total_cells[i] > 0 && ((double)discovered_cells[i] / total_cells[i]) > 0.5)
     {
       pruned_path.delete_vertex(i);
       Logger::info("Pruning waypoint at: (" + doubleToStringX(x, 2) +
                    ", " + doubleToStringX(y, 2) + ") - " +
-                   uintToString(discovered_cells) + "/" + uintToString(total_cells) +
-                   " (" + doubleToStringX(discovered_cells / double(total_cells), 2) +
+                   uintToString(discovered_cells[i]) + "/" + uintToString(total_cells[i]) +
+                   " (" + doubleToStringX(discovered_cells[i] / double(total_cells[i]), 2) +
                    ") cells already discovered");
     }
   }
@@ -16,17 +16,22 @@
 
 #include "IgnoredRegion.h"
 #include "TMSTCGridConverter.h"
+#include "CoverageTable.h"
 #include "TMSTCStar.h"
 
 #include "common.h"
 
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 class GridSearchPlanner : public AppCastingMOOSApp
 {
 public:
   GridSearchPlanner();
-  virtual ~GridSearchPlanner() {}
+  virtual ~GridSearchPlanner();
 
   bool OnNewMail(MOOSMSG_LIST &NewMail);
   bool Iterate();
@@ -47,6 +52,7 @@ protected:
 
   bool raisePlannerFlag();
   bool doPlanPaths();
+  bool publishFinishedPlan();
   void assignPathsToVehicles(Mat paths);
   XYSegList pruneDiscoveredWaypoints(const XYSegList &original_path);
   std::vector<XYPoint> getCellsInSquare(double center_x, double center_y,
@@ -61,11 +67,12 @@ protected:
   void postTMSTCGrids(bool visible = true);
 
   void updateTMSTCVehiclePositions();
-  void updateTMSTCIgnoredRegions();
 
   void clearAllGenerateWarnings();
 
   bool is_pathIdx_filtered(int idx);
+  bool is_regionCoord_filtered(int col, int row);
+  BitGrid buildPointFilterMask(const Mat &spanningMap);
 
 protected: // Config vars
   // Sensor data
@@ -81,6 +88,10 @@ protected: // Config vars
 
   bool m_start_point_closest;
   bool m_tmstc_star_point_filtering;
+  bool m_tmstc_star_incremental_replan;
+  bool m_tmstc_star_dubins_smoothing;
+  double m_tmstc_star_sortie_range; // Range on full fuel (MOOS distance, as pRefuelReplace's total_range), <= 0 is off
+  double m_tmstc_star_time_budget; // Seconds per plan, <= 0 runs every solver stage to completion
 
   std::string m_path_publish_variable;
 
@@ -91,21 +102,63 @@ protected: // Config vars
 
 protected: // State vars
   XYConvexGrid m_grid_viz;
-  using cellP = std::pair<double, double>;
-  std::map<cellP, unsigned int> m_map_grid_cellCenter_idxs;
+  CoverageTable m_coverage_table; // Discovered cells of m_grid_viz, for the point filter and waypoint pruning
 
   bool m_do_plan_paths;
   bool m_do_start_voronoi_searching;
   bool m_is_paths_calculated;
+  bool m_ignored_regions_changed; // Since the last plan, lets doPlanPaths() repair instead of resolve
+  unsigned int m_posted_grids_version; // Converter grids version last posted by postTMSTCGrids()
+  bool m_posted_grids_visible;
 
   // key is name of drone
   std::map<std::string, NodeRecord> m_map_drone_records;
   std::map<std::string, XYSegList> m_map_drone_paths;
+  std::vector<std::string> m_tmstc_vehicle_names; // Drone of each vehicle position given to the grid converter, in order
+  std::vector<std::string> m_plan_robot_names;    // Drone of each robot index (start position) of the last plan
+  std::vector<SmoothedPath> m_smoothed_paths; // Of the last plan, when Dubins smoothing is on
+  std::vector<SortiePlan> m_sortie_plans;     // Of the last plan, when a sortie range is set
+  double m_assignment_makespan;               // Of the last plan, longest transit plus path cost of the assignment
   // key is name of ignored region
   std::map<std::string, XYPolygon> m_map_ignored_regions_poly;
 
   TMSTCGridConverter m_tmstc_grid_converter;
-  std::unique_ptr<TMSTCStar> m_tmstc_star_ptr;
+  std::unique_ptr<TMSTCStar> m_tmstc_star_ptr; // Holds the configuration and the last published plan
+
+  // Background planning: doPlanPaths() snapshots the grid, depots and ignored regions into a request,
+  // the worker thread solves it on its own TMSTCStar, and Iterate() publishes the result.
+  // A newer request replaces a waiting one and cancels the one being solved.
+  struct PlanRequest
+  {
+    unsigned long generation = 0;
+    Mat spanning_map;
+    std::vector<int> robot_region_indices;
+    std::vector<std::string> robot_names; // Drone of each robot region index
+    TMSTCStarConfig config;
+    bool incremental = false; // Ignored regions changed, the worker's last plan may be repaired
+    double time_budget = 0;   // Seconds from the start of the solve, <= 0 is none
+  };
+  struct PlanResult
+  {
+    unsigned long generation = 0;
+    bool incremental = false;
+    std::vector<std::string> robot_names; // Of the request, the drone of each robot index of the plan
+    std::string error;                 // Empty on success
+    std::unique_ptr<TMSTCStar> solver; // Copy of the worker's solver holding the plan
+  };
+  void submitPlanRequest(std::unique_ptr<PlanRequest> request);
+  void planWorkerLoop();
+
+  std::thread m_plan_worker;
+  std::mutex m_plan_mutex; // Guards the members below, up to m_plan_cancel
+  std::condition_variable m_plan_cv;
+  std::unique_ptr<PlanRequest> m_pending_plan;
+  std::unique_ptr<PlanResult> m_finished_plan;
+  unsigned long m_plan_generation; // Of the latest request
+  bool m_plan_in_flight;
+  bool m_plan_worker_stop;
+  std::atomic<bool> m_plan_cancel;          // TMSTCStarConfig::cancel_flag of every request
+  std::unique_ptr<TMSTCStar> m_plan_solver; // Worker thread only
 
   std::vector<std::string> m_generate_warnings;
 };
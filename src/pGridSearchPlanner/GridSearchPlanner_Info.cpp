@@ -24,6 +24,10 @@ void showSynopsis()
   blk("  history of vehicle positions in a 2D grid defined over a      ");
   blk("  region of operation and generating a search patter according  ");
   blk("  to the TMSTC* algorithm.                                      ");
+  blk("  Plans are solved in a background thread on a snapshot of the  ");
+  blk("  grid, vehicles and ignored regions, so the app keeps its      ");
+  blk("  AppTick while planning. A newer DO_PLAN_PATHS (or ignored     ");
+  blk("  region change) cancels the plan being solved.                 ");
 }
 
 //----------------------------------------------------------------
@@ -168,9 +172,11 @@ void showInterfaceAndExit()
   blk("                color=green,edge_color=orange,width=10        ");
   blk("    // Visual marker for path start and end points.            ");
   blk("                                                                ");
-  blk("  VIEW_CIRCLE = x=X,y=Y,radius=R,label=Sr_0,edge_color=yellow, ");
-  blk("                fill=off,active=true                          ");
-  blk("    // Visual circles for TMSTC* grid cells (region/spanning). ");
+  blk("  VIEW_SEGLIST = label=Sr_free,pts={x1,y1:x2,y2},edge_color=off,");
+  blk("                 vertex_color=yellow,vertex_size=2,active=true");
+  blk("    // TMSTC* grid cells, one seglist per grid (Sr region, Sdr ");
+  blk("    // spanning) and state (_free, _occupied). Posted only when ");
+  blk("    // the grids or visualize_planner_grids change.            ");
   blk("                                                                ");
   blk("  XGSP_GRID_EMPTY = true                                        ");
   blk("    // Published if the VIEW_GRID received is considered empty.");
@@ -221,18 +227,63 @@ void showExampleConfigAndExit()
   blk("  tmstc_star_config_phi_max_rad = 0.785 // Default: 0.785 (45deg)");
   blk("    // Maximum vehicle bank angle (radians) for TMSTC*.        ");
   blk("                                                                ");
+  blk("  tmstc_star_config_cost_model = fixed_wing // Default: fixed_wing");
+  blk("    // Path cost used by TMSTC*. Options: fixed_wing (banked   ");
+  blk("    // turns), multirotor (stop and turn), turn_count.         ");
+  blk("                                                                ");
   blk("  tmstc_star_point_filtering = false // Default: false          ");
   blk("    // If true, TMSTC* filters out grid cells already visited  ");
   blk("    // (based on VIEW_GRID).                                   ");
   blk("                                                                ");
+  blk("  tmstc_star_incremental_replan = true // Default: true         ");
+  blk("    // If true, a replan after an ignored region change repairs ");
+  blk("    // the previous spanning tree and cuts around the changed  ");
+  blk("    // cells instead of solving from scratch.                  ");
+  blk("                                                                ");
+  blk("  tmstc_star_dubins_smoothing = false // Default: false        ");
+  blk("    // If true, TMSTC* paths are sent as tracks a fixed-wing     ");
+  blk("    // vehicle can fly at its turn radius (vmax, phi_max_rad):   ");
+  blk("    // corners become arcs and turns between adjacent lanes are ");
+  blk("    // merged into one turnaround.                              ");
+  blk("                                                                ");
+  blk("  tmstc_star_sortie_range = 0    // Default: 0 (off)           ");
+  blk("    // Distance a vehicle flies on full fuel, as total_range   ");
+  blk("    // in pRefuelReplace. Longer paths are split into sorties  ");
+  blk("    // that return to the vehicle's start point in between.    ");
+  blk("                                                                ");
+  blk("  tmstc_star_refuel_time = 0     // Default: 0                 ");
+  blk("    // Seconds on the ground per refuel, used to place the     ");
+  blk("    // sortie splits.                                          ");
+  blk("                                                                ");
+  blk("  tmstc_star_tile_size = 0       // Default: 0 (off)           ");
+  blk("    // If > 0, the TMSTC* spanning tree is built in parallel   ");
+  blk("    // tiles of this many grid cells per side and stitched.    ");
+  blk("    // Speeds up planning on very large search regions.        ");
+  blk("                                                                ");
+  blk("  tmstc_star_time_budget = 0     // Default: 0 (no limit)      ");
+  blk("    // Seconds a TMSTC* plan may take. When it runs out, the   ");
+  blk("    // best plan found so far is used and its imbalance is     ");
+  blk("    // shown in the appcast.                                   ");
+  blk("                                                                ");
+  blk("  tmstc_star_plan_cache = /tmp/tmstc_plans.bin // Default: off ");
+  blk("    // File that keeps finished TMSTC* plans. A replan of the  ");
+  blk("    // same grid, start points and settings is loaded from it, ");
+  blk("    // also after a restart.                                   ");
+  blk("                                                                ");
+  blk("  tmstc_star_verbosity = summary // Default: summary           ");
+  blk("    // TMSTC* console and log output: quiet (warnings only),   ");
+  blk("    // summary (one line per stage) or detail (per iteration). ");
+  blk("                                                                ");
   blk("  // Behavior & Visualization:                                  ");
   blk("  start_point_closest = false    // Default: false              ");
-  blk("    // If true, TMSTC* paths start from the grid point closest ");
-  blk("    // to the vehicle's current position. Otherwise, vehicle   ");
-  blk("    // closest to path start point gets the path.              ");
+  blk("    // If true, TMSTC* paths may also be flown from their end, ");
+  blk("    // whichever is closer. Paths go to vehicles by the        ");
+  blk("    // assignment with the shortest mission (transit to the    ");
+  blk("    // path plus path time, longest vehicle), see appcast.     ");
   blk("                                                                ");
   blk("  visualize_planner_grids = false // Default: false             ");
   blk("    // If true, posts TMSTC* internal grids for visualization. ");
+  blk("    // downsampled_grid.txt is rewritten when they change.     ");
   blk("                                                                ");
   blk("  visualize_planner_paths = false // Default: false             ");
   blk("    // If true, posts calculated paths for visualization.      ");
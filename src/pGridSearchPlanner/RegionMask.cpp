@@ -0,0 +1,102 @@
+#include "RegionMask.h"
+
+#include <cmath>
+#include <algorithm>
+
+RegionMask::RegionMask()
+    : m_minX(0.0), m_minY(0.0), m_cellSize(0.0), m_cols(0), m_rows(0)
+{
+}
+
+void RegionMask::reset(double minX, double minY, double cellSize, int cols, int rows)
+{
+    m_minX = minX;
+    m_minY = minY;
+    m_cellSize = cellSize;
+    m_cols = std::max(0, cols);
+    m_rows = std::max(0, rows);
+    m_inSearch.assign(m_cols * m_rows, 0);
+    m_ignoredCount.assign(m_cols * m_rows, 0);
+}
+
+template <typename Fill>
+RegionMask::CellRange RegionMask::scanline(const XYPolygon &poly, Fill fill) const
+{
+    CellRange range;
+    unsigned int n = poly.size();
+    if (n < 3 || m_cols == 0 || m_rows == 0 || m_cellSize <= 0)
+        return range;
+
+    // Cell c has its center at m_minX + (c + 0.5) * m_cellSize
+    auto firstCenterAtOrAbove = [this](double v, double min)
+    { return static_cast<int>(std::ceil((v - min) / m_cellSize - 0.5)); };
+    auto lastCenterAtOrBelow = [this](double v, double min)
+    { return static_cast<int>(std::floor((v - min) / m_cellSize - 0.5)); };
+
+    range.col0 = std::max(0, firstCenterAtOrAbove(poly.get_min_x(), m_minX));
+    range.col1 = std::min(m_cols - 1, lastCenterAtOrBelow(poly.get_max_x(), m_minX));
+    range.row0 = std::max(0, firstCenterAtOrAbove(poly.get_min_y(), m_minY));
+    range.row1 = std::min(m_rows - 1, lastCenterAtOrBelow(poly.get_max_y(), m_minY));
+    if (range.empty())
+        return range;
+
+    std::vector<double> crossings;
+    for (int row = range.row0; row <= range.row1; ++row)
+    {
+        double y = m_minY + (row + 0.5) * m_cellSize;
+
+        // Even-odd rule, each edge counts for the half-open span [min y, max y)
+        crossings.clear();
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            double x0 = poly.get_vx(i), y0 = poly.get_vy(i);
+            double x1 = poly.get_vx((i + 1) % n), y1 = poly.get_vy((i + 1) % n);
+            if ((y0 <= y) != (y1 <= y))
+                crossings.push_back(x0 + (y - y0) * (x1 - x0) / (y1 - y0));
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2)
+        {
+            int col0 = std::max(range.col0, firstCenterAtOrAbove(crossings[k], m_minX));
+            int col1 = std::min(range.col1, lastCenterAtOrBelow(crossings[k + 1], m_minX));
+            if (col0 <= col1)
+                fill(row, col0, col1);
+        }
+    }
+    return range;
+}
+
+void RegionMask::setSearchRegion(const XYPolygon &region)
+{
+    std::fill(m_inSearch.begin(), m_inSearch.end(), 0);
+    scanline(region, [this](int row, int col0, int col1)
+             { std::fill(m_inSearch.begin() + row * m_cols + col0, m_inSearch.begin() + row * m_cols + col1 + 1, 1); });
+}
+
+RegionMask::CellRange RegionMask::addIgnoredRegion(const XYPolygon &region)
+{
+    return scanline(region, [this](int row, int col0, int col1)
+                    {
+        for (int col = col0; col <= col1; ++col)
+            m_ignoredCount[row * m_cols + col]++; });
+}
+
+RegionMask::CellRange RegionMask::removeIgnoredRegion(const XYPolygon &region)
+{
+    // The same polygon rasterizes to the same cells it was added with
+    return scanline(region, [this](int row, int col0, int col1)
+                    {
+        for (int col = col0; col <= col1; ++col)
+            if (m_ignoredCount[row * m_cols + col] > 0)
+                m_ignoredCount[row * m_cols + col]--; });
+}
+
+bool RegionMask::cellOf(double x, double y, int &col, int &row) const
+{
+    if (m_cellSize <= 0)
+        return false;
+    col = static_cast<int>(std::floor((x - m_minX) / m_cellSize));
+    row = static_cast<int>(std::floor((y - m_minY) / m_cellSize));
+    return inGrid(col, row);
+}
@@ -0,0 +1,49 @@
+#ifndef REGION_MASK_H
+#define REGION_MASK_H
+
+#include <vector>
+#include "XYPolygon.h"
+
+// Per-cell mask of a square grid: which cell centers lie inside the search region, and in how many ignored
+// regions. Polygons are burnt in with a scanline fill, so a region costs the cells of its bounding box
+// instead of a polygon test per cell, and unregistering a region only touches that box again.
+class RegionMask
+{
+public:
+    // Box of grid cells, bounds inclusive, empty when col0 > col1 or row0 > row1
+    struct CellRange
+    {
+        int col0 = 0, col1 = -1, row0 = 0, row1 = -1;
+        bool empty() const { return col0 > col1 || row0 > row1; }
+    };
+
+    RegionMask();
+
+    // Clear the mask for a grid of cols x rows cells of cellSize, cell (0, 0) has its corner at (minX, minY)
+    void reset(double minX, double minY, double cellSize, int cols, int rows);
+
+    void setSearchRegion(const XYPolygon &region);
+    CellRange addIgnoredRegion(const XYPolygon &region);
+    CellRange removeIgnoredRegion(const XYPolygon &region);
+
+    bool inSearchRegion(int col, int row) const { return inGrid(col, row) && m_inSearch[row * m_cols + col]; }
+    bool isIgnored(int col, int row) const { return inGrid(col, row) && m_ignoredCount[row * m_cols + col] > 0; }
+    bool isFree(int col, int row) const { return inSearchRegion(col, row) && !isIgnored(col, row); }
+
+    // Cell containing the point, false outside the grid
+    bool cellOf(double x, double y, int &col, int &row) const;
+
+    bool inGrid(int col, int row) const { return col >= 0 && col < m_cols && row >= 0 && row < m_rows; }
+
+private:
+    // Calls fill(row, col0, col1) for the runs of cells whose centers lie inside the polygon
+    template <typename Fill>
+    CellRange scanline(const XYPolygon &poly, Fill fill) const;
+
+    double m_minX, m_minY, m_cellSize;
+    int m_cols, m_rows;
+    std::vector<unsigned char> m_inSearch;
+    std::vector<unsigned short> m_ignoredCount; // Overlapping ignored regions each count once
+};
+
+#endif
@@ -2,13 +2,14 @@
 #include <iostream>
 #include <fstream>
 #include <cmath>
+#include <algorithm>
 
 #include "Logger.h"
 #include "TMSTCStar.h"
 
 TMSTCGridConverter::TMSTCGridConverter()
     : m_sensorRadius(0.0), m_regionWidth(0), m_regionHeight(0),
-      m_spanningWidth(0), m_spanningHeight(0), m_gridsConverted(false)
+      m_spanningWidth(0), m_spanningHeight(0), m_gridsConverted(false), m_gridsVersion(0)
 {
 }
 
@@ -16,9 +17,9 @@ TMSTCGridConverter::TMSTCGridConverter(const XYPolygon &searchRegion, double sen
                                        const std::vector<XYPolygon> &ignoredRegions,
                                        const std::vector<XYPoint> &vehiclePositions)
     : m_searchRegion(searchRegion), m_sensorRadius(sensorRadius),
-      m_ignoredRegions(ignoredRegions), m_vehiclePositions(vehiclePositions),
-      m_gridsConverted(false)
+      m_vehiclePositions(vehiclePositions), m_gridsConverted(false), m_gridsVersion(0)
 {
+    setIgnoreRegions(ignoredRegions);
     convert2MatGrids();
     m_gridsConverted = true;
 }
@@ -37,10 +38,43 @@ void TMSTCGridConverter::setSensorRadius(double sensorRadius)
 
 void TMSTCGridConverter::setIgnoreRegions(const std::vector<XYPolygon> &ignoredRegions)
 {
-    m_ignoredRegions = ignoredRegions;
+    m_ignoredRegions.clear();
+    for (size_t i = 0; i < ignoredRegions.size(); ++i)
+        m_ignoredRegions[std::to_string(i)] = ignoredRegions[i];
     m_gridsConverted = false;
 }
 
+void TMSTCGridConverter::addIgnoreRegion(const std::string &name, const XYPolygon &region)
+{
+    removeIgnoreRegion(name);
+    m_ignoredRegions[name] = region;
+    if (m_gridsConverted)
+        refreshCells(m_regionMask.addIgnoredRegion(region));
+}
+
+void TMSTCGridConverter::removeIgnoreRegion(const std::string &name)
+{
+    auto it = m_ignoredRegions.find(name);
+    if (it == m_ignoredRegions.end())
+        return;
+    XYPolygon region = it->second;
+    m_ignoredRegions.erase(it);
+    if (m_gridsConverted)
+        refreshCells(m_regionMask.removeIgnoredRegion(region));
+}
+
+bool TMSTCGridConverter::isInSearchRegion(double x, double y) const
+{
+    int col, row;
+    return m_regionMask.cellOf(x, y, col, row) && m_regionMask.inSearchRegion(col, row);
+}
+
+bool TMSTCGridConverter::isInIgnoredRegion(double x, double y) const
+{
+    int col, row;
+    return m_regionMask.cellOf(x, y, col, row) && m_regionMask.isIgnored(col, row);
+}
+
 void TMSTCGridConverter::setVehiclePositions(const std::vector<XYPoint> &vehiclePositions)
 {
     m_vehiclePositions = vehiclePositions;
@@ -382,7 +416,12 @@ void TMSTCGridConverter::convert2MatGrids()
     if (m_regionHeight % 2 != 0)
         m_regionHeight++;
 
-    // Step 3: Initialize region grid and centers
+    // Step 3: Burn the search and ignored regions into the mask, initialize region grid and centers
+    m_regionMask.reset(m_boundingBox.get_min_x(), m_boundingBox.get_min_y(), 2 * m_sensorRadius, m_regionWidth, m_regionHeight);
+    m_regionMask.setSearchRegion(m_searchRegion);
+    for (const auto &[name, ignored] : m_ignoredRegions)
+        m_regionMask.addIgnoredRegion(ignored);
+
     m_regionGrid = Mat(m_regionHeight, std::vector<int>(m_regionWidth, 0));
     m_regionGridCenters.clear();
     populateRegionGrid();
@@ -395,6 +434,7 @@ void TMSTCGridConverter::convert2MatGrids()
     createSpanningGrid();
 
     m_gridsConverted = true;
+    m_gridsVersion++;
 }
 
 XYSquare TMSTCGridConverter::getBoundingBox() const
@@ -447,6 +487,17 @@ XYSegList TMSTCGridConverter::regionCoords2XYSeglistMoos(std::vector<std::pair<i
     }
     return segList;
 }
+XYSegList TMSTCGridConverter::regionPoints2XYSeglistMoos(const std::vector<std::pair<double, double>> &regionPoints) const
+{
+    XYSegList segList;
+    for (const auto &point : regionPoints)
+    {
+        double x = m_boundingBox.get_min_x() + (point.first + 0.5) * 2 * m_sensorRadius;
+        double y = m_boundingBox.get_min_y() + (point.second + 0.5) * 2 * m_sensorRadius;
+        segList.add_vertex(x, y);
+    }
+    return segList;
+}
 XYSegList TMSTCGridConverter::spanningCoords2XYSeglisMoos(std::vector<std::pair<int, int>> spanningCoords) const
 {
     XYSegList segList;
@@ -471,35 +522,42 @@ void TMSTCGridConverter::populateRegionGrid()
             if (!point.valid())
                 continue;
 
-            // Calculate center of the cell using 2 * sensorRadius
-            double x = point.get_vx();
-            double y = point.get_vy();
-            // 1 - free , 0 - occupied cell
-            double z = 0;
+            // 1 - free (inside the search region and no ignored region), 0 - occupied cell
+            int free = m_regionMask.isFree(col, row) ? 1 : 0;
+            m_regionGrid[row][col] = free;
+            m_regionGridCenters.emplace_back(point.get_vx(), point.get_vy(), free);
+        }
+    }
+}
 
-            // Check if the cell center is inside the search region
-            if (m_searchRegion.contains(x, y))
-            {
-                // Check if the cell center is inside any ignored region
-                bool isIgnored = false;
-                for (const auto &ignored : m_ignoredRegions)
-                {
-                    if (ignored.contains(x, y))
-                    {
-                        isIgnored = true;
-                        break;
-                    }
-                }
-                // Set as free (1) if not ignored, otherwise occupied (0)
-                m_regionGrid[row][col] = isIgnored ? 0 : 1;
-                z = isIgnored ? 0 : 1;
-            }
+void TMSTCGridConverter::refreshCells(const RegionMask::CellRange &range)
+{
+    if (range.empty())
+        return;
 
-            m_regionGridCenters.emplace_back(x, y, z);
+    for (int row = range.row0; row <= range.row1; ++row)
+    {
+        for (int col = range.col0; col <= range.col1; ++col)
+        {
+            int free = m_regionMask.isFree(col, row) ? 1 : 0;
+            m_regionGrid[row][col] = free;
+            m_regionGridCenters[row * m_regionWidth + col].set_vz(free);
+        }
+    }
 
-            // Cells outside the search region are already initialized as occupied (0)
+    // Spanning cells over the changed region cells, with the same rule as createSpanningGrid()
+    for (int row = range.row0 / 2; row <= std::min(range.row1 / 2, m_spanningHeight - 1); ++row)
+    {
+        for (int col = range.col0 / 2; col <= std::min(range.col1 / 2, m_spanningWidth - 1); ++col)
+        {
+            int freeCount = m_regionGrid[row * 2][col * 2] + m_regionGrid[row * 2][col * 2 + 1] +
+                            m_regionGrid[row * 2 + 1][col * 2] + m_regionGrid[row * 2 + 1][col * 2 + 1];
+            int free = (freeCount >= 2) ? 1 : 0;
+            m_spanningGrid[row][col] = free;
+            m_spanningGridCenters[row * m_spanningWidth + col].set_vz(free);
         }
     }
+    m_gridsVersion++;
 }
 
 void TMSTCGridConverter::createSpanningGrid()
@@ -3,11 +3,13 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <cmath>
 #include "XYPolygon.h"
 #include "XYSquare.h"
 #include "XYSegList.h"
 #include "XYPoint.h"
+#include "RegionMask.h"
 
 typedef std::vector<std::vector<int>> Mat;
 
@@ -26,6 +28,9 @@ public:
     void setSearchRegion(const XYPolygon &searchRegion);
     void setSensorRadius(double sensorRadius);
     void setIgnoreRegions(const std::vector<XYPolygon> &ignoredRegions);
+    // Once the grids are converted, these only update the cells in the region's bounding box
+    void addIgnoreRegion(const std::string &name, const XYPolygon &region);
+    void removeIgnoreRegion(const std::string &name);
     void setVehiclePositions(const std::vector<XYPoint> &vehiclePositions);
     void transformGrid();
 
@@ -47,19 +52,28 @@ public:
     bool saveRegionGridToFile(const std::string &filename) const;
     bool saveSpanningGridToFile(const std::string &filename) const;
     bool isGridsConverted() const;
+    unsigned int getGridsVersion() const { return m_gridsVersion; } // Changes whenever the grids do
 
     XYSegList regionCoords2XYSeglistMoos(std::vector<std::pair<int, int>> regionCoords) const;
     XYSegList spanningCoords2XYSeglisMoos(std::vector<std::pair<int, int>> spanningCoords) const;
+    // Fractional region coordinates (e.g. a smoothed track), points outside the grid are kept
+    XYSegList regionPoints2XYSeglistMoos(const std::vector<std::pair<double, double>> &regionPoints) const;
 
     XYPoint regionCoord2XYPointMoos(int col, int row) const;
     XYPoint spanningCoord2XYPointMoos(int col, int row) const;
 
     XYPolygon getSearchRegion() const { return m_searchRegion; }
 
+    // Read from the rasterized mask of the converted grids, points by the region cell they fall in
+    bool isRegionCellFree(int col, int row) const { return m_regionMask.isFree(col, row); }
+    bool isInSearchRegion(double x, double y) const;
+    bool isInIgnoredRegion(double x, double y) const;
+
 private:
     XYPolygon m_searchRegion;                   // The search area polygon
     double m_sensorRadius;                      // Sensor coverage radius
-    std::vector<XYPolygon> m_ignoredRegions;    // Ignored regions within the search area
+    std::map<std::string, XYPolygon> m_ignoredRegions; // Ignored regions within the search area, by name
+    RegionMask m_regionMask;                    // Search and ignored regions burnt into the region grid
     std::vector<XYPoint> m_vehiclePositions;    // Vehicle positions as XYPoint
     XYSquare m_boundingBox;                     // Bounding box of the search region
     Mat m_regionGrid;                           // Full resolution grid (1 = free, 0 = occupied)
@@ -69,12 +83,14 @@ private:
     int m_regionWidth, m_regionHeight;          // Dimensions of region grid
     int m_spanningWidth, m_spanningHeight;      // Dimensions of downsampled spannnign grid
     bool m_gridsConverted;                      // Flag to check if grids have been converted
+    unsigned int m_gridsVersion;                // Incremented on every conversion or cell update
 
     // Private helper methods
     void convert2MatGrids();
     XYSquare getBoundingBox() const;
     void populateRegionGrid();
     void createSpanningGrid();
+    void refreshCells(const RegionMask::CellRange &range); // Region and spanning cells from the mask
 };
 
 #endif // TMSTC_GRID_CONVERTER_H